@@ -0,0 +1,63 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <random>
+
+#include "BenchCommon.h"
+
+std::vector<unsigned long>
+accessPositions(AccessPattern pattern, unsigned long count, unsigned long range,
+                unsigned long seed, unsigned long step) {
+    std::mt19937_64 generator(seed);
+    unsigned long slots = range / step;
+    std::vector<unsigned long> result;
+    result.reserve(count);
+    unsigned long centre = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long slot;
+        if (pattern == SEQUENTIAL) {
+            slot = i % slots;
+        } else if (pattern == CLUSTERED) {
+            if (i % CLUSTER_RUN == 0) {
+                centre = generator() % slots;
+            }
+            unsigned long width = std::min(CLUSTER_WIDTH, slots);
+            slot = (centre + generator() % width) % slots;
+        } else {
+            slot = generator() % slots;
+        }
+        result.push_back(slot * step);
+    }
+    return result;
+}
+
+std::vector<std::pair<unsigned long, unsigned long>>
+accessCells(AccessPattern pattern, unsigned long count, unsigned long size, unsigned long seed) {
+    std::mt19937_64 generator(seed);
+    std::vector<std::pair<unsigned long, unsigned long>> result;
+    result.reserve(count);
+    unsigned long row = 0, column = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        if (pattern == SEQUENTIAL) {
+            result.emplace_back((i / size) % size, i % size);
+        } else if (pattern == CLUSTERED) {
+            if (i % CLUSTER_RUN == 0) {
+                row = generator() % size;
+                column = generator() % size;
+            }
+            unsigned long width = std::min(CLUSTER_WIDTH, size);
+            result.emplace_back((row + generator() % width) % size, (column + generator() % width) % size);
+        } else {
+            result.emplace_back(generator() % size, generator() % size);
+        }
+    }
+    return result;
+}
+
+void setThroughput(benchmark::State &state, unsigned long perIteration) {
+    state.SetItemsProcessed(state.iterations() * perIteration);
+    state.counters["latency"] = benchmark::Counter(
+            (double) perIteration, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
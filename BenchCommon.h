@@ -0,0 +1,61 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_BENCH_COMMON_H
+#define DK2TREE_BENCH_COMMON_H
+
+#include <utility>
+#include <vector>
+#include "benchmark/benchmark.h"
+
+/// The order in which a benchmark visits positions of a structure
+enum AccessPattern {
+    RANDOM = 0, // uniformly random positions
+    CLUSTERED = 1, // runs of positions close to a random centre
+    SEQUENTIAL = 2 // positions in increasing order, wrapping around at the end
+};
+
+inline constexpr const char *ACCESS_PATTERN_NAMES[] = {"random", "clustered", "sequential"};
+
+/// The number of consecutive positions that share one centre in the CLUSTERED pattern
+inline constexpr unsigned long CLUSTER_RUN = 64;
+
+/// The width of the window around the centre in the CLUSTERED pattern
+inline constexpr unsigned long CLUSTER_WIDTH = 256;
+
+/// The number of operations done per timed batch, for benchmarks of operations
+/// that have to be undone outside of the timed region
+inline constexpr unsigned long BATCH = 1024;
+
+/**
+ * Generates `count` positions in [0, range) in the given pattern. The same
+ * seed always gives the same positions, so runs can be compared
+ *
+ * @param pattern the pattern of the positions
+ * @param count the number of positions to generate
+ * @param range one more than the highest position that may be generated
+ * @param seed the seed of the random generator
+ * @param step the distance between consecutive SEQUENTIAL positions, and the
+ *        alignment of all positions
+ * @return a list of `count` positions
+ */
+std::vector<unsigned long>
+accessPositions(AccessPattern pattern, unsigned long count, unsigned long range,
+                unsigned long seed = 1, unsigned long step = 1);
+
+/**
+ * Generates `count` (row, column) pairs in a `size` by `size` matrix, in the
+ * given pattern. SEQUENTIAL pairs walk along the rows, CLUSTERED pairs stay
+ * within a window of CLUSTER_WIDTH by CLUSTER_WIDTH for CLUSTER_RUN pairs
+ */
+std::vector<std::pair<unsigned long, unsigned long>>
+accessCells(AccessPattern pattern, unsigned long count, unsigned long size, unsigned long seed = 1);
+
+/**
+ * Reports the throughput (items per second) and the average latency of a single
+ * operation, for benchmarks that do `perIteration` operations per iteration
+ */
+void setThroughput(benchmark::State &state, unsigned long perIteration);
+
+#endif // DK2TREE_BENCH_COMMON_H
@@ -9,7 +9,8 @@
 #include <cstdint>
 #include <cassert>
 #include <cstdio>
-#include "parameters.cpp"
+#include "parameters.h"
+#include "HotPathCounters.h"
 
 using std::vector;
 
@@ -20,7 +21,7 @@ typedef uint8_t u8;
 
 // This static table contains the number of 1-bits in each 8-bit integer
 // It is used to allow very fast computation of one counts in larger integers
-static const u8 ONE_BITS[256] = {
+inline constexpr u8 ONE_BITS[256] = {
         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
         1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
         1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
@@ -41,7 +42,7 @@ static const u8 ONE_BITS[256] = {
 
 // Efficiently counts the number of 1-bits in a 64-bit integer using the table
 // defined above.
-u64 ones(u64 n) {
+constexpr u64 ones(u64 n) {
     return ONE_BITS[n & 0xFF]
            + ONE_BITS[(n >> 8) & 0xFF]
            + ONE_BITS[(n >> 16) & 0xFF]
@@ -82,6 +83,28 @@ struct BitVector {
         return (data[idx] & mask) != 0;
     }
 
+    /**
+     * Gives the values of `count` consecutive bits, which is cheaper than reading them one by one
+     * @param lo an index with lo + count <= bv.size()
+     * @param count the number of bits to read, with 0 < count <= 64
+     * @return a word in which bit i is the value of bit lo + i of the bitvector
+     */
+    u64 get(unsigned long lo, unsigned long count) const {
+        u64 idx = lo / 64, shift = lo % 64;
+        // the bits are stored from the most significant bit down, so first
+        // gather them at the top of a word
+        u64 raw = data[idx] << shift;
+        if (shift + count > 64) {
+            raw |= data[idx + 1] >> (64 - shift);
+        }
+        raw &= ~(u64) 0 << (64 - count);
+        u64 result = 0;
+        for (; raw != 0; raw &= raw - 1) {
+            result |= (u64) 1 << (63 - __builtin_ctzll(raw));
+        }
+        return result;
+    }
+
     /**
      * Sets the n-th bit to value b, and returns true if the value changed
      * @param n an index with 0 <= n < size()
@@ -140,6 +163,7 @@ struct BitVector {
      * @param size the number of bits to be inserted
      */
     void insert(unsigned long begin, unsigned long size) {
+        HOT_PATH_COUNT(bitsShifted, bits - begin);
         u64 block_start = begin / 64;
         u64 block_amount = size / 64;
         u64 bit_amount = size % 64;
@@ -216,6 +240,7 @@ struct BitVector {
      * @param hi the end of the range of bits to be deleted. Should satisfy lo <= hi <= size()
      */
     void erase(unsigned long lo, unsigned long hi) {
+        HOT_PATH_COUNT(bitsShifted, bits - hi);
         u64 amount = hi - lo;
         u64 block_start = lo / 64;
         u64 block_amount = amount / 64;
@@ -290,10 +315,9 @@ struct BitVector {
     }
 
     unsigned long memoryUsage() {
-        // For each 64-bit block, we store a 64-bit integer (containing those
-        // bits), and an 8-bit integer storing the number of one-bits
-        // So 72 bits = 9 bytes for each block
-        return ((bits + 63) / 64) * 9;
+        // The arrays have a fixed LENGTH, so the unused 64-bit blocks (and
+        // their one counts) take up memory as well
+        return sizeof(BitVector<LENGTH>);
     }
 
 
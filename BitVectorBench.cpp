@@ -0,0 +1,77 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <random>
+#include "BitVector.h"
+#include "BenchCommon.h"
+
+/**
+ * Creates a bit vector of the given size in which about half of the bits are set
+ */
+static BitVector<> randomBitVector(unsigned long size, unsigned long seed) {
+    std::mt19937_64 generator(seed);
+    BitVector<> bv(size);
+    for (unsigned long i = 0; i < size; i++) {
+        bv.set(i, (generator() & 1) != 0);
+    }
+    return bv;
+}
+
+static void BM_BitVectorRank1(benchmark::State &state) {
+    auto pattern = (AccessPattern) state.range(0);
+    auto bv = randomBitVector(B, 1);
+    auto positions = accessPositions(pattern, BATCH, B + 1);
+    unsigned long i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bv.rank1(positions[i++ % BATCH]));
+    }
+    setThroughput(state, 1);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+}
+
+// Inserting into one bit vector again and again would overflow it, so every
+// batch inserts one block into each of BATCH different bit vectors, which are
+// restored outside of the timed region
+static void BM_BitVectorInsert(benchmark::State &state) {
+    auto pattern = (AccessPattern) state.range(0);
+    const unsigned long size = (leafSizeMax / 2) * BLOCK_SIZE;
+    vector<BitVector<>> bvs(BATCH, randomBitVector(size, 1));
+    auto positions = accessPositions(pattern, BATCH, size + 1, 2, BLOCK_SIZE);
+    for (auto _ : state) {
+        for (unsigned long i = 0; i < BATCH; i++) {
+            bvs[i].insert(positions[i], BLOCK_SIZE);
+        }
+        state.PauseTiming();
+        for (unsigned long i = 0; i < BATCH; i++) {
+            bvs[i].erase(positions[i], positions[i] + BLOCK_SIZE);
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, BATCH);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+}
+
+static void BM_BitVectorErase(benchmark::State &state) {
+    auto pattern = (AccessPattern) state.range(0);
+    const unsigned long size = (leafSizeMax / 2) * BLOCK_SIZE;
+    vector<BitVector<>> bvs(BATCH, randomBitVector(size, 1));
+    auto positions = accessPositions(pattern, BATCH, size, 2, BLOCK_SIZE);
+    for (auto _ : state) {
+        for (unsigned long i = 0; i < BATCH; i++) {
+            bvs[i].erase(positions[i], positions[i] + BLOCK_SIZE);
+        }
+        state.PauseTiming();
+        for (unsigned long i = 0; i < BATCH; i++) {
+            bvs[i].insert(positions[i], BLOCK_SIZE);
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, BATCH);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+}
+
+BENCHMARK(BM_BitVectorRank1)->DenseRange(RANDOM, SEQUENTIAL);
+BENCHMARK(BM_BitVectorInsert)->DenseRange(RANDOM, SEQUENTIAL);
+BENCHMARK(BM_BitVectorErase)->DenseRange(RANDOM, SEQUENTIAL);
+
@@ -109,6 +109,16 @@ TEST(BitVectorTest, Patterns) {
             EXPECT_EQ(bv[i], ((i + 1) % k == 0));
             EXPECT_EQ(bv.rank1(i), i / k);
         }
+        // reading a range of bits at once gives the same bits, also across words
+        for (unsigned long lo = 0; lo + 64 <= size; lo += 13) {
+            for (unsigned long count : {1ul, 4ul, 16ul, 64ul}) {
+                u64 expected = 0;
+                for (unsigned long i = 0; i < count; i++) {
+                    expected |= (u64) bv[lo + i] << i;
+                }
+                EXPECT_EQ(expected, bv.get(lo, count));
+            }
+        }
 
         ASSERT_TRUE(validate(bv));
     }
@@ -0,0 +1,353 @@
+//
+// Created by agent on 19-10-26.
+//
+
+
+#include <cstring>
+#include "CodeSequence.h"
+
+/**
+ * Writes the LEB128 encoding of `code` to `out`
+ * @return the number of bytes written
+ */
+static unsigned int encodeCode(unsigned long code, u8 *out) {
+    unsigned int length = 0;
+    while (code >= 0x80) {
+        out[length++] = (u8) (code | 0x80);
+        code >>= 7;
+    }
+    out[length++] = (u8) code;
+    return length;
+}
+
+/// Decodes the code starting at `offset`, and moves `offset` past it
+static unsigned long decodeCode(const u8 *data, unsigned long &offset) {
+    unsigned long code = 0;
+    unsigned int shift = 0;
+    u8 byte;
+    do {
+        byte = data[offset++];
+        code |= (unsigned long) (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return code;
+}
+
+/// Returns the byte offset of the code with the given index in the leaf
+static unsigned long codeOffset(const CodeLeaf *leaf, unsigned long index) {
+    unsigned long offset = 0;
+    while (index > 0) {
+        if (!(leaf->data[offset++] & 0x80)) {
+            index--;
+        }
+    }
+    return offset;
+}
+
+/// Returns the length in bytes of the code starting at `offset`
+static unsigned int codeLength(const u8 *data, unsigned long offset) {
+    unsigned int length = 1;
+    while (data[offset + length - 1] & 0x80) {
+        length++;
+    }
+    return length;
+}
+
+CodeSequence::CodeSequence() :
+        root(new CodeLeaf()) {
+    nodes.leaves = 1;
+}
+
+CodeSequence::CodeSequence(const vector<unsigned long> &codes) {
+    // Fill the leaves one by one, starting a new leaf whenever the next code does not fit
+    vector<CodeNode *> level;
+    vector<unsigned long> counts;
+    auto leaf = new CodeLeaf();
+    u8 buffer[MAX_CODE_BYTES];
+    for (unsigned long code : codes) {
+        unsigned int length = encodeCode(code, buffer);
+        if (leaf->bytes + length > CODE_LEAF_BYTES) {
+            level.push_back(leaf);
+            counts.push_back(leaf->size);
+            leaf = new CodeLeaf();
+        }
+        memcpy(leaf->data + leaf->bytes, buffer, length);
+        leaf->bytes += length;
+        leaf->size++;
+        codeBytes += length;
+    }
+    level.push_back(leaf);
+    counts.push_back(leaf->size);
+    length = codes.size();
+    nodes.leaves = level.size();
+
+    // Then build the internal levels bottom-up, until a single root is left
+    while (level.size() > 1) {
+        vector<CodeNode *> parents;
+        vector<unsigned long> parentCounts;
+        for (unsigned long i = 0; i < level.size(); i += CODE_NODE_SIZE) {
+            auto node = new CodeInternal();
+            unsigned long total = 0;
+            for (unsigned long j = i; j < level.size() && j < i + CODE_NODE_SIZE; j++) {
+                node->children[node->size] = level[j];
+                node->counts[node->size] = counts[j];
+                node->size++;
+                total += counts[j];
+            }
+            parents.push_back(node);
+            parentCounts.push_back(total);
+        }
+        nodes.internalNodes += parents.size();
+        level.swap(parents);
+        counts.swap(parentCounts);
+    }
+    root = level[0];
+}
+
+CodeSequence::~CodeSequence() {
+    deleteNode(root);
+}
+
+void CodeSequence::deleteNode(CodeNode *node) {
+    if (node->isLeaf) {
+        delete static_cast<CodeLeaf *>(node);
+        nodes.leaves--;
+    } else {
+        auto internal = static_cast<CodeInternal *>(node);
+        for (unsigned long i = 0; i < internal->size; i++) {
+            deleteNode(internal->children[i]);
+        }
+        delete internal;
+        nodes.internalNodes--;
+    }
+}
+
+unsigned long CodeSequence::count(const CodeNode *node) {
+    if (node->isLeaf) {
+        return static_cast<const CodeLeaf *>(node)->size;
+    }
+    auto internal = static_cast<const CodeInternal *>(node);
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < internal->size; i++) {
+        total += internal->counts[i];
+    }
+    return total;
+}
+
+CodeLeaf *CodeSequence::findLeaf(unsigned long &index) const {
+    CodeNode *node = root;
+    while (!node->isLeaf) {
+        auto internal = static_cast<CodeInternal *>(node);
+        unsigned long i = 0;
+        while (index >= internal->counts[i]) {
+            index -= internal->counts[i];
+            i++;
+        }
+        node = internal->children[i];
+    }
+    return static_cast<CodeLeaf *>(node);
+}
+
+unsigned long CodeSequence::get(unsigned long index) const {
+    CodeLeaf *leaf = findLeaf(index);
+    unsigned long offset = codeOffset(leaf, index);
+    return decodeCode(leaf->data, offset);
+}
+
+void CodeSequence::set(unsigned long index, unsigned long code) {
+    unsigned long leafIndex = index;
+    CodeLeaf *leaf = findLeaf(leafIndex);
+    unsigned long offset = codeOffset(leaf, leafIndex);
+    unsigned int oldLength = codeLength(leaf->data, offset);
+    u8 buffer[MAX_CODE_BYTES];
+    unsigned int newLength = encodeCode(code, buffer);
+    if (leaf->bytes + newLength - oldLength > CODE_LEAF_BYTES) {
+        // The leaf would overflow, so let insert take care of splitting it
+        erase(index);
+        insert(index, code);
+        return;
+    }
+    memmove(leaf->data + offset + newLength, leaf->data + offset + oldLength, leaf->bytes - offset - oldLength);
+    memcpy(leaf->data + offset, buffer, newLength);
+    leaf->bytes = leaf->bytes + newLength - oldLength;
+    codeBytes = codeBytes + newLength - oldLength;
+}
+
+void CodeSequence::insert(unsigned long index, unsigned long code) {
+    u8 buffer[MAX_CODE_BYTES];
+    unsigned int codeLength = encodeCode(code, buffer);
+    CodeNode *right = insert(root, index, buffer, codeLength);
+    if (right != nullptr) {
+        // The root was split, so the tree grows one level
+        auto newRoot = new CodeInternal();
+        newRoot->size = 2;
+        newRoot->children[0] = root;
+        newRoot->children[1] = right;
+        newRoot->counts[1] = count(right);
+        newRoot->counts[0] = length + 1 - newRoot->counts[1];
+        root = newRoot;
+        nodes.internalNodes++;
+    }
+    length++;
+    codeBytes += codeLength;
+}
+
+CodeNode *CodeSequence::insert(CodeNode *node, unsigned long index, const u8 *code, unsigned int codeLength) {
+    if (node->isLeaf) {
+        auto leaf = static_cast<CodeLeaf *>(node);
+        unsigned long offset = codeOffset(leaf, index);
+        memmove(leaf->data + offset + codeLength, leaf->data + offset, leaf->bytes - offset);
+        memcpy(leaf->data + offset, code, codeLength);
+        leaf->bytes += codeLength;
+        leaf->size++;
+        return leaf->bytes > CODE_LEAF_BYTES ? splitLeaf(leaf) : nullptr;
+    }
+    auto internal = static_cast<CodeInternal *>(node);
+    // An index on the boundary of two children goes to the start of the right
+    // one, only the end of the sequence goes to the end of the last child
+    unsigned long i = 0;
+    while (i + 1 < internal->size && index >= internal->counts[i]) {
+        index -= internal->counts[i];
+        i++;
+    }
+    internal->counts[i]++;
+    CodeNode *right = insert(internal->children[i], index, code, codeLength);
+    if (right == nullptr) {
+        return nullptr;
+    }
+    for (unsigned long j = internal->size; j > i + 1; j--) {
+        internal->children[j] = internal->children[j - 1];
+        internal->counts[j] = internal->counts[j - 1];
+    }
+    internal->children[i + 1] = right;
+    internal->counts[i + 1] = count(right);
+    internal->counts[i] -= internal->counts[i + 1];
+    internal->size++;
+    return internal->size > CODE_NODE_SIZE ? splitInternal(internal) : nullptr;
+}
+
+CodeLeaf *CodeSequence::splitLeaf(CodeLeaf *leaf) {
+    // Split at the first code boundary in the second half of the bytes
+    unsigned long offset = 0, codes = 0;
+    while (offset < leaf->bytes / 2) {
+        offset += codeLength(leaf->data, offset);
+        codes++;
+    }
+    auto right = new CodeLeaf();
+    right->bytes = leaf->bytes - offset;
+    right->size = leaf->size - codes;
+    memcpy(right->data, leaf->data + offset, right->bytes);
+    leaf->bytes = offset;
+    leaf->size = codes;
+    nodes.leaves++;
+    return right;
+}
+
+CodeInternal *CodeSequence::splitInternal(CodeInternal *node) {
+    unsigned long half = node->size / 2;
+    auto right = new CodeInternal();
+    for (unsigned long i = half; i < node->size; i++) {
+        right->children[right->size] = node->children[i];
+        right->counts[right->size] = node->counts[i];
+        right->size++;
+    }
+    node->size = half;
+    nodes.internalNodes++;
+    return right;
+}
+
+void CodeSequence::erase(unsigned long index) {
+    unsigned long leafIndex = index;
+    CodeLeaf *leaf = findLeaf(leafIndex);
+    codeBytes -= codeLength(leaf->data, codeOffset(leaf, leafIndex));
+
+    erase(root, index);
+    length--;
+    // Remove internal roots with a single child
+    while (!root->isLeaf && static_cast<CodeInternal *>(root)->size <= 1) {
+        auto internal = static_cast<CodeInternal *>(root);
+        if (internal->size == 0) {
+            root = new CodeLeaf();
+            nodes.leaves++;
+        } else {
+            root = internal->children[0];
+        }
+        delete internal;
+        nodes.internalNodes--;
+    }
+}
+
+void CodeSequence::erase(CodeNode *node, unsigned long index) {
+    if (node->isLeaf) {
+        auto leaf = static_cast<CodeLeaf *>(node);
+        unsigned long offset = codeOffset(leaf, index);
+        unsigned int removed = codeLength(leaf->data, offset);
+        memmove(leaf->data + offset, leaf->data + offset + removed, leaf->bytes - offset - removed);
+        leaf->bytes -= removed;
+        leaf->size--;
+        return;
+    }
+    auto internal = static_cast<CodeInternal *>(node);
+    unsigned long i = 0;
+    while (index >= internal->counts[i]) {
+        index -= internal->counts[i];
+        i++;
+    }
+    internal->counts[i]--;
+    erase(internal->children[i], index);
+    rebalance(internal, i);
+}
+
+void CodeSequence::rebalance(CodeInternal *node, unsigned long index) {
+    CodeNode *child = node->children[index];
+    if (node->counts[index] == 0) {
+        deleteNode(child);
+        for (unsigned long j = index; j + 1 < node->size; j++) {
+            node->children[j] = node->children[j + 1];
+            node->counts[j] = node->counts[j + 1];
+        }
+        node->size--;
+        return;
+    }
+    if (node->size < 2) {
+        return;
+    }
+    // Merge the child with its right neighbour, or its left neighbour if it is the last child
+    unsigned long left = index + 1 < node->size ? index : index - 1;
+    CodeNode *leftNode = node->children[left], *rightNode = node->children[left + 1];
+    if (child->isLeaf) {
+        auto a = static_cast<CodeLeaf *>(leftNode), b = static_cast<CodeLeaf *>(rightNode);
+        if (static_cast<CodeLeaf *>(child)->bytes >= CODE_LEAF_BYTES / 4 || a->bytes + b->bytes > CODE_LEAF_BYTES) {
+            return;
+        }
+        memcpy(a->data + a->bytes, b->data, b->bytes);
+        a->bytes += b->bytes;
+        a->size += b->size;
+        delete b;
+        nodes.leaves--;
+    } else {
+        auto a = static_cast<CodeInternal *>(leftNode), b = static_cast<CodeInternal *>(rightNode);
+        if (static_cast<CodeInternal *>(child)->size >= CODE_NODE_SIZE / 4 || a->size + b->size > CODE_NODE_SIZE) {
+            return;
+        }
+        for (unsigned long j = 0; j < b->size; j++) {
+            a->children[a->size] = b->children[j];
+            a->counts[a->size] = b->counts[j];
+            a->size++;
+        }
+        delete b;
+        nodes.internalNodes--;
+    }
+    node->counts[left] += node->counts[left + 1];
+    for (unsigned long j = left + 1; j + 1 < node->size; j++) {
+        node->children[j] = node->children[j + 1];
+        node->counts[j] = node->counts[j + 1];
+    }
+    node->size--;
+}
+
+unsigned long CodeSequence::memoryUsage() const {
+    return sizeof(CodeSequence)
+           + nodes.leaves * allocationSize(sizeof(CodeLeaf))
+           + nodes.internalNodes * allocationSize(sizeof(CodeInternal));
+}
@@ -0,0 +1,158 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_CODE_SEQUENCE_H
+#define DK2TREE_CODE_SEQUENCE_H
+
+#include "BitVector.h"
+#include "MemoryStats.h"
+
+/// The maximum number of bytes of codes in a leaf of a CodeSequence
+static const unsigned int CODE_LEAF_BYTES = 128;
+
+/// The maximum number of children of an internal node of a CodeSequence
+static const unsigned int CODE_NODE_SIZE = 16;
+
+/// The maximum length of one code, a 64-bit integer takes at most 10 bytes of 7 bits
+static const unsigned int MAX_CODE_BYTES = 10;
+
+/// The common part of the leaves and internal nodes of a CodeSequence
+struct CodeNode {
+    bool isLeaf;
+
+    explicit CodeNode(bool isLeaf) :
+            isLeaf(isLeaf) {}
+};
+
+/**
+ * A leaf of a CodeSequence, containing the codes as LEB128 varints: 7 bits per
+ * byte, where the highest bit of a byte is set if the code continues in the
+ * next byte. There is room for one code more than the maximum, so that leaves
+ * can be split after insertion instead of before
+ */
+struct CodeLeaf : CodeNode {
+    unsigned int bytes = 0; // the number of bytes of `data` in use
+    unsigned int size = 0; // the number of codes in this leaf
+    u8 data[CODE_LEAF_BYTES + MAX_CODE_BYTES];
+
+    CodeLeaf() :
+            CodeNode(true) {}
+};
+
+/**
+ * An internal node of a CodeSequence, with for every child the number of codes
+ * in its subtree. Like the leaves, this has room for one child more than the maximum
+ */
+struct CodeInternal : CodeNode {
+    unsigned int size = 0; // the number of children
+    unsigned long counts[CODE_NODE_SIZE + 1];
+    CodeNode *children[CODE_NODE_SIZE + 1];
+
+    CodeInternal() :
+            CodeNode(false) {}
+};
+
+/**
+ * A dynamic sequence of non-negative integer codes, stored with a variable
+ * length in the leaves of a B+tree. Small codes take a single byte, so storing
+ * codes of a frequency sorted vocabulary takes much less memory than storing the
+ * values they stand for. Accessing, setting, inserting and erasing a code at a
+ * given index all take O(log n) time, plus a scan through one leaf, which
+ * decodes the codes in place
+ */
+class CodeSequence {
+    CodeNode *root;
+    unsigned long length = 0; // the number of codes
+    unsigned long codeBytes = 0; // the number of bytes used by all codes
+    NodeCounts nodes; // the number of leaves and internal nodes
+
+public:
+    CodeSequence();
+
+    /**
+     * Builds a sequence containing the given codes, with every leaf and internal
+     * node filled up as far as possible
+     */
+    explicit CodeSequence(const vector<unsigned long> &codes);
+
+    CodeSequence(const CodeSequence &) = delete;
+
+    ~CodeSequence();
+
+    /// Returns the number of codes in this sequence
+    unsigned long size() const {
+        return length;
+    }
+
+    /// Returns the number of bytes used to store the codes themselves
+    unsigned long bytes() const {
+        return codeBytes;
+    }
+
+    /// Returns the number of leaves and internal nodes
+    NodeCounts nodeCounts() const {
+        return nodes;
+    }
+
+    /**
+     * Returns the code at the given index
+     * @param index an index with 0 <= index < size()
+     */
+    unsigned long get(unsigned long index) const;
+
+    /**
+     * Replaces the code at the given index
+     * @param index an index with 0 <= index < size()
+     */
+    void set(unsigned long index, unsigned long code);
+
+    /**
+     * Inserts a code before the given index
+     * @param index an index with 0 <= index <= size()
+     */
+    void insert(unsigned long index, unsigned long code);
+
+    /**
+     * Removes the code at the given index
+     * @param index an index with 0 <= index < size()
+     */
+    void erase(unsigned long index);
+
+    /**
+     * Returns the memory used by this sequence in bytes, including the estimated
+     * allocator overhead of its nodes, in constant time
+     */
+    unsigned long memoryUsage() const;
+
+private:
+    /// Finds the leaf containing the code at `index`, and changes `index` into the index in that leaf
+    CodeLeaf *findLeaf(unsigned long &index) const;
+
+    /// Returns the number of codes in the subtree of the given node
+    static unsigned long count(const CodeNode *node);
+
+    /// Deletes the given node and all of its descendants
+    void deleteNode(CodeNode *node);
+
+    /**
+     * Inserts the encoded code into the subtree of `node`
+     * @return the new right sibling of `node` if it had to be split, nullptr otherwise
+     */
+    CodeNode *insert(CodeNode *node, unsigned long index, const u8 *code, unsigned int codeLength);
+
+    /// Erases the code at the given index from the subtree of `node`
+    void erase(CodeNode *node, unsigned long index);
+
+    CodeLeaf *splitLeaf(CodeLeaf *leaf);
+
+    CodeInternal *splitInternal(CodeInternal *node);
+
+    /**
+     * Removes the child at `index` if it is empty, or merges it with a sibling if
+     * it is small and the two fit in one node
+     */
+    void rebalance(CodeInternal *node, unsigned long index);
+};
+
+#endif // DK2TREE_CODE_SEQUENCE_H
@@ -0,0 +1,99 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef CODE_SEQUENCE_TEST
+#define CODE_SEQUENCE_TEST
+
+#include <random>
+#include "DKTree.h"
+#include "gtest/gtest.h"
+
+static void expectSameCodes(const vector<unsigned long> &expected, const CodeSequence &sequence) {
+    ASSERT_EQ(expected.size(), sequence.size());
+    for (unsigned long i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], sequence.get(i));
+    }
+}
+
+TEST(CodeSequenceTest, RandomOperations) {
+    std::mt19937_64 random(11);
+    // Mostly small codes, with now and then a code of several bytes
+    auto randomCode = [&random]() {
+        return random() % 8 == 0 ? random() >> (random() % 64) : random() % 100;
+    };
+    CodeSequence sequence;
+    vector<unsigned long> expected;
+    for (unsigned long round = 0; round < 20000; round++) {
+        unsigned long operation = random() % 10;
+        if (operation < 5 || expected.empty()) {
+            unsigned long index = random() % (expected.size() + 1), code = randomCode();
+            expected.insert(expected.begin() + index, code);
+            sequence.insert(index, code);
+        } else if (operation < 8) {
+            unsigned long index = random() % expected.size(), code = randomCode();
+            expected[index] = code;
+            sequence.set(index, code);
+        } else {
+            unsigned long index = random() % expected.size();
+            expected.erase(expected.begin() + index);
+            sequence.erase(index);
+        }
+    }
+    expectSameCodes(expected, sequence);
+    ASSERT_LT(1, sequence.nodeCounts().internalNodes);
+
+    while (!expected.empty()) {
+        unsigned long index = random() % expected.size();
+        expected.erase(expected.begin() + index);
+        sequence.erase(index);
+    }
+    expectSameCodes(expected, sequence);
+    ASSERT_EQ(0, sequence.bytes());
+    ASSERT_EQ(1, sequence.nodeCounts().leaves);
+    ASSERT_EQ(0, sequence.nodeCounts().internalNodes);
+}
+
+TEST(CodeSequenceTest, BulkBuild) {
+    vector<unsigned long> codes;
+    unsigned long bytes = 0;
+    for (unsigned long i = 0; i < 50000; i++) {
+        codes.push_back(i % 300);
+        bytes += i % 300 < 128 ? 1 : 2;
+    }
+    CodeSequence sequence(codes);
+    expectSameCodes(codes, sequence);
+    ASSERT_EQ(bytes, sequence.bytes());
+    // Full leaves, so only little more memory than the codes themselves
+    ASSERT_LT(sequence.memoryUsage(), bytes * 3 / 2);
+
+    sequence.insert(0, 1ul << 63);
+    sequence.insert(codes.size() + 1, 5);
+    ASSERT_EQ(1ul << 63, sequence.get(0));
+    ASSERT_EQ(codes[1234], sequence.get(1235));
+    ASSERT_EQ(5, sequence.get(codes.size() + 1));
+}
+
+TEST(LeafVocabularyTest, ReferenceCounts) {
+    LeafVocabulary vocabulary;
+    ASSERT_EQ(0, vocabulary.acquire(0xff));
+    ASSERT_EQ(1, vocabulary.acquire(0x1));
+    ASSERT_EQ(0, vocabulary.acquire(0xff));
+    ASSERT_EQ(2, vocabulary.size());
+    vocabulary.release(0);
+    ASSERT_EQ(0xff, vocabulary.pattern(0));
+    vocabulary.release(0);
+    ASSERT_EQ(1, vocabulary.size());
+    // The freed code is handed out again
+    ASSERT_EQ(0, vocabulary.acquire(0x2));
+    ASSERT_EQ(1, vocabulary.acquire(0x1));
+
+    vector<unsigned long> codes = vocabulary.assignByFrequency({0x3, 0x5, 0x5, 0x7, 0x5, 0x7});
+    ASSERT_EQ((vector<unsigned long>{2, 0, 0, 1, 0, 1}), codes);
+    ASSERT_EQ(0x5, vocabulary.pattern(0));
+    ASSERT_EQ(3, vocabulary.size());
+    ASSERT_EQ(0, vocabulary.acquire(0x5));
+    ASSERT_EQ(3, vocabulary.acquire(0x9));
+}
+
+#endif // CODE_SEQUENCE_TEST
@@ -4,36 +4,444 @@
 
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #include "DKTree.h"
 
 using namespace std;
 
-unsigned long long_pow(unsigned long a, unsigned long b) {
-    unsigned long result = 1;
-    while (b != 0) {
-        if (b % 2 != 0) {
-            result *= a;
+DKTree::DKTree() : DKTree(4ul) {}
+
+// the levels of a matrix of size k^power, in vocabulary mode the last levels are replaced by one of arity VOCABULARY_K
+static LevelTable powerLevels(unsigned long power, bool vocabulary) {
+    vector<unsigned long> arities(power, k);
+    if (vocabulary) {
+        for (unsigned long size = k; size < VOCABULARY_K && arities.size() > 1; size *= k) {
+            arities.pop_back();
+        }
+        arities.back() = VOCABULARY_K;
+    }
+    return LevelTable(arities);
+}
+
+DKTree::DKTree(unsigned long power, bool vocabulary) : DKTree(powerLevels(power, vocabulary), vocabulary) {}
+
+DKTree::DKTree(const LevelTable &levels, bool vocabulary) : ttree(new TTree()), ltree(new LTree()), freeColumns(),
+                                                            firstFreeColumn(0), matrixSize(levels.matrixSize()),
+                                                            levels(levels), levelBlocks(levels.height() - 1) {
+    insertBlockTtree(0, 1);
+    countNodes();
+    if (vocabulary) {
+        initVocabulary(new LeafVocabulary(), new CodeSequence());
+    }
+}
+
+DKTree::DKTree(TTree *ttree, LTree *ltree, const LevelTable &levels, const vector<unsigned long> &levelBlocks,
+               LeafVocabulary *vocabulary, CodeSequence *leafCodes)
+        : ttree(ttree), ltree(ltree), freeColumns(), firstFreeColumn(0), matrixSize(levels.matrixSize()),
+          levels(levels), levelBlocks(levelBlocks) {
+    updateLevelStarts();
+    countNodes();
+    if (vocabulary != nullptr) {
+        initVocabulary(vocabulary, leafCodes);
+    }
+}
+
+void DKTree::initVocabulary(LeafVocabulary *aVocabulary, CodeSequence *aLeafCodes) {
+    vocabulary = aVocabulary;
+    leafCodes = aLeafCodes;
+    // The leaves are VOCABULARY_K by VOCABULARY_K patterns, below the root block in the ttree
+    if (levels.arity(levels.height()) != VOCABULARY_K || levels.height() < 2) {
+        delete ttree;
+        delete ltree;
+        delete vocabulary;
+        delete leafCodes;
+        std::stringstream error;
+        error << "DKTree: matrix of size " << matrixSize << " not suitable for vocabulary mode\n";
+        throw std::invalid_argument(error.str());
+    }
+}
+
+void DKTree::updateLevelStarts() {
+    unsigned long height = levels.height();
+    levelStarts.assign(height + 1, 0);
+    blocksAbove.assign(height + 1, 0);
+    for (unsigned long iteration = 1; iteration < height; iteration++) {
+        levelStarts[iteration + 1] = levelStarts[iteration] + levelBlocks[iteration - 1] * levels.blockSize(iteration);
+        blocksAbove[iteration + 1] = blocksAbove[iteration] + levelBlocks[iteration - 1];
+    }
+}
+
+unsigned long DKTree::childPosition(unsigned long position, unsigned long iteration, vector<Nesbo> *path) const {
+    // position +1 since paper has rank including the position, but function is exclusive position
+    unsigned long onesInLevel = ttree->rank1(position + 1, path) - (blocksAbove[iteration + 1] - 1);
+    return levelStarts[iteration + 1] + (onesInLevel - 1) * levels.blockSize(iteration + 1);
+}
+
+template<typename Tree>
+static void countTreeNodes(Tree *tree, NodeCounts &counts) {
+    if (tree->isLeaf) {
+        counts.leaves++;
+    } else {
+        counts.internalNodes++;
+        for (unsigned long i = 0; i < tree->node.internalNode->size; i++) {
+            countTreeNodes(tree->node.internalNode->entries[i].P, counts);
+        }
+    }
+}
+
+void DKTree::countNodes() {
+    tNodes = NodeCounts();
+    lNodes = NodeCounts();
+    countTreeNodes(ttree, tNodes);
+    countTreeNodes(ltree, lNodes);
+}
+
+// splits blocks of the given number of bits into blocks of BLOCK_SIZE bits, as used by the TTree and LTree
+static void appendBaseBlocks(vector<u64> &baseBlocks, const vector<u64> &blocks, unsigned long blockSize) {
+    for (u64 block : blocks) {
+        for (unsigned long i = 0; i < blockSize; i += BLOCK_SIZE) {
+            baseBlocks.push_back((block >> i) & ((1ull << BLOCK_SIZE) - 1));
+        }
+    }
+}
+
+DKTree *DKTree::fromEdges(unsigned long size, const vector<std::pair<unsigned long, unsigned long>> &edges,
+                          bool vocabulary, Arities shape) {
+    if (vocabulary) {
+        shape.leaf = VOCABULARY_K;
+    }
+    LevelTable levels = LevelTable::forSize(size, shape);
+    unsigned long height = levels.height();
+    // Every level contributes log2(k^2) bits of that level to the key of an edge
+    unsigned long keyBits = 0;
+    for (unsigned long iteration = 1; iteration <= height; iteration++) {
+        keyBits += levels.offsetBits(iteration);
+    }
+    if (keyBits > 64) {
+        throw std::invalid_argument("fromEdges: matrix too large for bulk loading\n");
+    }
+
+    // The key of an edge is the concatenation of its offsets in every level,
+    // so sorting by key gives the order in which the edges appear in the leaves
+    vector<u64> keys;
+    keys.reserve(edges.size());
+    for (auto &edge : edges) {
+        if (edge.first >= size || edge.second >= size) {
+            std::stringstream error;
+            error << "fromEdges: invalid edge (" << edge.first << ", " << edge.second
+                  << "), the graph has " << size << " vertices\n";
+            throw std::invalid_argument(error.str());
+        }
+        u64 key = 0;
+        for (unsigned long iteration = 1; iteration <= height; iteration++) {
+            unsigned long arity = levels.arity(iteration), partitionSize = levels.partitionSize(iteration);
+            unsigned long offset = arity * ((edge.first / partitionSize) % arity) + (edge.second / partitionSize) % arity;
+            key = (key << levels.offsetBits(iteration)) | offset;
+        }
+        keys.push_back(key);
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+    // Each block of a level belongs to one distinct key prefix of the levels
+    // above it, and the blocks of a level appear in the order of these prefixes
+    vector<vector<u64>> levelPatterns(height);
+    unsigned long shift = keyBits;
+    for (unsigned long iteration = 1; iteration <= height; iteration++) {
+        unsigned long levelBits = levels.offsetBits(iteration);
+        shift -= levelBits;
+        vector<u64> &blocks = levelPatterns[iteration - 1];
+        if (iteration == 1) {
+            blocks.push_back(0);
+        }
+        bool first = true;
+        u64 lastPrefix = 0;
+        for (u64 key : keys) {
+            u64 prefix = shift + levelBits >= 64 ? 0 : key >> (shift + levelBits);
+            if (iteration > 1 && (first || prefix != lastPrefix)) {
+                blocks.push_back(0);
+            }
+            blocks.back() |= 1ull << ((key >> shift) & ((1ull << levelBits) - 1));
+            first = false;
+            lastPrefix = prefix;
         }
-        b >>= 1;
-        a *= a;
     }
+    vector<u64>().swap(keys);
+
+    auto result = fromLevelBlocks(levels, levelPatterns, vocabulary);
+    result->firstFreeColumn = size;
     return result;
 }
 
-DKTree::DKTree() : ttree(new TTree()), ltree(new LTree()), freeColumns(), firstFreeColumn(0), matrixSize(long_pow(k, 4ul)) {
-    ttree->insertBlock(0);
+DKTree *DKTree::fromLevelBlocks(const LevelTable &levels, vector<vector<u64>> &blocks, bool vocabulary) {
+    unsigned long height = levels.height();
+    vector<u64> tBlocks, lBlocks;
+    vector<unsigned long> levelBlocks;
+    for (unsigned long iteration = 1; iteration < height; iteration++) {
+        levelBlocks.push_back(blocks[iteration - 1].size());
+        appendBaseBlocks(tBlocks, blocks[iteration - 1], levels.blockSize(iteration));
+        vector<u64>().swap(blocks[iteration - 1]);
+    }
+    vector<u64> &leaves = blocks[height - 1];
+    if (vocabulary) {
+        // In vocabulary mode every leaf block is a pattern, and the most frequent patterns get the smallest codes
+        auto leafVocabulary = new LeafVocabulary();
+        auto codes = new CodeSequence(leafVocabulary->assignByFrequency(leaves));
+        vector<u64>().swap(leaves);
+        return new DKTree(TTree::fromBlocks(tBlocks), new LTree(), levels, levelBlocks, leafVocabulary, codes);
+    }
+    appendBaseBlocks(lBlocks, leaves, levels.blockSize(height));
+    vector<u64>().swap(leaves);
+    return new DKTree(TTree::fromBlocks(tBlocks), LTree::fromBlocks(lBlocks), levels, levelBlocks);
 }
 
-DKTree::DKTree(unsigned long power) : ttree(new TTree()), ltree(new LTree()), freeColumns(), firstFreeColumn(0),
-                                      matrixSize(long_pow(k, power)) {
-    ttree->insertBlock(0);
+DKTree *DKTree::unite(const DKTree &other) const {
+    return combine(other, UNION);
 }
 
-DKTree::~DKTree() {
+DKTree *DKTree::intersect(const DKTree &other) const {
+    return combine(other, INTERSECTION);
+}
+
+DKTree *DKTree::subtract(const DKTree &other) const {
+    return combine(other, DIFFERENCE);
+}
+
+// returns whether a vertex below the first free column of a tree is present in it, free columns are sorted
+static bool isPresent(unsigned long vertex, unsigned long firstFreeColumn, const vector<unsigned long> &freeColumns) {
+    return vertex < firstFreeColumn && !binary_search(freeColumns.begin(), freeColumns.end(), vertex);
+}
+
+DKTree *DKTree::combine(const DKTree &other, SetOperation operation) const {
+    // the lower tree is extended with levels above its root, so its levels must match the lowest levels of the other
+    const DKTree &higher = levels.height() >= other.levels.height() ? *this : other;
+    const DKTree &lower = levels.height() >= other.levels.height() ? other : *this;
+    const unsigned long missingLevels = higher.levels.height() - lower.levels.height();
+    for (unsigned long iteration = 1; iteration <= lower.levels.height(); iteration++) {
+        if (lower.levels.arity(iteration) != higher.levels.arity(iteration + missingLevels)) {
+            throw std::invalid_argument("combine: the arities of the levels of the trees do not match\n");
+        }
+    }
+
+    const unsigned long height = higher.levels.height();
+    CoTraversalSide a{this, height - levels.height(), false, vector<vector<Nesbo>>(levels.height() + 1), {},
+                      vector<unsigned long>(levels.height() + 1, 0)};
+    CoTraversalSide b{&other, height - other.levels.height(), false, vector<vector<Nesbo>>(other.levels.height() + 1),
+                      {}, vector<unsigned long>(other.levels.height() + 1, 0)};
+    a.empty = readBlock(0, 1, a.tPaths, a.lPath) == 0;
+    b.empty = other.readBlock(0, 1, b.tPaths, b.lPath) == 0;
+
+    vector<vector<u64>> blocks(height);
+    combineBlocks(operation, a, 0, b, 0, 1, blocks);
+    DKTree *result = fromLevelBlocks(higher.levels, blocks, higher.usesVocabulary());
+
+    // the vertices of the result, and the deleted vertices below its first free column
+    switch (operation) {
+        case UNION:
+            result->firstFreeColumn = std::max(firstFreeColumn, other.firstFreeColumn);
+            break;
+        case INTERSECTION:
+            result->firstFreeColumn = std::min(firstFreeColumn, other.firstFreeColumn);
+            break;
+        case DIFFERENCE:
+            result->firstFreeColumn = firstFreeColumn;
+            break;
+    }
+    if (operation == DIFFERENCE) {
+        result->freeColumns = freeColumns;
+    } else {
+        for (unsigned long vertex = 0; vertex < result->firstFreeColumn; vertex++) {
+            bool inThis = isPresent(vertex, firstFreeColumn, freeColumns);
+            bool inOther = isPresent(vertex, other.firstFreeColumn, other.freeColumns);
+            if (operation == UNION ? !inThis && !inOther : !inThis || !inOther) {
+                result->freeColumns.push_back(vertex);
+            }
+        }
+    }
+    return result;
+}
+
+// swaps the row and column offset of every bit of a block of arity x arity bits
+static u64 transposeBlock(u64 block, unsigned long arity) {
+    u64 result = 0;
+    for (; block != 0; block &= block - 1) {
+        unsigned long offset = __builtin_ctzl(block);
+        result |= 1ull << ((offset % arity) * arity + offset / arity);
+    }
+    return result;
+}
+
+DKTree *DKTree::transposed() const {
+    const unsigned long height = levels.height();
+    vector<vector<u64>> result(height);
+    vector<vector<Nesbo>> tPaths(height + 1);
+    vector<LNesbo> lPath;
+    // the blocks of the current level in the order of this tree, and their order in the transposed tree
+    vector<u64> blocks;
+    vector<unsigned long> order{0}, nextOrder;
+    vector<unsigned long> firstChild;
+    unsigned long blocksInLevel = 1;
+    for (unsigned long iteration = 1; iteration <= height; iteration++) {
+        const unsigned long arity = levels.arity(iteration);
+        const unsigned long blockSize = levels.blockSize(iteration);
+        blocks.resize(blocksInLevel);
+        firstChild.resize(blocksInLevel);
+        unsigned long children = 0;
+        for (unsigned long i = 0; i < blocksInLevel; i++) {
+            blocks[i] = readBlock(levelStarts[iteration] + i * blockSize, iteration, tPaths, lPath);
+            firstChild[i] = children;
+            children += __builtin_popcountl(blocks[i]);
+        }
+        // the children of a block in the transposed tree are its children in this tree, in transposed order
+        result[iteration - 1].reserve(blocksInLevel);
+        nextOrder.clear();
+        for (unsigned long i : order) {
+            u64 block = blocks[i];
+            u64 transposedBlock = transposeBlock(block, arity);
+            result[iteration - 1].push_back(transposedBlock);
+            if (iteration == height) {
+                continue;
+            }
+            for (u64 bits = transposedBlock; bits != 0; bits &= bits - 1) {
+                unsigned long offset = __builtin_ctzl(bits);
+                unsigned long original = (offset % arity) * arity + offset / arity;
+                nextOrder.push_back(firstChild[i] + __builtin_popcountl(block & ((1ull << original) - 1)));
+            }
+        }
+        order.swap(nextOrder);
+        blocksInLevel = children;
+    }
+
+    DKTree *tree = fromLevelBlocks(levels, result, usesVocabulary());
+    tree->firstFreeColumn = firstFreeColumn;
+    tree->freeColumns = freeColumns;
+    return tree;
+}
+
+u64 DKTree::combineBlocks(SetOperation operation, CoTraversalSide &a, unsigned long positionA, CoTraversalSide &b,
+                          unsigned long positionB, unsigned long iteration, vector<vector<u64>> &result) const {
+    // the block of a side, where the levels above the root of a lower tree only have their first bit set
+    auto blockOf = [iteration](CoTraversalSide &side, unsigned long position) -> u64 {
+        if (position == NO_BLOCK) {
+            return 0;
+        }
+        if (iteration <= side.missingLevels) {
+            return side.empty ? 0 : 1;
+        }
+        return side.tree->readBlock(position, iteration - side.missingLevels, side.tPaths, side.lPath);
+    };
+    // the children of the blocks of a level are the consecutive blocks of the next level, as long as no subtree
+    // was skipped, so a rank is only needed after a skip
+    auto childOf = [iteration](CoTraversalSide &side, unsigned long position, unsigned long offset) {
+        if (iteration <= side.missingLevels) {
+            return 0ul; // a level above the root, or the root itself
+        }
+        unsigned long sideIteration = iteration - side.missingLevels;
+        unsigned long &nextChild = side.nextChild[sideIteration + 1];
+        if (nextChild == 0) {
+            nextChild = side.tree->childPosition(position + offset, sideIteration, &side.tPaths[sideIteration]);
+        }
+        unsigned long child = nextChild;
+        nextChild += side.tree->levels.blockSize(sideIteration + 1);
+        return child;
+    };
+    auto skip = [iteration](CoTraversalSide &side) {
+        if (iteration > side.missingLevels) {
+            std::fill(side.nextChild.begin() + (iteration - side.missingLevels) + 1, side.nextChild.end(), 0);
+        }
+    };
+
+    u64 blockA = blockOf(a, positionA);
+    u64 blockB = blockOf(b, positionB);
+    u64 block;
+    if (iteration == a.tree->levels.height() + a.missingLevels) {
+        // the leaf level, where the blocks are the edges themselves
+        switch (operation) {
+            case UNION:
+                block = blockA | blockB;
+                break;
+            case INTERSECTION:
+                block = blockA & blockB;
+                break;
+            default:
+                block = blockA & ~blockB;
+                break;
+        }
+    } else {
+        // the subtrees that can contain edges of the result, which can turn out to be empty for an
+        // intersection or difference
+        u64 candidates = operation == UNION ? blockA | blockB : operation == INTERSECTION ? blockA & blockB : blockA;
+        block = 0;
+        for (u64 bits = blockA | blockB; bits != 0; bits &= bits - 1) {
+            unsigned long offset = __builtin_ctzl(bits);
+            if (((candidates >> offset) & 1) == 0) {
+                skip((blockA >> offset) & 1 ? a : b);
+                continue;
+            }
+            unsigned long childA = (blockA >> offset) & 1 ? childOf(a, positionA, offset) : NO_BLOCK;
+            unsigned long childB = (blockB >> offset) & 1 ? childOf(b, positionB, offset) : NO_BLOCK;
+            if (combineBlocks(operation, a, childA, b, childB, iteration + 1, result) != 0) {
+                block |= 1ull << offset;
+            }
+        }
+    }
+    // the root block is always stored, the other blocks only if they have edges
+    if (block != 0 || iteration == 1) {
+        result[iteration - 1].push_back(block);
+    }
+    return block;
+}
+
+u64 DKTree::readBlock(unsigned long position, unsigned long iteration, vector<vector<Nesbo>> &tPaths,
+                      vector<LNesbo> &lPath) const {
+    const unsigned long blockSize = levels.blockSize(iteration);
+    if (iteration < levels.height()) {
+        return ttree->accessBits(position, blockSize, &tPaths[iteration]);
+    }
+    if (vocabulary) {
+        return vocabulary->pattern(leafCodes->get((position - ttree->bits()) / blockSize));
+    }
+    return ltree->accessBits(position - ttree->bits(), blockSize, &lPath);
+}
+
+DKTree::DKTree(const DKTree &other)
+        : ttree(other.ttree), ltree(other.ltree), freeColumns(other.freeColumns),
+          firstFreeColumn(other.firstFreeColumn), matrixSize(other.matrixSize), tNodes(other.tNodes),
+          lNodes(other.lNodes), levels(other.levels), levelBlocks(other.levelBlocks), levelStarts(other.levelStarts),
+          blocksAbove(other.blocksAbove), nodeSharers(other.nodeSharers), staleParents(true) {
+    (*nodeSharers)++;
+    ttree->references++;
+    ltree->references++;
+    if (other.vocabulary) {
+        vector<unsigned long> codes(other.leafCodes->size());
+        for (unsigned long leaf = 0; leaf < codes.size(); leaf++) {
+            codes[leaf] = other.leafCodes->get(leaf);
+        }
+        vocabulary = new LeafVocabulary(*other.vocabulary);
+        leafCodes = new CodeSequence(codes);
+    }
+}
+
+DKTree *DKTree::snapshot() {
+    // a tree that already shares nodes is only read, so several threads can take snapshots of a snapshot
+    if (!nodeSharers) {
+        nodeSharers = std::make_shared<std::atomic<unsigned long>>(1);
+    }
+    if (!staleParents) {
+        staleParents = true;
+    }
+    return new DKTree(*this);
+}
 
-    delete ttree;
-    delete ltree;
+DKTree::~DKTree() {
+    TTree::release(ttree);
+    LTree::release(ltree);
+    if (nodeSharers) {
+        nodeSharers->fetch_sub(1, std::memory_order_release);
+    }
+    delete vocabulary;
+    delete leafCodes;
 }
 
 void DKTree::addEdge(unsigned long row, unsigned long column) {
@@ -52,27 +460,34 @@ void DKTree::addEdge(unsigned long row, unsigned long column) {
     // if the last bit found in the ttree is a 1 then find the final result in the ltree and set it to 1
     if (cEntry) {
         unsigned long ltreePosition = position - ttree->bits();
-        ltree->setBit(ltreePosition, true, &lPath);
+        if (vocabulary) {
+            // the position is the leaf index times the size of a pattern, plus the bit in the pattern
+            unsigned long leafSize = levels.blockSize(iteration), leaf = ltreePosition / leafSize;
+            setLeafPattern(leaf, vocabulary->pattern(leafCodes->get(leaf)) | 1ull << (ltreePosition % leafSize));
+        } else {
+            setLtreeBit(ltreePosition, true);
+        }
     } else { // if not then change it to a 1 and insert new blocks where necessary
-        ttree->setBit(position, true, &tPath);
-        iteration++;
-        unsigned long blockSize = matrixSize / long_pow(k, iteration);
-        while (blockSize > 1) {
-            // position +1 since paper has rank including the position, but function is exclusive position
-            unsigned long insertAt = ttree->rank1(position + 1, &tPath) * BLOCK_SIZE;
-            insertBlockTtree(insertAt);
+        setTtreeBit(position, true);
+        while (iteration + 1 < levels.height()) {
+            unsigned long insertAt = childPosition(position, iteration);
+            iteration++;
+            insertBlockTtree(insertAt, iteration);
             unsigned long offset = calculateOffset(row, column, iteration);
             position = insertAt + offset;
-            ttree->setBit(position, true, &tPath);
-            iteration++;
-            blockSize = matrixSize / long_pow(k, iteration);
+            setTtreeBit(position, true);
         }
-        // position +1 since paper has rank including the position, but function is exclusive position
-        unsigned long lTreeInsertAt = (ttree->rank1(position + 1, &tPath) * BLOCK_SIZE) - ttree->bits();
-        insertBlockLtree(lTreeInsertAt);
+        unsigned long lTreeInsertAt = childPosition(position, iteration) - ttree->bits();
+        iteration++;
         unsigned long offset = calculateOffset(row, column, iteration);
+        if (vocabulary) {
+            unsigned long leaf = lTreeInsertAt / levels.blockSize(iteration);
+            leafCodes->insert(leaf, vocabulary->acquire(1ull << offset));
+            return;
+        }
+        insertBlockLtree(lTreeInsertAt);
         position = lTreeInsertAt + offset;
-        ltree->setBit(position, true, &lPath);
+        setLtreeBit(position, true);
     }
 }
 
@@ -101,24 +516,24 @@ bool DKTree::deleteThisEdge(const unsigned long row, const unsigned long column,
 bool DKTree::deleteTTreeEdge(const unsigned long row, const unsigned long column, const unsigned long iteration,
                              const unsigned long positionOfFirst, unsigned long offset) {
     // if the current position is true then check if after deleting the next edge any of its children are still true
-    unsigned long nextPositionOfFirst = (ttree->rank1(positionOfFirst + offset + 1, &tPath)) * BLOCK_SIZE;
+    unsigned long nextPositionOfFirst = childPosition(positionOfFirst + offset, iteration);
     bool newCurrentBit = deleteThisEdge(row, column, iteration + 1, nextPositionOfFirst);
     // if any of its children are still true this one will stay true and therefore so should its parent.
     if (newCurrentBit) {
         return true;
     }
-    ttree->setBit(positionOfFirst + offset, false, &tPath);
+    setTtreeBit(positionOfFirst + offset, false);
     if (iteration > 1) {
         // if we aren't in the first iteration, see if any of the nodes in this block is still true
         bool only0s = true;
-        for (unsigned long i = 0; i < BLOCK_SIZE && only0s; i++) {
+        for (unsigned long i = 0; i < levels.blockSize(iteration) && only0s; i++) {
             if (ttree->access(positionOfFirst + i, &tPath)) {
                 only0s = false;
             }
         }
         // if all nodes are false this block can be deleted
         if (only0s) {
-            deleteBlockTtree(positionOfFirst);
+            deleteBlockTtree(positionOfFirst, iteration);
         }
         return !only0s; // if all bits in this block are false the parent should be false, else it should be true.
     }
@@ -129,11 +544,18 @@ bool DKTree::deleteTTreeEdge(const unsigned long row, const unsigned long column
 bool DKTree::deleteLTreeEdge(const unsigned long positionOfFirst, unsigned long offset) {
     // if the position is in the ltree, set the bit to false in the ltree
     unsigned long lTreePositionOfFirst = positionOfFirst - ttree->bits();
+    const unsigned long blockSize = levels.blockSize(levels.height());
+    if (vocabulary) {
+        unsigned long leaf = lTreePositionOfFirst / blockSize;
+        u64 pattern = vocabulary->pattern(leafCodes->get(leaf)) & ~(1ull << offset);
+        setLeafPattern(leaf, pattern);
+        return pattern != 0;
+    }
     unsigned long lTreePosition = lTreePositionOfFirst + offset;
-    ltree->setBit(lTreePosition, false, &lPath);
+    setLtreeBit(lTreePosition, false);
     // check if there are any positive bits in this block
     bool only0s = true;
-    for (unsigned long i = 0; i < BLOCK_SIZE && only0s; i++) {
+    for (unsigned long i = 0; i < blockSize && only0s; i++) {
         if (ltree->access(lTreePositionOfFirst + i, &lPath)) {
             only0s = false;
         }
@@ -152,7 +574,7 @@ unsigned long DKTree::insertEntry() {
         insertedColumn = freeColumns.front();
         freeColumns.erase(freeColumns.begin());
     } else {
-        if (firstFreeColumn > matrixSize) {
+        if (firstFreeColumn >= matrixSize) {
             increaseMatrixSize();
         }
         // if not use the last column
@@ -164,8 +586,25 @@ unsigned long DKTree::insertEntry() {
 }
 
 
+void DKTree::reserve(unsigned long n) {
+    while (matrixSize < n) {
+        increaseMatrixSize();
+    }
+}
+
 void DKTree::deleteEntry(unsigned long a) {
-    checkArgument(a, "deleteEntry");
+    clearEntry(a);
+    if (a == firstFreeColumn - 1) {
+        firstFreeColumn--;
+    } else {
+        freeColumns.push_back(a);
+        sort(freeColumns.begin(), freeColumns.end());
+    }
+}
+
+void DKTree::clearEntry(unsigned long a) {
+    checkArgument(a, "clearEntry");
+    removeEdge(a, a);
     vector<unsigned long> allOthers;
     vector<unsigned long> thisOne{a};
     for (unsigned long i = 0; i < firstFreeColumn; i++) {
@@ -179,12 +618,26 @@ void DKTree::deleteEntry(unsigned long a) {
     VectorData others(allOthers);
     deleteEdges(thisA, others);
     deleteEdges(others, thisA);
-    if (a == firstFreeColumn - 1) {
-        firstFreeColumn--;
-    } else {
-        freeColumns.push_back(a);
-        sort(freeColumns.begin(), freeColumns.end());
+}
+
+void DKTree::setFreeEntries(const vector<unsigned long> &entries) {
+    for (unsigned long i = 0; i < entries.size(); i++) {
+        if (entries[i] >= firstFreeColumn || (i > 0 && entries[i] <= entries[i - 1])) {
+            std::stringstream error;
+            error << "setFreeEntries: invalid argument " << entries[i] << ", the entries must be increasing and below "
+                  << firstFreeColumn << "\n";
+            throw std::invalid_argument(error.str());
+        }
+    }
+    freeColumns = entries;
+}
+
+void DKTree::extendTo(unsigned long size) {
+    if (size <= firstFreeColumn) {
+        return;
     }
+    reserve(size);
+    firstFreeColumn = size;
 }
 
 bool DKTree::deleteEdges(VectorData &rows, VectorData &columns) {
@@ -193,63 +646,19 @@ bool DKTree::deleteEdges(VectorData &rows, VectorData &columns) {
         error << "deleteEdges: rows and columns asynch\n";
         throw std::invalid_argument(error.str());
     }
-    const unsigned long partitionSize = matrixSize / long_pow(k, rows.iteration);
-    bool only0s = true;
-    if (partitionSize > 1) { // we are looking at ttree stuff
-        // sort the rows and columns according to which offsets they belong
-        int rowStart[k];
-        int rowEnd[k];
-        int columnStart[k];
-        int columnEnd[k];
-
-        for (int i = 0; i < k; i++) {
-            rowStart[i] = -1;
-            rowEnd[i] = -1;
-            columnStart[i] = -1;
-            columnEnd[i] = -1;
-        }
-
-        splitEntriesOnOffset(rows, partitionSize, rowStart, rowEnd);
-        splitEntriesOnOffset(columns, partitionSize, columnStart, columnEnd);
-
-        // for each offset, there can be a relation if there is at least one row and one column and if its value is not 0.
-        for (int offset = BLOCK_SIZE - 1; offset >= 0; offset--) {
-            unsigned long rowOffset = offset / k;
-            // std::cout << "rowOffset " << rowOffset << "\n";
-            unsigned long columnOffset = offset % k;
-            // std::cout << "columnOffset " << columnOffset << "\n";
-            unsigned long currentNode = rows.firstAt + offset;
-            bool nodeSubtreeHasEdges = ttree->access(currentNode, &tPath);
-            if (nodeSubtreeHasEdges) {
-                if (!(rowStart[rowOffset] == -1 || columnStart[columnOffset] == -1)) {
-                    // there can only be a relation if there is at least 1 element in both of them
-                    // rank function is exclusive so +1
-                    unsigned long nextNode = ttree->rank1(currentNode + 1, &tPath) * BLOCK_SIZE;
-                    // if there are edges in this subtree find the edges stored in the child nodes
-                    unsigned long nextIteration = rows.iteration + 1;
-                    VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
-                    VectorData columnData(columns, columnStart[columnOffset], columnEnd[columnOffset], nextIteration,
-                                          nextNode);
-                    // check if there are still edges left in its child nodes after deleting the edges from the rowData columnData
-                    bool stillHasEdges = deleteEdges(rowData, columnData);
-                    // if there still are edges in its child nodes then this node stays 1 and so should its parent
-                    if (stillHasEdges) {
-                        only0s = false;
-                    } else {
-                        // if there are no edges in its child nodes this edge can be set to 0
-                        ttree->setBit(currentNode, false, &tPath);
-                    }
-                } else {
-                    // if this offset is 1 and there is no edge to delete, its parent also should know there are still edges
-                    only0s = false;
-                }
-            }
-        }
-        if (only0s && rows.iteration > 1) {
-            // if there are no more edges in this block it can be deleted
-            deleteBlockTtree(rows.firstAt);
+    bool only0s;
+    if (rows.iteration < levels.height()) { // we are looking at ttree stuff
+        switch (levels.arity(rows.iteration)) {
+            case 2:
+                only0s = deleteEdgesFromTTree<2>(rows, columns);
+                break;
+            case 4:
+                only0s = deleteEdgesFromTTree<4>(rows, columns);
+                break;
+            default:
+                only0s = deleteEdgesFromTTree<8>(rows, columns);
+                break;
         }
-
     } else { // we look at ltree stuff
         only0s = deleteEdgesFromLTree(rows, columns);
     }
@@ -257,23 +666,98 @@ bool DKTree::deleteEdges(VectorData &rows, VectorData &columns) {
     return !only0s;
 }
 
+template<unsigned long K>
+bool DKTree::deleteEdgesFromTTree(VectorData &rows, VectorData &columns) {
+    bool only0s = true;
+    // sort the rows and columns according to which offsets they belong
+    int rowStart[K];
+    int rowEnd[K];
+    int columnStart[K];
+    int columnEnd[K];
+
+    for (int i = 0; i < K; i++) {
+        rowStart[i] = -1;
+        rowEnd[i] = -1;
+        columnStart[i] = -1;
+        columnEnd[i] = -1;
+    }
+
+    splitEntriesOnOffset<K>(rows, rowStart, rowEnd);
+    splitEntriesOnOffset<K>(columns, columnStart, columnEnd);
+
+    // for each offset, there can be a relation if there is at least one row and one column and if its value is not 0.
+    // K is known at compile time, so this loop is unrolled and the divisions become shifts
+#pragma GCC unroll 64
+    for (long offset = K * K - 1; offset >= 0; offset--) {
+        unsigned long rowOffset = offset / K;
+        unsigned long columnOffset = offset % K;
+        unsigned long currentNode = rows.firstAt + offset;
+        bool nodeSubtreeHasEdges = ttree->access(currentNode, &tPath);
+        if (nodeSubtreeHasEdges) {
+            if (!(rowStart[rowOffset] == -1 || columnStart[columnOffset] == -1)) {
+                // there can only be a relation if there is at least 1 element in both of them
+                unsigned long nextNode = childPosition(currentNode, rows.iteration);
+                // if there are edges in this subtree find the edges stored in the child nodes
+                unsigned long nextIteration = rows.iteration + 1;
+                VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
+                VectorData columnData(columns, columnStart[columnOffset], columnEnd[columnOffset], nextIteration,
+                                      nextNode);
+                // check if there are still edges left in its child nodes after deleting the edges from the rowData columnData
+                bool stillHasEdges = deleteEdges(rowData, columnData);
+                // if there still are edges in its child nodes then this node stays 1 and so should its parent
+                if (stillHasEdges) {
+                    only0s = false;
+                } else {
+                    // if there are no edges in its child nodes this edge can be set to 0
+                    setTtreeBit(currentNode, false);
+                }
+            } else {
+                // if this offset is 1 and there is no edge to delete, its parent also should know there are still edges
+                only0s = false;
+            }
+        }
+    }
+    if (only0s && rows.iteration > 1) {
+        // if there are no more edges in this block it can be deleted
+        deleteBlockTtree(rows.firstAt, rows.iteration);
+    }
+    return only0s;
+}
+
+// the arities for which the per-level operations are compiled, see LevelTable
+static_assert(MAX_LEVEL_K == 8, "the per-level operations are only compiled for the arities 2, 4 and 8");
+template bool DKTree::deleteEdgesFromTTree<2>(VectorData &rows, VectorData &columns);
+template bool DKTree::deleteEdgesFromTTree<4>(VectorData &rows, VectorData &columns);
+template bool DKTree::deleteEdgesFromTTree<8>(VectorData &rows, VectorData &columns);
+
 bool DKTree::deleteEdgesFromLTree(VectorData &rows, VectorData &columns) {
     bool only0s = true;
-    const unsigned long partitionSize = matrixSize / long_pow(k, rows.iteration);
-    if (partitionSize > 1) {
+    if (rows.iteration != levels.height()) {
         std::stringstream error;
         error << "findEdgesInLTree: not lTree iteration\n";
         throw std::invalid_argument(error.str());
     }
     unsigned long ltreeposition = rows.firstAt - ttree->bits();
+    const unsigned long blockSize = levels.blockSize(rows.iteration);
+    if (vocabulary) {
+        unsigned long leaf = ltreeposition / blockSize;
+        u64 pattern = vocabulary->pattern(leafCodes->get(leaf));
+        for (unsigned long i = rows.start; i < rows.end; i++) {
+            for (unsigned long j = columns.start; j < columns.end; j++) {
+                pattern &= ~(1ull << calculateOffset(rows.entry[i], columns.entry[j], rows.iteration));
+            }
+        }
+        setLeafPattern(leaf, pattern);
+        return pattern == 0;
+    }
     for (unsigned long i = rows.start; i < rows.end; i++) {
         for (unsigned long j = columns.start; j < columns.end; j++) {
             unsigned long offset = calculateOffset(rows.entry[i], columns.entry[j], rows.iteration);
             unsigned long nodePosition = ltreeposition + offset;
-            ltree->setBit(nodePosition, false, &lPath);
+            setLtreeBit(nodePosition, false);
         }
     }
-    for (unsigned long offset = 0; offset < BLOCK_SIZE && only0s; offset++) {
+    for (unsigned long offset = 0; offset < blockSize && only0s; offset++) {
         if (ltree->access(ltreeposition + offset, &lPath)) {
             only0s = false;
         }
@@ -299,7 +783,14 @@ bool DKTree::reportEdge(unsigned long a, unsigned long b) {
     // if the last bit found in the ttree is a 1 then find the final result in the ltree
     if (centry) {
         unsigned long ltreePosition = position - tmax;
-        centry = ltree->access(ltreePosition, &lPath);
+        if (vocabulary) {
+            // decode the pattern of the leaf submatrix and test the bit of this cell
+            unsigned long leafSize = levels.blockSize(iteration);
+            u64 pattern = vocabulary->pattern(leafCodes->get(ltreePosition / leafSize));
+            centry = (pattern >> (ltreePosition % leafSize)) & 1;
+        } else {
+            centry = ltree->access(ltreePosition, &lPath);
+        }
     }
     return centry;
 }
@@ -327,64 +818,92 @@ DKTree::findAllEdges(VectorData &rows, VectorData &columns,
         error << "findAllEdges: rows and columns asynch\n";
         throw std::invalid_argument(error.str());
     }
-    const unsigned long partitionSize = matrixSize / long_pow(k, rows.iteration);
-    if (partitionSize > 1) { // we are looking at ttree stuff
-        // sort the rows and columns according to which offsets they belong
-        int rowStart[k];
-        int rowEnd[k];
-        int columnStart[k];
-        int columnEnd[k];
-
-        for (int i = 0; i < k; i++) {
-            rowStart[i] = -1;
-            rowEnd[i] = -1;
-            columnStart[i] = -1;
-            columnEnd[i] = -1;
+    if (rows.iteration < levels.height()) { // we are looking at ttree stuff
+        switch (levels.arity(rows.iteration)) {
+            case 2:
+                findEdgesInTTree<2>(rows, columns, findings);
+                break;
+            case 4:
+                findEdgesInTTree<4>(rows, columns, findings);
+                break;
+            default:
+                findEdgesInTTree<8>(rows, columns, findings);
+                break;
         }
+    } else { // we look at ltree stuff
+        findEdgesInLTree(rows, columns, findings);
+    }
+}
 
-        splitEntriesOnOffset(rows, partitionSize, rowStart, rowEnd);
-        splitEntriesOnOffset(columns, partitionSize, columnStart, columnEnd);
+template<unsigned long K>
+void DKTree::findEdgesInTTree(VectorData &rows, VectorData &columns,
+                              vector<std::pair<unsigned long, unsigned long>> &findings) {
+    // sort the rows and columns according to which offsets they belong
+    int rowStart[K];
+    int rowEnd[K];
+    int columnStart[K];
+    int columnEnd[K];
 
-        // for each offset, there can be a relation if there is at least one row and one column and if its value is not 0.
-        for (unsigned long offset = 0; offset < BLOCK_SIZE; offset++) {
-            unsigned long rowOffset = offset / k;
-            unsigned long columnOffset = offset % k;
-            if (!(rowStart[rowOffset] == -1 || columnStart[columnOffset] == -1)) {
-                // there can only be a relation if there is at least 1 element in both of them
-                unsigned long currentNode = rows.firstAt + offset;
-                bool nodeSubtreeHasEdges = ttree->access(currentNode, &tPath);
-                if (nodeSubtreeHasEdges) {
-                    // rank function is exclusive so +1
-                    unsigned long nextNode = ttree->rank1(currentNode + 1, &tPath) * BLOCK_SIZE;
-                    // if there are edges in this subtree find the edges stored in the child nodes
-                    unsigned long nextIteration = rows.iteration + 1;
-                    VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
-                    VectorData columnData(columns, columnStart[columnOffset], columnEnd[columnOffset], nextIteration,
-                                          nextNode);
-                    findAllEdges(rowData, columnData, findings);
-                }
+    for (int i = 0; i < K; i++) {
+        rowStart[i] = -1;
+        rowEnd[i] = -1;
+        columnStart[i] = -1;
+        columnEnd[i] = -1;
+    }
+
+    splitEntriesOnOffset<K>(rows, rowStart, rowEnd);
+    splitEntriesOnOffset<K>(columns, columnStart, columnEnd);
+
+    // for each offset, there can be a relation if there is at least one row and one column and if its value is not 0.
+    // K is known at compile time, so this loop is unrolled and the divisions become shifts
+#pragma GCC unroll 64
+    for (unsigned long offset = 0; offset < K * K; offset++) {
+        unsigned long rowOffset = offset / K;
+        unsigned long columnOffset = offset % K;
+        if (!(rowStart[rowOffset] == -1 || columnStart[columnOffset] == -1)) {
+            // there can only be a relation if there is at least 1 element in both of them
+            unsigned long currentNode = rows.firstAt + offset;
+            bool nodeSubtreeHasEdges = ttree->access(currentNode, &tPath);
+            if (nodeSubtreeHasEdges) {
+                unsigned long nextNode = childPosition(currentNode, rows.iteration);
+                // if there are edges in this subtree find the edges stored in the child nodes
+                unsigned long nextIteration = rows.iteration + 1;
+                VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
+                VectorData columnData(columns, columnStart[columnOffset], columnEnd[columnOffset], nextIteration,
+                                      nextNode);
+                findAllEdges(rowData, columnData, findings);
             }
         }
-    } else { // we look at ltree stuff
-        findEdgesInLTree(rows, columns, findings);
     }
 }
 
+template void DKTree::findEdgesInTTree<2>(VectorData &rows, VectorData &columns,
+                                          vector<std::pair<unsigned long, unsigned long>> &findings);
+template void DKTree::findEdgesInTTree<4>(VectorData &rows, VectorData &columns,
+                                          vector<std::pair<unsigned long, unsigned long>> &findings);
+template void DKTree::findEdgesInTTree<8>(VectorData &rows, VectorData &columns,
+                                          vector<std::pair<unsigned long, unsigned long>> &findings);
+
 void DKTree::findEdgesInLTree(const VectorData &rows, const VectorData &columns,
                               vector<pair<unsigned long, unsigned long>> &findings) {
 
-    const unsigned long partitionSize = matrixSize / long_pow(k, rows.iteration);
-    if (partitionSize > 1) {
+    if (rows.iteration != levels.height()) {
         std::stringstream error;
         error << "findEdgesInLTree: not lTree iteration\n";
         throw std::invalid_argument(error.str());
     }
     unsigned long ltreeposition = rows.firstAt - ttree->bits();
+    // in vocabulary mode the pattern of the leaf submatrix is decoded once, and the edges are read from it
+    u64 pattern = vocabulary ? vocabulary->pattern(leafCodes->get(ltreeposition / levels.blockSize(rows.iteration))) : 0;
     for (unsigned long i = rows.start; i < rows.end; i++) {
         for (unsigned long j = columns.start; j < columns.end; j++) {
             unsigned long offset = calculateOffset(rows.entry[i], columns.entry[j], rows.iteration);
-            unsigned long nodePosition = ltreeposition + offset;
-            bool hasEdge = ltree->access(nodePosition, &lPath);
+            bool hasEdge;
+            if (vocabulary) {
+                hasEdge = (pattern >> offset) & 1;
+            } else {
+                hasEdge = ltree->access(ltreeposition + offset, &lPath);
+            }
             if (hasEdge) {
                 pair<unsigned long, unsigned long> edge(rows.entry[i], columns.entry[j]);
                 findings.push_back(edge);
@@ -393,13 +912,12 @@ void DKTree::findEdgesInLTree(const VectorData &rows, const VectorData &columns,
     }
 }
 
-void DKTree::splitEntriesOnOffset(const VectorData &entries, const unsigned long partitionSize, int *entryStart,
-                                  int *entryEnd) const {
-    const unsigned long formerPartitionSize = partitionSize * k;
+template<unsigned long K>
+void DKTree::splitEntriesOnOffset(const VectorData &entries, int *entryStart, int *entryEnd) const {
+    const unsigned long partitionSize = levels.partitionSize(entries.iteration);
     unsigned long offsetStarted;
     for (unsigned long i = entries.start; i < entries.end; i++) {
-        unsigned long entryInBlock = entries.entry[i] % formerPartitionSize;
-        unsigned long entryOffset = (entryInBlock / partitionSize);
+        unsigned long entryOffset = (entries.entry[i] / partitionSize) % K;
         if (entryStart[entryOffset] == -1) {
             entryStart[entryOffset] = i;
             if (i > entries.start) {
@@ -414,6 +932,529 @@ void DKTree::splitEntriesOnOffset(const VectorData &entries, const unsigned long
 }
 
 
+vector<unsigned long> DKTree::reportSuccessors(unsigned long a) {
+    checkArgument(a, "reportSuccessors");
+    vector<unsigned long> successors;
+    // for a single row the columns are found from left to right
+    expandFrontier(vector<unsigned long>{a}, successors);
+    return successors;
+}
+vector<unsigned long> DKTree::reportPredecessors(unsigned long b) {
+    checkArgument(b, "reportPredecessors");
+    vector<unsigned long> predecessors;
+    reportColumn(b, 0, 1, 0, predecessors);
+    return predecessors;
+}
+
+void DKTree::reportColumn(unsigned long b, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                          vector<unsigned long> &predecessors) {
+    const unsigned long arity = levels.arity(iteration);
+    const unsigned long partitionSize = levels.partitionSize(iteration);
+    const unsigned long columnOffset = (b / partitionSize) % arity;
+    if (iteration < levels.height()) {
+        // the row stripes are visited from top to bottom, so the predecessors are found in increasing order
+        for (unsigned long rowOffset = 0; rowOffset < arity; rowOffset++) {
+            unsigned long currentNode = firstAt + rowOffset * arity + columnOffset;
+            if (ttree->access(currentNode, &tPath)) {
+                reportColumn(b, childPosition(currentNode, iteration), iteration + 1,
+                             row + rowOffset * partitionSize, predecessors);
+            }
+        }
+        return;
+    }
+    const unsigned long ltreePosition = firstAt - ttree->bits();
+    u64 pattern = vocabulary ? vocabulary->pattern(leafCodes->get(ltreePosition / levels.blockSize(iteration)))
+                             : ltree->accessBits(ltreePosition, levels.blockSize(iteration), &lPath);
+    for (unsigned long rowOffset = 0; rowOffset < arity; rowOffset++) {
+        if ((pattern >> (rowOffset * arity + columnOffset)) & 1) {
+            predecessors.push_back(row + rowOffset);
+        }
+    }
+}
+
+vector<unsigned long> DKTree::intersectSuccessors(unsigned long a, unsigned long b) {
+    checkArgument(a, "intersectSuccessors");
+    checkArgument(b, "intersectSuccessors");
+    vector<unsigned long> common;
+    intersectRows(a, b, 0, 0, 1, 0, &common);
+    return common;
+}
+
+unsigned long DKTree::countCommonSuccessors(unsigned long a, unsigned long b) {
+    checkArgument(a, "countCommonSuccessors");
+    checkArgument(b, "countCommonSuccessors");
+    return intersectRows(a, b, 0, 0, 1, 0, nullptr);
+}
+
+unsigned long DKTree::intersectRows(unsigned long a, unsigned long b, unsigned long firstA, unsigned long firstB,
+                                    unsigned long iteration, unsigned long column, vector<unsigned long> *common) {
+    if (iteration < levels.height()) {
+        switch (levels.arity(iteration)) {
+            case 2:
+                return intersectRowsInTTree<2>(a, b, firstA, firstB, iteration, column, common);
+            case 4:
+                return intersectRowsInTTree<4>(a, b, firstA, firstB, iteration, column, common);
+            default:
+                return intersectRowsInTTree<8>(a, b, firstA, firstB, iteration, column, common);
+        }
+    }
+    return intersectRowsInLTree(a, b, firstA, firstB, iteration, column, common);
+}
+
+template<unsigned long K>
+unsigned long DKTree::intersectRowsInTTree(unsigned long a, unsigned long b, unsigned long firstA,
+                                           unsigned long firstB, unsigned long iteration, unsigned long column,
+                                           vector<unsigned long> *common) {
+    const unsigned long partitionSize = levels.partitionSize(iteration);
+    // the first bit of the row stripe of a and of b in their blocks
+    const unsigned long rowA = firstA + ((a / partitionSize) % K) * K;
+    const unsigned long rowB = firstB + ((b / partitionSize) % K) * K;
+    unsigned long found = 0;
+#pragma GCC unroll 8
+    for (unsigned long columnOffset = 0; columnOffset < K; columnOffset++) {
+        // a column stripe can only contain common successors if it has edges in both rows
+        if (!ttree->access(rowA + columnOffset, &tPath) || !ttree->access(rowB + columnOffset, &tPath)) {
+            continue;
+        }
+        unsigned long childA = childPosition(rowA + columnOffset, iteration);
+        unsigned long childB = rowA == rowB ? childA : childPosition(rowB + columnOffset, iteration);
+        found += intersectRows(a, b, childA, childB, iteration + 1, column + columnOffset * partitionSize, common);
+    }
+    return found;
+}
+
+template unsigned long DKTree::intersectRowsInTTree<2>(unsigned long a, unsigned long b, unsigned long firstA,
+                                                       unsigned long firstB, unsigned long iteration,
+                                                       unsigned long column, vector<unsigned long> *common);
+template unsigned long DKTree::intersectRowsInTTree<4>(unsigned long a, unsigned long b, unsigned long firstA,
+                                                       unsigned long firstB, unsigned long iteration,
+                                                       unsigned long column, vector<unsigned long> *common);
+template unsigned long DKTree::intersectRowsInTTree<8>(unsigned long a, unsigned long b, unsigned long firstA,
+                                                       unsigned long firstB, unsigned long iteration,
+                                                       unsigned long column, vector<unsigned long> *common);
+
+unsigned long DKTree::intersectRowsInLTree(unsigned long a, unsigned long b, unsigned long firstA,
+                                           unsigned long firstB, unsigned long iteration, unsigned long column,
+                                           vector<unsigned long> *common) {
+    const unsigned long arity = levels.arity(iteration);
+    const unsigned long positionA = firstA - ttree->bits() + (a % arity) * arity;
+    const unsigned long positionB = firstB - ttree->bits() + (b % arity) * arity;
+    // read the row of the leaf block of a and of b as a bit mask, and intersect them
+    u64 maskA = 0, maskB = 0;
+    if (vocabulary) {
+        const unsigned long leafSize = levels.blockSize(iteration);
+        u64 rowMask = (1ul << arity) - 1;
+        maskA = (vocabulary->pattern(leafCodes->get(positionA / leafSize)) >> (positionA % leafSize)) & rowMask;
+        maskB = (vocabulary->pattern(leafCodes->get(positionB / leafSize)) >> (positionB % leafSize)) & rowMask;
+    } else {
+        for (unsigned long columnOffset = 0; columnOffset < arity; columnOffset++) {
+            maskA |= (u64) ltree->access(positionA + columnOffset, &lPath) << columnOffset;
+            maskB |= (u64) ltree->access(positionB + columnOffset, &lPath) << columnOffset;
+        }
+    }
+    u64 both = maskA & maskB;
+    if (common != nullptr) {
+        for (u64 bits = both; bits != 0; bits &= bits - 1) {
+            common->push_back(column + __builtin_ctzl(bits));
+        }
+    }
+    return __builtin_popcountl(both);
+}
+
+void DKTree::expandFrontier(const vector<unsigned long> &frontier, vector<unsigned long> &next, VertexSet *visited) {
+    for (unsigned long i = 0; i < frontier.size(); i++) {
+        if (frontier[i] >= firstFreeColumn || (i > 0 && frontier[i - 1] >= frontier[i])) {
+            std::stringstream error;
+            error << "expandFrontier: invalid frontier entry " << frontier[i]
+                  << ", the frontier must be sorted and below firstfreecolumn = " << firstFreeColumn << "\n";
+            throw std::invalid_argument(error.str());
+        }
+    }
+    if (frontier.empty()) {
+        return;
+    }
+    VectorData rows(frontier);
+    expandRows(rows, 0, next, visited);
+}
+
+void DKTree::expandRows(VectorData &rows, unsigned long column, vector<unsigned long> &next, VertexSet *visited) {
+    if (rows.iteration < levels.height()) {
+        switch (levels.arity(rows.iteration)) {
+            case 2:
+                expandRowsInTTree<2>(rows, column, next, visited);
+                break;
+            case 4:
+                expandRowsInTTree<4>(rows, column, next, visited);
+                break;
+            default:
+                expandRowsInTTree<8>(rows, column, next, visited);
+                break;
+        }
+    } else {
+        expandRowsInLTree(rows, column, next, visited);
+    }
+}
+
+template<unsigned long K>
+void DKTree::expandRowsInTTree(VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                               VertexSet *visited) {
+    int rowStart[K];
+    int rowEnd[K];
+    for (unsigned long i = 0; i < K; i++) {
+        rowStart[i] = -1;
+        rowEnd[i] = -1;
+    }
+    splitEntriesOnOffset<K>(rows, rowStart, rowEnd);
+
+    // every row stripe of the block that contains frontier rows is read once, for all columns
+    const unsigned long partitionSize = levels.partitionSize(rows.iteration);
+    const unsigned long nextIteration = rows.iteration + 1;
+    for (unsigned long rowOffset = 0; rowOffset < K; rowOffset++) {
+        if (rowStart[rowOffset] == -1) {
+            continue;
+        }
+#pragma GCC unroll 8
+        for (unsigned long columnOffset = 0; columnOffset < K; columnOffset++) {
+            unsigned long currentNode = rows.firstAt + rowOffset * K + columnOffset;
+            if (ttree->access(currentNode, &tPath)) {
+                unsigned long nextNode = childPosition(currentNode, rows.iteration);
+                VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
+                expandRows(rowData, column + columnOffset * partitionSize, next, visited);
+            }
+        }
+    }
+}
+
+template void DKTree::expandRowsInTTree<2>(VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                                           VertexSet *visited);
+template void DKTree::expandRowsInTTree<4>(VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                                           VertexSet *visited);
+template void DKTree::expandRowsInTTree<8>(VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                                           VertexSet *visited);
+
+void DKTree::expandRowsInLTree(const VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                               VertexSet *visited) {
+    const unsigned long arity = levels.arity(rows.iteration);
+    const unsigned long ltreePosition = rows.firstAt - ttree->bits();
+    u64 pattern = vocabulary ? vocabulary->pattern(leafCodes->get(ltreePosition / levels.blockSize(rows.iteration))) : 0;
+    for (unsigned long i = rows.start; i < rows.end; i++) {
+        // at the leaf level every row has its own row of the block
+        unsigned long rowOffset = rows.entry[i] % arity;
+        for (unsigned long columnOffset = 0; columnOffset < arity; columnOffset++) {
+            unsigned long offset = rowOffset * arity + columnOffset;
+            bool hasEdge;
+            if (vocabulary) {
+                hasEdge = (pattern >> offset) & 1;
+            } else {
+                hasEdge = ltree->access(ltreePosition + offset, &lPath);
+            }
+            if (hasEdge && (visited == nullptr || visited->insert(column + columnOffset))) {
+                next.push_back(column + columnOffset);
+            }
+        }
+    }
+}
+
+
+void DKTree::expandFrontierPull(const vector<unsigned long> &frontier, const vector<unsigned long> &candidates,
+                                vector<unsigned long> &next, VertexSet &visited) {
+    if (visited.capacity() < matrixSize) {
+        std::stringstream error;
+        error << "expandFrontierPull: the visited set needs room for " << matrixSize << " vertices\n";
+        throw std::invalid_argument(error.str());
+    }
+    for (unsigned long i = 0; i < frontier.size(); i++) {
+        if (frontier[i] >= matrixSize || (i > 0 && frontier[i - 1] >= frontier[i])) {
+            std::stringstream error;
+            error << "expandFrontierPull: invalid frontier entry " << frontier[i]
+                  << ", the frontier must be sorted and below matrixsize = " << matrixSize << "\n";
+            throw std::invalid_argument(error.str());
+        }
+    }
+    for (unsigned long i = 0; i < candidates.size(); i++) {
+        if (candidates[i] >= matrixSize || (i > 0 && candidates[i - 1] >= candidates[i])) {
+            std::stringstream error;
+            error << "expandFrontierPull: invalid candidate " << candidates[i]
+                  << ", the candidates must be sorted and below matrixsize = " << matrixSize << "\n";
+            throw std::invalid_argument(error.str());
+        }
+    }
+    if (candidates.empty() || frontier.empty()) {
+        return;
+    }
+    VectorData rows(frontier);
+    VectorData columns(candidates);
+    pullColumns(rows, columns, next, visited);
+}
+
+unsigned long DKTree::pullColumns(VectorData &rows, VectorData &columns, vector<unsigned long> &next,
+                                  VertexSet &visited) {
+    if (columns.iteration < levels.height()) {
+        switch (levels.arity(columns.iteration)) {
+            case 2:
+                return pullColumnsInTTree<2>(rows, columns, next, visited);
+            case 4:
+                return pullColumnsInTTree<4>(rows, columns, next, visited);
+            default:
+                return pullColumnsInTTree<8>(rows, columns, next, visited);
+        }
+    }
+    return pullColumnsInLTree(rows, columns, next, visited);
+}
+
+template<unsigned long K>
+unsigned long DKTree::pullColumnsInTTree(VectorData &rows, VectorData &columns, vector<unsigned long> &next,
+                                         VertexSet &visited) {
+    int rowStart[K];
+    int rowEnd[K];
+    int columnStart[K];
+    int columnEnd[K];
+    unsigned long remaining[K];
+    for (unsigned long i = 0; i < K; i++) {
+        rowStart[i] = -1;
+        rowEnd[i] = -1;
+        columnStart[i] = -1;
+        columnEnd[i] = -1;
+        remaining[i] = 0;
+    }
+    splitEntriesOnOffset<K>(rows, rowStart, rowEnd);
+    splitEntriesOnOffset<K>(columns, columnStart, columnEnd);
+
+    // count the candidates of every column stripe that have not been found yet
+    const unsigned long partitionSize = levels.partitionSize(columns.iteration);
+    for (unsigned long i = columns.start; i < columns.end; i++) {
+        if (!visited.contains(columns.entry[i])) {
+            remaining[(columns.entry[i] / partitionSize) % K]++;
+        }
+    }
+
+    const unsigned long nextIteration = columns.iteration + 1;
+    unsigned long found = 0;
+    for (unsigned long columnOffset = 0; columnOffset < K; columnOffset++) {
+        // stop reading a column stripe as soon as all of its candidates have a predecessor, and only read
+        // the blocks of row stripes that contain frontier rows
+        for (unsigned long rowOffset = 0; rowOffset < K && remaining[columnOffset] > 0; rowOffset++) {
+            if (rowStart[rowOffset] == -1) {
+                continue;
+            }
+            unsigned long currentNode = columns.firstAt + rowOffset * K + columnOffset;
+            if (ttree->access(currentNode, &tPath)) {
+                unsigned long nextNode = childPosition(currentNode, columns.iteration);
+                VectorData rowData(rows, rowStart[rowOffset], rowEnd[rowOffset], nextIteration, nextNode);
+                VectorData columnData(columns, columnStart[columnOffset], columnEnd[columnOffset], nextIteration,
+                                      nextNode);
+                unsigned long pulled = pullColumns(rowData, columnData, next, visited);
+                remaining[columnOffset] -= pulled;
+                found += pulled;
+            }
+        }
+    }
+    return found;
+}
+
+template unsigned long DKTree::pullColumnsInTTree<2>(VectorData &rows, VectorData &columns,
+                                                     vector<unsigned long> &next, VertexSet &visited);
+template unsigned long DKTree::pullColumnsInTTree<4>(VectorData &rows, VectorData &columns,
+                                                     vector<unsigned long> &next, VertexSet &visited);
+template unsigned long DKTree::pullColumnsInTTree<8>(VectorData &rows, VectorData &columns,
+                                                     vector<unsigned long> &next, VertexSet &visited);
+
+unsigned long DKTree::pullColumnsInLTree(const VectorData &rows, const VectorData &columns,
+                                         vector<unsigned long> &next, VertexSet &visited) {
+    const unsigned long arity = levels.arity(columns.iteration);
+    const unsigned long ltreePosition = columns.firstAt - ttree->bits();
+    u64 pattern = vocabulary ? vocabulary->pattern(leafCodes->get(ltreePosition / levels.blockSize(columns.iteration))) : 0;
+    unsigned long found = 0;
+    for (unsigned long i = columns.start; i < columns.end; i++) {
+        unsigned long column = columns.entry[i];
+        if (visited.contains(column)) {
+            continue;
+        }
+        unsigned long columnOffset = column % arity;
+        // at the leaf level every frontier row has its own row of the block
+        for (unsigned long j = rows.start; j < rows.end; j++) {
+            unsigned long offset = (rows.entry[j] % arity) * arity + columnOffset;
+            bool hasEdge;
+            if (vocabulary) {
+                hasEdge = (pattern >> offset) & 1;
+            } else {
+                hasEdge = ltree->access(ltreePosition + offset, &lPath);
+            }
+            if (hasEdge) {
+                visited.insert(column);
+                next.push_back(column);
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+
+vector<double> DKTree::multiply(const vector<double> &x, unsigned int threads) {
+    vector<double> y(x.size(), 0.0);
+    multiplyInStripes(x, y, false, threads);
+    return y;
+}
+
+vector<double> DKTree::multiplyTransposed(const vector<double> &x, unsigned int threads) {
+    vector<double> y(x.size(), 0.0);
+    multiplyInStripes(x, y, true, threads);
+    return y;
+}
+
+void DKTree::multiplyInStripes(const vector<double> &x, vector<double> &y, bool transposed, unsigned int threads) {
+    if (x.size() < firstFreeColumn) {
+        std::stringstream error;
+        error << "multiply: the vector has " << x.size() << " values, but there are " << firstFreeColumn
+              << " vertices\n";
+        throw std::invalid_argument(error.str());
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || firstFreeColumn == 0) {
+        // the vectors only have an entry for every vertex, not for the padding up to matrixSize
+        MultiplyTask task(x, y, transposed, 0, std::min(matrixSize, (unsigned long) y.size()), levels.height());
+        multiplyBlock(task, 0, 1, 0, 0, true);
+        return;
+    }
+
+    // divide the output entries into the stripes of the highest level that has a few stripes per thread,
+    // the threads take the stripes in turn so that dense and sparse parts of the matrix are spread out
+    unsigned long iteration = 1;
+    while (iteration < levels.height() && matrixSize / levels.partitionSize(iteration) < 4ul * threads) {
+        iteration++;
+    }
+    const unsigned long stripeSize = levels.partitionSize(iteration);
+    const unsigned long stripes = (firstFreeColumn + stripeSize - 1) / stripeSize;
+    threads = (unsigned int) std::min((unsigned long) threads, stripes);
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            try {
+                for (unsigned long stripe = t; stripe < stripes; stripe += threads) {
+                    MultiplyTask task(x, y, transposed, stripe * stripeSize,
+                                      std::min((stripe + 1) * stripeSize, (unsigned long) y.size()),
+                                      levels.height());
+                    multiplyBlock(task, 0, 1, 0, 0, false);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void DKTree::multiplyBlock(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                           unsigned long column, bool whole) {
+    if (iteration < levels.height()) {
+        switch (levels.arity(iteration)) {
+            case 2:
+                multiplyInTTree<2>(task, firstAt, iteration, row, column, whole);
+                break;
+            case 4:
+                multiplyInTTree<4>(task, firstAt, iteration, row, column, whole);
+                break;
+            default:
+                multiplyInTTree<8>(task, firstAt, iteration, row, column, whole);
+                break;
+        }
+    } else {
+        multiplyInLTree(task, firstAt, iteration, row, column);
+    }
+}
+
+template<unsigned long K>
+void DKTree::multiplyInTTree(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                             unsigned long column, bool whole) {
+    const unsigned long partitionSize = levels.partitionSize(iteration);
+    const unsigned long childBlockSize = levels.blockSize(iteration + 1);
+    unsigned long &nextChild = task.nextChild[iteration + 1];
+    for (unsigned long rowOffset = 0; rowOffset < K; rowOffset++) {
+        unsigned long childRow = row + rowOffset * partitionSize;
+#pragma GCC unroll 8
+        for (unsigned long columnOffset = 0; columnOffset < K; columnOffset++) {
+            unsigned long childColumn = column + columnOffset * partitionSize;
+            unsigned long childOutput = task.transposed ? childColumn : childRow;
+            // skip the partitions whose output entries belong to another task
+            if (!whole && (childOutput >= task.end || childOutput + partitionSize <= task.first)) {
+                continue;
+            }
+            unsigned long currentNode = firstAt + rowOffset * K + columnOffset;
+            if (!ttree->access(currentNode, &task.tPaths[iteration])) {
+                continue;
+            }
+            if (whole) {
+                // the children of a subtree that is walked completely are the consecutive blocks of the next level
+                if (nextChild == 0) {
+                    nextChild = childPosition(currentNode, iteration, &task.tPaths[iteration]);
+                }
+                unsigned long nextNode = nextChild;
+                nextChild += childBlockSize;
+                multiplyBlock(task, nextNode, iteration + 1, childRow, childColumn, true);
+            } else {
+                unsigned long nextNode = childPosition(currentNode, iteration, &task.tPaths[iteration]);
+                bool childWhole = childOutput >= task.first && childOutput + partitionSize <= task.end;
+                if (childWhole) {
+                    // a new subtree that is walked completely, whose descendants are not known yet
+                    std::fill(task.nextChild.begin() + iteration + 2, task.nextChild.end(), 0);
+                }
+                multiplyBlock(task, nextNode, iteration + 1, childRow, childColumn, childWhole);
+            }
+        }
+    }
+}
+
+template void DKTree::multiplyInTTree<2>(MultiplyTask &task, unsigned long firstAt, unsigned long iteration,
+                                         unsigned long row, unsigned long column, bool whole);
+template void DKTree::multiplyInTTree<4>(MultiplyTask &task, unsigned long firstAt, unsigned long iteration,
+                                         unsigned long row, unsigned long column, bool whole);
+template void DKTree::multiplyInTTree<8>(MultiplyTask &task, unsigned long firstAt, unsigned long iteration,
+                                         unsigned long row, unsigned long column, bool whole);
+
+void DKTree::multiplyInLTree(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                             unsigned long column) {
+    const unsigned long arity = levels.arity(iteration);
+    const unsigned long ltreePosition = firstAt - ttree->bits();
+    u64 pattern = vocabulary ? vocabulary->pattern(leafCodes->get(ltreePosition / levels.blockSize(iteration))) : 0;
+    // the products of the block are summed per output entry, which is a row of the block, or a column if transposed
+    for (unsigned long output = 0; output < arity; output++) {
+        unsigned long outputEntry = (task.transposed ? column : row) + output;
+        if (outputEntry < task.first || outputEntry >= task.end) {
+            continue;
+        }
+        const unsigned long firstInput = task.transposed ? row : column;
+        const unsigned long inputs = firstInput < task.x.size() ? std::min(arity, task.x.size() - firstInput) : 0;
+        double sum = 0;
+        for (unsigned long input = 0; input < inputs; input++) {
+            unsigned long offset = task.transposed ? input * arity + output : output * arity + input;
+            bool hasEdge;
+            if (vocabulary) {
+                hasEdge = (pattern >> offset) & 1;
+            } else {
+                hasEdge = ltree->access(ltreePosition + offset, &task.lPath);
+            }
+            if (hasEdge) {
+                sum += task.x[firstInput + input];
+            }
+        }
+        task.y[outputEntry] += sum;
+    }
+}
+
+
 void DKTree::printtt() {
     cout << "ttree:" << endl;
     printttree(ttree);
@@ -422,6 +1463,13 @@ void DKTree::printtt() {
 
     printltree(ltree);
     printf("\n");
+    if (vocabulary) {
+        cout << "leaf codes:" << endl;
+        for (unsigned long i = 0; i < leafCodes->size(); i++) {
+            unsigned long code = leafCodes->get(i);
+            printf("%lu (%016lx)\n", code, vocabulary->pattern(code));
+        }
+    }
 }
 
 void DKTree::printttree(TTree *tree, unsigned long depth) {
@@ -471,30 +1519,38 @@ void DKTree::printltree(LTree *tree, unsigned long depth) {
 }
 
 void DKTree::increaseMatrixSize() {
+    HOT_PATH_COUNT(matrixGrowths, 1);
     const unsigned long FIRST_BIT = 0;
-    // if the matrix is full, increase the size by multiplying with k
-    matrixSize *= k;
+    // if the matrix is full, increase the size by adding a level with the arity of the root
+    levels.grow();
+    matrixSize = levels.matrixSize();
     // position +1 since paper has rank including the position, but function is exclusive position
-    if (ttree->rank1(BLOCK_SIZE, &tPath) > 0) {
+    if (ttree->rank1(levels.blockSize(1), &tPath) > 0) {
         // if there already is a 1 somewhere in the matrix, add a new block
         // in front of the bitvector and set the first bit to 1
-        insertBlockTtree(FIRST_BIT);
-        ttree->setBit(FIRST_BIT, true, &tPath);
+        levelBlocks.insert(levelBlocks.begin(), 0);
+        insertBlockTtree(FIRST_BIT, 1);
+        setTtreeBit(FIRST_BIT, true);
+    } else {
+        // the empty root block stays the root, the new second level has no blocks yet
+        levelBlocks.insert(levelBlocks.begin() + 1, 0);
+        updateLevelStarts();
     }
 }
 
 unsigned long
 DKTree::calculateOffset(const unsigned long row, const unsigned long column, const unsigned long iteration) {
+    if (iteration == 0 || iteration > levels.height()) {
+        throw std::invalid_argument("partition size is 0\n");
+    }
     // first remove the rows and columns not belonging to the current block
-    unsigned long formerPartitionSize = matrixSize / long_pow(k, iteration - 1);
+    unsigned long arity = levels.arity(iteration);
+    unsigned long partitionSize = levels.partitionSize(iteration);
+    unsigned long formerPartitionSize = partitionSize * arity;
     unsigned long rowInBlock = row % formerPartitionSize;
     unsigned long columnInBlock = column % formerPartitionSize;
-    //calculate the offset, each row partition adds k to the offset, each column partition 1
-    unsigned long partitionSize = matrixSize / long_pow(k, iteration);
-    if (partitionSize == 0) {
-        throw std::invalid_argument("partition size is 0\n");
-    }
-    unsigned long rowOffset = k * (rowInBlock / partitionSize);
+    //calculate the offset, each row partition adds the arity of this level to the offset, each column partition 1
+    unsigned long rowOffset = arity * (rowInBlock / partitionSize);
     unsigned long columnOffset = columnInBlock / partitionSize;
     return rowOffset + columnOffset;
 }
@@ -526,10 +1582,9 @@ void DKTree::traverseToFirst0OrEndOfTTree(unsigned long row, unsigned long colum
     while (cEntry && position < tmax) {
         cEntry = ttree->access(position, &tPath);
         if (cEntry) {
+            unsigned long positionOfFirst = childPosition(position, iteration);
             iteration++;
             unsigned long offset = calculateOffset(row, column, iteration);
-            // position +1 since paper has rank including the position, but function is exclusive position
-            unsigned long positionOfFirst = ttree->rank1(position + 1, &tPath) * BLOCK_SIZE;
             position = positionOfFirst + offset;
         }
     }
@@ -550,56 +1605,134 @@ void DKTree::sortAndCheckVector(vector<unsigned long> &elements) {
     }
 }
 
-void DKTree::insertBlockTtree(unsigned long position) {
-    TTree *newRoot = ttree->insertBlock(position, &tPath);
-    if (newRoot != nullptr) {
-        ttree = newRoot;
+void DKTree::unshareTtreePath(unsigned long position) {
+    if (sharesNodes()) {
+        ttree = TTree::unsharePath(ttree, position, &tPath);
+    } else if (staleParents) {
+        restoreParents();
+    }
+}
+
+void DKTree::unshareLtreePath(unsigned long position) {
+    if (sharesNodes()) {
+        ltree = LTree::unsharePath(ltree, position, &lPath);
+    } else if (staleParents) {
+        restoreParents();
     }
+}
+
+void DKTree::restoreParents() {
+    ttree->parent = nullptr;
+    TTree::restoreParents(ttree);
+    ltree->parent = nullptr;
+    LTree::restoreParents(ltree);
     tPath.clear();
+    lPath.clear();
+    staleParents = false;
+}
+
+void DKTree::setTtreeBit(unsigned long position, bool value) {
+    unshareTtreePath(position);
+    ttree->setBit(position, value, &tPath);
+}
+
+void DKTree::setLtreeBit(unsigned long position, bool value) {
+    unshareLtreePath(position);
+    ltree->setBit(position, value, &lPath);
+}
+
+void DKTree::insertBlockTtree(unsigned long position, unsigned long iteration) {
+    // a block of a level with a larger k consists of several blocks of the ttree
+    for (unsigned long i = 0; i < levels.blockSize(iteration); i += BLOCK_SIZE) {
+        // the copies of shared nodes replace nodes of this tree, so only the nodes of the rebalancing are counted
+        unshareTtreePath(position);
+        TTree *newRoot = ttree->insertBlock(position, &tPath, &tNodes);
+        if (newRoot != nullptr) {
+            ttree = newRoot;
+            tPath.clear();
+        }
+    }
+    levelBlocks[iteration - 1]++;
+    updateLevelStarts();
 }
 
 void DKTree::insertBlockLtree(unsigned long position) {
-    LTree *newRoot = ltree->insertBlock(position, &lPath);
-    if (newRoot != nullptr) {
-        ltree = newRoot;
+    for (unsigned long i = 0; i < levels.blockSize(levels.height()); i += BLOCK_SIZE) {
+        unshareLtreePath(position);
+        LTree *newRoot = ltree->insertBlock(position, &lPath, &lNodes);
+        if (newRoot != nullptr) {
+            ltree = newRoot;
+            lPath.clear();
+        }
     }
-    lPath.clear();
 }
 
-void DKTree::deleteBlockTtree(unsigned long position) {
-    TTree *newRoot = ttree->deleteBlock(position, &tPath);
-    if (newRoot != nullptr) {
-        ttree = newRoot;
+void DKTree::deleteBlockTtree(unsigned long position, unsigned long iteration) {
+    for (unsigned long i = 0; i < levels.blockSize(iteration); i += BLOCK_SIZE) {
+        unshareTtreePath(position);
+        TTree *newRoot = ttree->deleteBlock(position, &tPath, &tNodes);
+        if (newRoot != nullptr) {
+            ttree = newRoot;
+            tPath.clear();
+        }
     }
-    tPath.clear();
+    levelBlocks[iteration - 1]--;
+    updateLevelStarts();
 }
 
-void DKTree::deleteBlockLtree(unsigned long position) {
-    LTree *newRoot = ltree->deleteBlock(position, &lPath);
-    if (newRoot != nullptr) {
-        ltree = newRoot;
+void DKTree::setLeafPattern(unsigned long leaf, u64 pattern) {
+    unsigned long code = leafCodes->get(leaf);
+    if (pattern == vocabulary->pattern(code)) {
+        return;
     }
-    lPath.clear();
+    if (pattern == 0) {
+        leafCodes->erase(leaf);
+    } else {
+        leafCodes->set(leaf, vocabulary->acquire(pattern));
+    }
+    vocabulary->release(code);
 }
 
-unsigned long DKTree::memoryUsage() {
-    unsigned long base = sizeof(DKTree),
-        tSize = ttree->memoryUsage(),
-        tBits = ttree->bits(),
-        lSize = ltree->memoryUsage(),
-        lBits = ltree->bits(),
-        tPathSize = tPath.size() * sizeof(Nesbo),
-        lPathSize = lPath.size() * sizeof(LNesbo),
-        freeSize = freeColumns.size() * sizeof(unsigned long);
+void DKTree::deleteBlockLtree(unsigned long position) {
+    for (unsigned long i = 0; i < levels.blockSize(levels.height()); i += BLOCK_SIZE) {
+        unshareLtreePath(position);
+        LTree *newRoot = ltree->deleteBlock(position, &lPath, &lNodes);
+        if (newRoot != nullptr) {
+            ltree = newRoot;
+            lPath.clear();
+        }
+    }
+}
 
-    printf("  TTree: %lu\n", tSize);
-    printf("    Of which bitvector: %lu\n", (tBits + 7) / 8);
+MemoryStats DKTree::memoryStats() const {
+    // Every leaf stores its number of bits and the number of ones in each word
+    unsigned long leaves = tNodes.leaves + lNodes.leaves,
+        leafCounters = sizeof(BitVector<>::bits) + sizeof(BitVector<>::block_counts);
 
-    printf("  LTree: %lu\n", lSize);
-    printf("    Of which bitvector: %lu\n", (lBits + 7) / 8);
+    MemoryStats stats;
+    stats.payload = (ttree->bits() + ltree->bits() + 7) / 8;
+    stats.counters = leaves * leafCounters;
+    stats.leafSlack = tNodes.leaves * sizeof(LeafNode) + lNodes.leaves * sizeof(LLeafNode)
+                      - stats.payload - stats.counters;
+    stats.internalNodes = tNodes.internalNodes * sizeof(InternalNode) + lNodes.internalNodes * sizeof(LInternalNode);
+    stats.nodeHeaders = (tNodes.leaves + tNodes.internalNodes) * sizeof(TTree)
+                        + (lNodes.leaves + lNodes.internalNodes) * sizeof(LTree);
+    // Every node is two allocations, the TTree/LTree and its leaf or internal node
+    stats.allocatorSlack = tNodes.leaves * (allocationSize(sizeof(LeafNode)) - sizeof(LeafNode))
+                           + lNodes.leaves * (allocationSize(sizeof(LLeafNode)) - sizeof(LLeafNode))
+                           + tNodes.internalNodes * (allocationSize(sizeof(InternalNode)) - sizeof(InternalNode))
+                           + lNodes.internalNodes * (allocationSize(sizeof(LInternalNode)) - sizeof(LInternalNode))
+                           + (tNodes.leaves + tNodes.internalNodes) * (allocationSize(sizeof(TTree)) - sizeof(TTree))
+                           + (lNodes.leaves + lNodes.internalNodes) * (allocationSize(sizeof(LTree)) - sizeof(LTree));
+    stats.paths = tPath.capacity() * sizeof(Nesbo) + lPath.capacity() * sizeof(LNesbo);
+    stats.freeList = freeColumns.capacity() * sizeof(unsigned long);
+    if (vocabulary) {
+        stats.vocabulary = vocabulary->memoryUsage() + leafCodes->memoryUsage();
+    }
+    stats.base = sizeof(DKTree);
+    return stats;
+}
 
-    printf("  TPath: %lu\n", tPathSize);
-    printf("  LPath: %lu\n", lPathSize);
-    printf("  Free Columns: %lu\n", freeSize);
-    return base + tSize + lSize + tPathSize + lPathSize + freeSize;
+unsigned long DKTree::memoryUsage() const {
+    return memoryStats().total();
 }
@@ -9,9 +9,13 @@
 #include <utility>
 #include <bits/stdc++.h>
 
-#include "TTree.cpp"
-#include "LTree.cpp"
-#include "parameters.cpp"
+#include "TTree.h"
+#include "LTree.h"
+#include "CodeSequence.h"
+#include "LeafVocabulary.h"
+#include "LevelTable.h"
+#include "VertexSet.h"
+#include "parameters.h"
 
 // a class that contains a vector of entries in the matrix
 // with a start and end such that the entries at index start <= i < end are all in the same block at when
@@ -25,13 +29,52 @@ public:
     unsigned long firstAt;
 
     // constructor for a first iteration, it includes the whole vector and always starts at the first bit of the ttree
-    explicit VectorData(vector<unsigned long> &aEntry)
+    explicit VectorData(const vector<unsigned long> &aEntry)
             : entry(aEntry), start(0), end(aEntry.size()), iteration(1), firstAt(0) {}
 
     VectorData(VectorData &vectorData, unsigned long aStart, unsigned long aEnd, unsigned long aIteration, unsigned long aFirstAt)
             : entry(vectorData.entry), start(aStart), end(aEnd), iteration(aIteration), firstAt(aFirstAt) {}
 };
 
+// the state of one thread of a matrix-vector multiplication: the input and output vectors, the range of
+// output entries it is responsible for, and its own cached paths, so that threads never share any state.
+// The blocks of every level are visited from left to right, so a separate path is cached for every level
+struct MultiplyTask {
+    const vector<double> &x;
+    vector<double> &y;
+    bool transposed; // computes y += A^T x instead of y += A x
+    unsigned long first; // the first output entry of the task
+    unsigned long end; // one past the last output entry of the task
+    vector<vector<Nesbo>> tPaths;
+    vector<LNesbo> lPath;
+    // inside a subtree that is walked completely, the blocks of every level are visited in order, so the
+    // position of the next child block of every level is kept here instead of computed by a rank, 0 if unknown
+    vector<unsigned long> nextChild;
+
+    MultiplyTask(const vector<double> &aX, vector<double> &aY, bool aTransposed, unsigned long aFirst,
+                 unsigned long aEnd, unsigned long height)
+            : x(aX), y(aY), transposed(aTransposed), first(aFirst), end(aEnd), tPaths(height + 1),
+              nextChild(height + 2, 0) {}
+};
+
+class DKTree;
+
+/// The position of a block that is missing in one of the trees of a co-traversal
+constexpr unsigned long NO_BLOCK = ~0ul;
+
+// one of the two trees of a co-traversal by `DKTree::combine`, with a cached path for every level, since the
+// blocks of every level are read from left to right. If the tree is lower than the other one, it is extended
+// with `missingLevels` levels above its root, in which only the top left submatrix, its own matrix, is in use
+struct CoTraversalSide {
+    const DKTree *tree;
+    unsigned long missingLevels;
+    bool empty; // whether the tree has no edges at all
+    vector<vector<Nesbo>> tPaths;
+    vector<LNesbo> lPath;
+    // the position of the next child block of every level, as in `MultiplyTask`, 0 if unknown because a
+    // subtree of this tree was skipped
+    vector<unsigned long> nextChild;
+};
 
 class DKTree final {
 
@@ -43,15 +86,43 @@ private:
     vector<LNesbo> lPath;
     std::vector<unsigned long> freeColumns; // contains the entries in the matrix  below firstFreeColumn that are not in use
     unsigned long firstFreeColumn; // the lowest index above the used entries
-    unsigned long matrixSize; // current size of the matrix, is a power of k
+    unsigned long matrixSize; // current size of the matrix, the product of the arities of all levels
+    NodeCounts tNodes; // the number of nodes in the ttree, see `NodeCounts`
+    NodeCounts lNodes; // the number of nodes in the ltree
+    LevelTable levels; // the arity, block size and partition size of every level
+    vector<unsigned long> levelBlocks; // the number of blocks in every level of the ttree
+    vector<unsigned long> levelStarts; // the position of the first bit of every level, including the ltree level
+    vector<unsigned long> blocksAbove; // the number of ttree blocks in the levels above every level
+    LeafVocabulary *vocabulary = nullptr; // the distinct leaf submatrices in vocabulary mode, nullptr otherwise
+    CodeSequence *leafCodes = nullptr; // the vocabulary code of every leaf in vocabulary mode, nullptr otherwise
+    // the number of trees that may share nodes with this one, itself included, see `snapshot`, nullptr before
+    // the first snapshot. A tree decrements it after it released its nodes
+    std::shared_ptr<std::atomic<unsigned long>> nodeSharers;
+    // whether `parent` of some nodes may point to a node of another tree, since this tree shared nodes
+    bool staleParents = false;
 
 public:
 
     // initialises a tree for a matrix of size k^4
     DKTree();
 
-    // initialises a dktree for a matrix of size k^power
-    explicit DKTree(unsigned long power);
+    /**
+     * Initialises a dktree for a matrix of size k^power
+     * @param vocabulary whether to use vocabulary mode: instead of storing the
+     *        leaves in the ltree, every VOCABULARY_K by VOCABULARY_K leaf
+     *        submatrix is stored as a variable length code into a vocabulary of
+     *        the distinct leaf submatrices
+     * @throws illegal argument exception if vocabulary mode is used for a
+     *         matrix smaller than k * VOCABULARY_K
+     */
+    explicit DKTree(unsigned long power, bool vocabulary = false);
+
+    /**
+     * Initialises a dktree whose levels have the arities of the given table
+     * @param vocabulary whether to use vocabulary mode, which needs a leaf level of arity VOCABULARY_K
+     * @throws illegal argument exception if vocabulary mode is used with another leaf arity
+     */
+    explicit DKTree(const LevelTable &levels, bool vocabulary = false);
 
     ~DKTree();
 
@@ -87,6 +158,20 @@ public:
      */
     void deleteEntry(unsigned long a);
 
+    /**
+     * Removes all edges from and to a, including a self-loop, while a stays present in the matrix
+     * @param a the column/row whose edges are removed
+     * @throws illegal argument exception if a is not present in the matrix
+     */
+    void clearEntry(unsigned long a);
+
+    /**
+     * Makes all columns/rows below size present at once, growing the matrix if needed, as if `insertEntry`
+     * was called until the first free column is size. Columns that were deleted stay free
+     * @param size the new first free column, nothing happens if it is not larger than the current one
+     */
+    void extendTo(unsigned long size);
+
 
     /**
      * Reports all edges between a element of A, and b element of B.
@@ -107,27 +192,314 @@ public:
      */
     bool reportEdge(unsigned long a, unsigned long b);
 
+    /**
+     * Reports all successors of a, the columns of the edges in row a
+     * @param a the vertex whose successors are reported
+     * @return the successors of a in increasing order
+     * @throws illegal argument exception if a is not present in the matrix
+     */
+    vector<unsigned long> reportSuccessors(unsigned long a);
+
+    /**
+     * Reports all predecessors of b, the rows of the edges in column b
+     * @param b the vertex whose predecessors are reported
+     * @return the predecessors of b in increasing order
+     * @throws illegal argument exception if b is not present in the matrix
+     */
+    vector<unsigned long> reportPredecessors(unsigned long b);
+
+    /**
+     * Reports the common successors of a and b, the columns with an edge from both a and b. The rows of a
+     * and b are descended in lockstep, and a column stripe is pruned as soon as either row has a 0-bit for
+     * it, so the successors of a and b are never listed separately
+     * @return the common successors of a and b in increasing order
+     * @throws illegal argument exception if a or b is not present in the matrix
+     */
+    vector<unsigned long> intersectSuccessors(unsigned long a, unsigned long b);
+
+    /**
+     * Counts the common successors of a and b in the same way as `intersectSuccessors`, without listing them
+     * @throws illegal argument exception if a or b is not present in the matrix
+     */
+    unsigned long countCommonSuccessors(unsigned long a, unsigned long b);
+
+    /**
+     * Appends the successors of all vertices in the frontier to next. Instead of
+     * querying every row separately, the tree is descended once for the whole
+     * frontier: at every level the rows are split on their offset, so a block is
+     * read only once for all frontier rows that pass through it.
+     * @param frontier the rows to expand, sorted and without doubles
+     * @param next to store the successors found and contains vertices already found
+     * @param visited if not nullptr, only successors that are not in visited are
+     *        appended, and they are added to it, so every vertex is appended once
+     * @throws illegal argument exception if the frontier is not sorted or contains
+     *         a vertex that is not below the first free column
+     */
+    void expandFrontier(const vector<unsigned long> &frontier, vector<unsigned long> &next,
+                        VertexSet *visited = nullptr);
+
+    /**
+     * The pull step of a breadth-first search: finds the candidates that have a
+     * predecessor in the frontier. The tree is descended once for all candidates
+     * and frontier rows, splitting them on their column and row offsets at every
+     * level, so only the blocks that contain both a candidate and a frontier row are
+     * read. The search for a candidate stops at its first predecessor in the frontier,
+     * so when the frontier is large most candidates are settled after reading only a
+     * few blocks.
+     * @param frontier the rows of the frontier, sorted and without doubles
+     * @param candidates the columns to check, sorted and without doubles, normally all unvisited vertices
+     * @param next to store the candidates that have a predecessor in the frontier
+     * @param visited the vertices found so far, candidates already in it are skipped,
+     *        and the candidates found are added to it
+     * @throws illegal argument exception if the frontier or the candidates are not sorted
+     *         or not below capacity(), or if the visited set is smaller than capacity()
+     */
+    void expandFrontierPull(const vector<unsigned long> &frontier, const vector<unsigned long> &candidates,
+                            vector<unsigned long> &next, VertexSet &visited);
+
     /**
     * prints the leaf nodes of the ttree and the ltree
     */
     void printtt();
 
-    DKTree(const DKTree &) = delete; // not allowed to use the copy constructor
+    /**
+     * Returns a breakdown of the memory used by this tree. The node counts are
+     * kept up to date by every update, so this takes constant time
+     */
+    MemoryStats memoryStats() const;
+
+    /**
+     * @return the total number of bytes used by this tree, equal to memoryStats().total()
+     */
+    unsigned long memoryUsage() const;
+
+    /**
+     * Makes sure that the matrix has room for at least n rows/columns, so that
+     * inserting entries up to that number never has to grow the matrix
+     * @param n the number of rows/columns to reserve space for
+     */
+    void reserve(unsigned long n);
+
+    /**
+     * Returns a new tree with the edges that are in this tree, in other, or in both. The two trees are
+     * traversed together level by level, and the blocks of the result are passed to the same bottom-up
+     * builder as `fromEdges`, so this takes time proportional to the compressed size of the trees.
+     * The result has the level arities and vocabulary mode of the higher of the two trees, and contains
+     * the vertices of both.
+     * @throws illegal argument exception if the arities of the levels of the trees do not match, counting
+     *         from the leaves
+     */
+    DKTree *unite(const DKTree &other) const;
+
+    /**
+     * Returns a new tree with the edges that are in both this tree and other, see `unite`. Subtrees that are
+     * missing in either tree are skipped, and the vertices of the result are those present in both
+     * @throws illegal argument exception if the arities of the levels of the trees do not match
+     */
+    DKTree *intersect(const DKTree &other) const;
+
+    /**
+     * Returns a new tree with the edges of this tree that are not in other, see `unite`. The vertices of
+     * the result are those of this tree
+     * @throws illegal argument exception if the arities of the levels of the trees do not match
+     */
+    DKTree *subtract(const DKTree &other) const;
+
+    /**
+     * Returns a new tree with the transposed adjacency matrix, which has an edge (b, a) for every edge (a, b)
+     * of this tree. Transposing swaps the row and column offset of every bit of a block (see
+     * `calculateOffset`), which changes the order of the children of the block. The levels are read once
+     * from left to right, the children of every block are found by counting the 1-bits of the blocks
+     * before it, and the permuted blocks are passed to the bottom-up builder, so no edge is inserted
+     * one by one. The result has the level arities, vocabulary mode and vertices of this tree
+     */
+    DKTree *transposed() const;
+
+    /**
+     * Returns a snapshot of this tree, a new tree with the same edges that shares all nodes of the ttree and
+     * ltree with this tree, so it takes constant time. From then on, a change to either tree first copies the
+     * shared nodes on the root-to-leaf path it touches (see `TTree::unsharePath`), so the other tree never sees
+     * it, and a node is freed by the last tree that refers to it. A snapshot can therefore be queried by one
+     * other thread while this tree keeps changing, but trees that share nodes must not be changed by different
+     * threads at the same time. Taking a snapshot of a snapshot does not change it, so several threads may do
+     * so at the same time. In vocabulary mode the leaf codes are copied instead of shared. The memory
+     * statistics of both trees include the shared nodes
+     * @return the snapshot, to be deleted by the caller
+     */
+    DKTree *snapshot();
+
+    /**
+     * Multiplies the adjacency matrix with a vector, y = A x, so y[a] is the sum of x[b] over all edges (a, b).
+     * The tree is walked once in depth-first order, and the contributions of a leaf block are summed per
+     * row before they are added to y. The rows are divided into stripes of the partitions of one level,
+     * which are walked by different threads: every thread writes only to the entries of y of its own
+     * stripes, so no atomics or locks are needed, and the memory used is only that of the vectors.
+     * @param x one value for every vertex
+     * @param threads the maximum number of threads to use, 0 means one per hardware thread
+     * @return y, with the same size as x
+     * @throws illegal argument exception if x has less values than vertexBound()
+     */
+    vector<double> multiply(const vector<double> &x, unsigned int threads = 0);
+
+    /**
+     * Multiplies the transposed adjacency matrix with a vector, y = A^T x, so y[b] is the sum of x[a]
+     * over all edges (a, b). This walks the tree in the same way as `multiply`, but divides the columns
+     * among the threads instead of the rows
+     * @throws illegal argument exception if x has less values than vertexBound()
+     */
+    vector<double> multiplyTransposed(const vector<double> &x, unsigned int threads = 0);
 
-    unsigned long memoryUsage();
+    /**
+     * @return one more than the highest vertex in use, so all vertices are below this number
+     */
+    unsigned long vertexBound() const {
+        return firstFreeColumn;
+    }
+
+    /// @return the rows/columns below vertexBound() that are not in use, in increasing order
+    const vector<unsigned long> &freeEntries() const {
+        return freeColumns;
+    }
 
-    static DKTree *withSize(unsigned long size) {
-        unsigned long n = 1, power = 0;
-        while (n < size) {
-            power++;
-            n *= k;
+    /**
+     * Marks the given rows/columns below vertexBound() as not in use, so that `insertEntry` hands them out
+     * again as after `deleteEntry`. This restores the vertices of a tree that is built from its edges
+     * @param entries rows/columns without edges, in increasing order, replacing the current free entries
+     * @throws illegal argument exception if the entries are not increasing or not below vertexBound()
+     */
+    void setFreeEntries(const vector<unsigned long> &entries);
+
+    /**
+     * @return the number of rows/columns that fit in the matrix without growing it
+     */
+    unsigned long capacity() const {
+        return matrixSize;
+    }
+
+    /// @return whether the leaves are stored as codes into a vocabulary
+    bool usesVocabulary() const {
+        return vocabulary != nullptr;
+    }
+
+    /// @return the arity, block size and partition size of every level
+    const LevelTable &levelTable() const {
+        return levels;
+    }
+
+    /**
+     * Creates an empty DKTree with room for `size` vertices
+     * @param vocabulary whether to use vocabulary mode, which overrides the leaf arity with VOCABULARY_K
+     * @param shape the arities of the levels, k for every level by default
+     */
+    static DKTree *withSize(unsigned long size, bool vocabulary = false, Arities shape = Arities()) {
+        if (vocabulary) {
+            shape.leaf = VOCABULARY_K;
         }
-        auto result = new DKTree(power);
+        auto result = new DKTree(LevelTable::forSize(size, shape), vocabulary);
         result->firstFreeColumn = size;
         return result;
     }
 
+    /**
+     * Builds a DKTree with `size` vertices containing exactly the given edges.
+     * Instead of adding the edges one by one, the edges are sorted in the order
+     * of the leaves of the k2-tree, after which the bits of every level are
+     * written in one pass and the TTree and LTree are built bottom-up.
+     *
+     * @param size the number of vertices, which get the ids 0 ... size - 1
+     * @param edges the edges of the graph, duplicates are allowed
+     * @param vocabulary whether to use vocabulary mode, in which the most
+     *        frequent leaf submatrices get the shortest codes
+     * @param shape the arities of the levels, k for every level by default
+     * @return a DKTree containing exactly the given edges
+     * @throws illegal argument exception if an edge has an endpoint >= size, or
+     *         if the matrix is too large to be bulk-loaded
+     */
+    static DKTree *fromEdges(unsigned long size, const vector<std::pair<unsigned long, unsigned long>> &edges,
+                             bool vocabulary = false, Arities shape = Arities());
+
 private:
+    // the operations of `combine`
+    enum SetOperation {
+        UNION, INTERSECTION, DIFFERENCE
+    };
+
+    /**
+     * Builds a DKTree bottom-up from the blocks of every level, as `fromEdges` and `combine` do. The blocks of
+     * a level are k^2-bit patterns in the order of the 1-bits of the level above them, and are freed while
+     * building. The first free column of the result is 0
+     * @param levels the arities of the levels
+     * @param blocks the blocks of every level, starting with the root block
+     * @param vocabulary whether to store the leaf level in vocabulary mode
+     */
+    static DKTree *fromLevelBlocks(const LevelTable &levels, vector<vector<u64>> &blocks, bool vocabulary);
+
+    /**
+     * Computes the union, intersection or difference of this tree and other, see `unite`
+     */
+    DKTree *combine(const DKTree &other, SetOperation operation) const;
+
+    /**
+     * Combines the blocks of both trees at the given level and their subtrees, and appends the non-empty
+     * blocks of the result to `result`, the children before their parents
+     * @param positionA the position of the block of a, or NO_BLOCK if a has no block here
+     * @param positionB the position of the block of b, or NO_BLOCK if b has no block here
+     * @param iteration the level of the blocks in the result
+     * @return the block of the result, 0 if it has no edges
+     */
+    u64 combineBlocks(SetOperation operation, CoTraversalSide &a, unsigned long positionA, CoTraversalSide &b,
+                      unsigned long positionB, unsigned long iteration, vector<vector<u64>> &result) const;
+
+    /**
+     * Reads the k^2 bits of a block, from the ttree, the ltree or the vocabulary
+     * @param position the position of the first bit of the block
+     * @param iteration the level of the block
+     * @param tPaths a cached path for every level of the ttree
+     * @param lPath a cached path for the ltree
+     */
+    u64 readBlock(unsigned long position, unsigned long iteration, vector<vector<Nesbo>> &tPaths,
+                  vector<LNesbo> &lPath) const;
+
+    // initialises a dktree from an already built ttree with the given number of blocks in every level
+    // and ltree, and in vocabulary mode an already built vocabulary and leaf codes
+    DKTree(TTree *ttree, LTree *ltree, const LevelTable &levels, const vector<unsigned long> &levelBlocks,
+           LeafVocabulary *vocabulary = nullptr, CodeSequence *leafCodes = nullptr);
+
+    // shares the nodes of other, only used by `snapshot`
+    DKTree(const DKTree &other);
+
+    // switches an empty tree to vocabulary mode, only used by the constructors
+    void initVocabulary(LeafVocabulary *aVocabulary, CodeSequence *aLeafCodes);
+
+    // recomputes levelStarts and blocksAbove from levelBlocks, after every change to the blocks of the ttree
+    void updateLevelStarts();
+
+    /**
+     * Calculates the position of the first bit of the child block of a 1-bit. The
+     * children of a level are stored in the order of their parents, so this is the
+     * start of the next level plus the number of 1-bits of this level before the
+     * bit, times the block size of the next level
+     * @param position the position of a 1-bit in the ttree
+     * @param iteration the level of that bit
+     * @return the position of the child block, which is in the ltree if it is at least ttree->bits()
+     */
+    unsigned long childPosition(unsigned long position, unsigned long iteration) {
+        return childPosition(position, iteration, &tPath);
+    }
+
+    // calculates the position of the child block of a 1-bit like above, caching the path in `path`
+    unsigned long childPosition(unsigned long position, unsigned long iteration, vector<Nesbo> *path) const;
+
+    /**
+     * Replaces the pattern of a leaf in vocabulary mode, or removes the leaf if the new pattern is empty
+     * @param leaf the index of the leaf
+     * @param pattern the new pattern of the leaf
+     */
+    void setLeafPattern(unsigned long leaf, u64 pattern);
+
+    // counts the nodes of the ttree and ltree by walking them, only used by the constructors
+    void countNodes();
+
     /**
     * prints the leaf nodes of the input TTree
     * @param tree the tree to be printed
@@ -141,7 +513,8 @@ private:
     void printltree(LTree *tree, unsigned long depth = 0);
 
     /**
-    * Calculates the offset of a row and column in a block at iteration iteration
+    * Calculates the offset of a row and column in a block at iteration iteration. In
+    * vocabulary mode, the offset at the leaf level is the bit in the pattern of the leaf
     * @param row the row in the matrix
     * @param column the column in the matrix
     * @param iteration the iteration for which the offset needs to be calculated
@@ -150,7 +523,8 @@ private:
     unsigned long calculateOffset(unsigned long row, unsigned long column, unsigned long iteration);
 
     /**
-     * Increase the size of the matrix, new matrixSize = oldMatrixSize * k
+     * Increase the size of the matrix by adding a new root level with the arity of the current root,
+     * new matrixSize = oldMatrixSize * levels.arity(1)
      */
     void increaseMatrixSize();
 
@@ -162,26 +536,50 @@ private:
     void checkArgument(unsigned long a, std::string functionName);
 
     /**
-     * Inserts a block 4 0's (0000) at position position in the ttree
+     * Inserts a block of 0's at position position in the ttree
      * @param position the place at which the block of 0's should be inserted
+     * @param iteration the level of the block, which determines its size
      */
-    void insertBlockTtree(unsigned long position);
+    void insertBlockTtree(unsigned long position, unsigned long iteration);
+
+    // whether another tree may still share nodes with this one, which is no longer the case once all trees that
+    // were forked from this one or that this one was forked from, directly or indirectly, are deleted
+    bool sharesNodes() const {
+        return nodeSharers && nodeSharers->load(std::memory_order_acquire) > 1;
+    }
+
+    // copies the nodes that are shared with a snapshot on the path to the given position of the ttree, before
+    // it is changed
+    void unshareTtreePath(unsigned long position);
+
+    // copies the shared nodes on the path to the given position of the ltree, like above
+    void unshareLtreePath(unsigned long position);
+
+    // points the parents of all nodes back to this tree once it no longer shares nodes, see `TTree::restoreParents`
+    void restoreParents();
+
+    // sets a bit of the ttree, after copying the nodes on its path that are shared with a snapshot
+    void setTtreeBit(unsigned long position, bool value);
+
+    // sets a bit of the ltree, after copying the nodes on its path that are shared with a snapshot
+    void setLtreeBit(unsigned long position, bool value);
 
     /**
-     * Inserts a block 4 0's (0000) at position position in the tree
+     * Inserts a block of 0's of the leaf level at position position in the ltree
      * @param position the place at which the block of 0's should be inserted
      */
     void insertBlockLtree(unsigned long position);
 
     /**
-     * Deletes 4 bits starting at position position in the ttree
-     * @param position the place from which 4 bits should be deleted
+     * Deletes the block starting at position position in the ttree
+     * @param position the place from which the block should be deleted
+     * @param iteration the level of the block, which determines its size
      */
-    void deleteBlockTtree(unsigned long position);
+    void deleteBlockTtree(unsigned long position, unsigned long iteration);
 
     /**
-     * Deletes 4 bits starting at position position in the ltree
-     * @param position the place from which 4 bits should be deleted
+     * Deletes the leaf level block starting at position position in the ltree
+     * @param position the place from which the block should be deleted
      */
     void deleteBlockLtree(unsigned long position);
 
@@ -242,17 +640,135 @@ private:
   */
     void sortAndCheckVector(vector<unsigned long> &element);
 
+    /**
+     * Appends the columns of the edges from rows in rows to columns in the submatrix
+     * of this level that starts at column `column`, see `expandFrontier`
+     * @param rows the rows to expand, the first bit of their block is rows.firstAt
+     * @param column the first column of the submatrix of the block
+     * @param next to store the successors found
+     * @param visited if not nullptr, the successors already found, which are skipped
+     */
+    void expandRows(VectorData &rows, unsigned long column, vector<unsigned long> &next, VertexSet *visited);
+
+    /**
+     * Expands the rows in a ttree level with arity K, which is a template argument
+     * so that the loops over the offsets of a block are unrolled, see `expandRows`
+     */
+    template<unsigned long K>
+    void expandRowsInTTree(VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                           VertexSet *visited);
+
+    /**
+     * Appends the rows of the edges in column b within the block at firstAt to predecessors, descending
+     * only the column stripe of b at every level
+     */
+    void reportColumn(unsigned long b, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                      vector<unsigned long> &predecessors);
+
+    /// Expands the rows in a block of the leaf level, see `expandRows`
+    void expandRowsInLTree(const VectorData &rows, unsigned long column, vector<unsigned long> &next,
+                           VertexSet *visited);
+
+    /**
+     * Finds the columns in columns that have an edge from a row in rows, see `expandFrontierPull`
+     * @param rows the frontier rows in the block, the first bit of their block is rows.firstAt
+     * @param columns the candidate columns in the same block
+     * @return the number of candidates found
+     */
+    unsigned long pullColumns(VectorData &rows, VectorData &columns, vector<unsigned long> &next,
+                              VertexSet &visited);
+
+    /**
+     * Pulls the columns in a ttree level with arity K, which is a template argument
+     * so that the loops over the offsets of a block are unrolled, see `pullColumns`
+     */
+    template<unsigned long K>
+    unsigned long pullColumnsInTTree(VectorData &rows, VectorData &columns, vector<unsigned long> &next,
+                                     VertexSet &visited);
+
+    /**
+     * Descends the rows a and b in lockstep, see `intersectSuccessors`
+     * @param firstA the position of the first bit of the block of row a
+     * @param firstB the position of the first bit of the block of row b
+     * @param iteration the level of both blocks
+     * @param column the first column of the submatrix of both blocks
+     * @param common if not nullptr, to store the common successors found
+     * @return the number of common successors in the blocks
+     */
+    unsigned long intersectRows(unsigned long a, unsigned long b, unsigned long firstA, unsigned long firstB,
+                                unsigned long iteration, unsigned long column, vector<unsigned long> *common);
+
+    /**
+     * Descends the rows a and b in lockstep in a ttree level with arity K, which is a template argument so
+     * that the loop over the column offsets is unrolled, see `intersectRows`
+     */
+    template<unsigned long K>
+    unsigned long intersectRowsInTTree(unsigned long a, unsigned long b, unsigned long firstA, unsigned long firstB,
+                                       unsigned long iteration, unsigned long column, vector<unsigned long> *common);
+
+    /// Intersects the rows a and b in blocks of the leaf level, see `intersectRows`
+    unsigned long intersectRowsInLTree(unsigned long a, unsigned long b, unsigned long firstA, unsigned long firstB,
+                                       unsigned long iteration, unsigned long column, vector<unsigned long> *common);
+
+    /**
+     * Multiplies the matrix with a vector for the output entries of one or more threads, see `multiply`
+     * @param x the input vector
+     * @param y the output vector, to which the products are added
+     * @param transposed whether to multiply with the transposed matrix
+     * @param threads the maximum number of threads to use, 0 means one per hardware thread
+     * @throws illegal argument exception if x has less values than vertexBound()
+     */
+    void multiplyInStripes(const vector<double> &x, vector<double> &y, bool transposed, unsigned int threads);
+
+    /**
+     * Adds the products of the block starting at firstAt to the output entries of the task
+     * @param firstAt the position of the first bit of the block
+     * @param iteration the level of the block
+     * @param row the first row of the submatrix of the block
+     * @param column the first column of the submatrix of the block
+     * @param whole whether all output entries of the block belong to the task, so that it is walked completely
+     */
+    void multiplyBlock(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                       unsigned long column, bool whole);
+
+    /**
+     * Multiplies a block of a ttree level with arity K, which is a template argument so that the loops
+     * over the offsets of a block are unrolled, see `multiplyBlock`
+     */
+    template<unsigned long K>
+    void multiplyInTTree(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                         unsigned long column, bool whole);
+
+    /// Multiplies a block of the leaf level, see `multiplyBlock`
+    void multiplyInLTree(MultiplyTask &task, unsigned long firstAt, unsigned long iteration, unsigned long row,
+                         unsigned long column);
+
+    /// Pulls the columns in a block of the leaf level, see `pullColumns`
+    unsigned long pullColumnsInLTree(const VectorData &rows, const VectorData &columns, vector<unsigned long> &next,
+                                     VertexSet &visited);
+
 /**
    * For each offset calculate the first and last entry in the vector belonging to that offset, or -1 if none
-   * @param entries to be split on offset
-   * @param partitionSize number of rows/columns belonging to each offset
+   * @tparam K the arity of the level entries.iteration
    * @param entryStart to be filled with the start index for each offset or -1 if none
    * @param entryEnd to be filled with the end index for each offset or -1 if none
    */
+    template<unsigned long K>
     void
-    splitEntriesOnOffset(const VectorData &entries, unsigned long partitionSize, int *entryStart,
+    splitEntriesOnOffset(const VectorData &entries, int *entryStart,
                          int *entryEnd) const;
 
+    /**
+   * Finds all edges from row element of rows to column element of columns in a ttree level with arity K,
+   * which is a template argument so that the loop over the K * K offsets of a block is unrolled
+   * @param rows the rows in the matrix of the edges to be found
+   * @param columns the columns in the matrix of the edges to be found
+   * @param findings to store the edges found and contains edges already found
+   */
+    template<unsigned long K>
+    void findEdgesInTTree(VectorData &rows, VectorData &columns,
+                          vector<std::pair<unsigned long, unsigned long>> &findings);
+
     /**
    * Finds all edges from row element of rows to column element of columns and stores them in findings
    * @param rows the rows in the matrix of the edges to be found
@@ -270,6 +786,15 @@ private:
    */
     bool deleteEdges(VectorData &rows, VectorData &columns);
 
+    /**
+   * Deletes all edges from row in rows to column in columns in a ttree level with arity K
+   * @param rows the rows in the matrix of the edges to be deleted
+   * @param columns the columns in the matrix of the edges to be deleted
+   * @return true if after deleting this block has only 0's, false otherwise
+   */
+    template<unsigned long K>
+    bool deleteEdgesFromTTree(VectorData &rows, VectorData &columns);
+
     /**
    * Deletes all edges from row in rows to column in columns from the ltree
    * @param rows the rows in the matrix of the edges to be deleted
@@ -0,0 +1,528 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include "DKTree.h"
+#include "DurableDKTree.h"
+#include "EpochDKTree.h"
+#include "GraphGenerator.h"
+#include "GraphTraversal.h"
+#include "K2TripleStore.h"
+#include "ShardedDKTree.h"
+#include "TemporalGraph.h"
+#include "BenchCommon.h"
+
+/// A benchmark graph together with the edges it was built from
+struct BenchGraph {
+    DKTree *tree;
+    vector<std::pair<unsigned long, unsigned long>> edges;
+};
+
+/**
+ * Returns a graph of the given kind with `size` vertices and about
+ * `size * density` edges. Graphs are built once and shared by all benchmarks
+ * with the same arguments, benchmarks that modify a graph restore it afterwards
+ */
+static BenchGraph &benchGraph(unsigned long size, unsigned long density, GraphKind kind) {
+    static std::map<std::tuple<unsigned long, unsigned long, GraphKind>, BenchGraph> graphs;
+    auto &graph = graphs[std::make_tuple(size, density, kind)];
+    if (graph.tree == nullptr) {
+        graph.edges = generateGraph(kind, size, density, size * 31 + density);
+        graph.tree = DKTree::fromEdges(size, graph.edges);
+    }
+    return graph;
+}
+
+/**
+ * Returns the cells of a matrix in the given pattern, without duplicates
+ */
+static vector<std::pair<unsigned long, unsigned long>>
+uniqueCells(AccessPattern pattern, unsigned long count, unsigned long size, unsigned long seed) {
+    auto cells = accessCells(pattern, count, size, seed);
+    std::set<std::pair<unsigned long, unsigned long>> seen;
+    vector<std::pair<unsigned long, unsigned long>> result;
+    for (auto &cell : cells) {
+        if (seen.insert(cell).second) {
+            result.push_back(cell);
+        }
+    }
+    return result;
+}
+
+// All DKTree benchmarks take the number of vertices, the average number of edges
+// per vertex, the access pattern and the kind of graph as arguments
+
+static BenchGraph &benchGraph(benchmark::State &state) {
+    return benchGraph(state.range(0), state.range(1), (GraphKind) state.range(3));
+}
+
+static void setLabel(benchmark::State &state) {
+    state.SetLabel(std::string(GRAPH_KIND_NAMES[state.range(3)]) + "/" + ACCESS_PATTERN_NAMES[state.range(2)]);
+}
+
+static void BM_DKTreeReportEdge(benchmark::State &state) {
+    auto &graph = benchGraph(state);
+    auto pattern = (AccessPattern) state.range(2);
+    auto cells = accessCells(pattern, BATCH, state.range(0), 3);
+    unsigned long i = 0;
+    for (auto _ : state) {
+        auto &cell = cells[i++ % BATCH];
+        benchmark::DoNotOptimize(graph.tree->reportEdge(cell.first, cell.second));
+    }
+    setThroughput(state, 1);
+    setLabel(state);
+}
+
+// Adds a batch of edges, and removes the ones that were not present before
+// outside of the timed region
+static void BM_DKTreeAddEdge(benchmark::State &state) {
+    auto &graph = benchGraph(state);
+    auto pattern = (AccessPattern) state.range(2);
+    auto cells = uniqueCells(pattern, BATCH, state.range(0), 4);
+    vector<bool> present(cells.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (unsigned long i = 0; i < cells.size(); i++) {
+            present[i] = graph.tree->reportEdge(cells[i].first, cells[i].second);
+        }
+        state.ResumeTiming();
+        for (auto &cell : cells) {
+            graph.tree->addEdge(cell.first, cell.second);
+        }
+        state.PauseTiming();
+        for (unsigned long i = 0; i < cells.size(); i++) {
+            if (!present[i]) {
+                graph.tree->removeEdge(cells[i].first, cells[i].second);
+            }
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, cells.size());
+    setLabel(state);
+}
+
+// Removes a batch of existing edges, and adds them again outside of the timed
+// region. The pattern selects which edges of the (sorted) edge list are removed
+static void BM_DKTreeRemoveEdge(benchmark::State &state) {
+    auto &graph = benchGraph(state);
+    auto pattern = (AccessPattern) state.range(2);
+    auto indices = accessPositions(pattern, BATCH, graph.edges.size(), 5);
+    sort(indices.begin(), indices.end());
+    indices.erase(unique(indices.begin(), indices.end()), indices.end());
+    if (pattern == RANDOM) {
+        std::shuffle(indices.begin(), indices.end(), std::mt19937_64(5));
+    }
+    for (auto _ : state) {
+        for (auto index : indices) {
+            graph.tree->removeEdge(graph.edges[index].first, graph.edges[index].second);
+        }
+        state.PauseTiming();
+        for (auto index : indices) {
+            graph.tree->addEdge(graph.edges[index].first, graph.edges[index].second);
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, indices.size());
+    setLabel(state);
+}
+
+// Reports all successors of one vertex per iteration
+static void BM_DKTreeReportAllEdges(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state);
+    auto pattern = (AccessPattern) state.range(2);
+    auto rows = accessPositions(pattern, BATCH, size, 6);
+    vector<unsigned long> all(size);
+    for (unsigned long i = 0; i < size; i++) {
+        all[i] = i;
+    }
+    unsigned long i = 0, found = 0;
+    for (auto _ : state) {
+        auto result = graph.tree->reportAllEdges({rows[i++ % BATCH]}, all);
+        found += result.size();
+    }
+    setThroughput(state, 1);
+    state.counters["edges"] = benchmark::Counter((double) found, benchmark::Counter::kAvgIterations);
+    setLabel(state);
+}
+
+// A full breadth-first search from the middle vertex per iteration, expanding every level with one descent of
+// the tree, in the direction given by the fourth argument
+static void BM_DKTreeBreadthFirstSearch(benchmark::State &state) {
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    auto direction = (SearchDirection) state.range(3);
+    unsigned long reached = 0;
+    for (auto _ : state) {
+        reached = breadthFirstSearch(*graph.tree, {(unsigned long) state.range(0) / 2}, UNBOUNDED_HOPS, direction)
+                .vertices.size();
+    }
+    state.counters["reached"] = (double) reached;
+    state.SetLabel(std::string(GRAPH_KIND_NAMES[state.range(2)]) + (direction == PUSH ? "/push" : "/optimizing"));
+}
+
+// The same breadth-first search, but querying the successors of every frontier vertex separately
+static void BM_DKTreeBreadthFirstSearchPerVertex(benchmark::State &state) {
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    unsigned long reached = 0;
+    for (auto _ : state) {
+        VertexSet visited(graph.tree->capacity());
+        vector<unsigned long> queue{(unsigned long) state.range(0) / 2};
+        visited.insert(queue[0]);
+        for (unsigned long i = 0; i < queue.size(); i++) {
+            for (unsigned long successor : graph.tree->reportSuccessors(queue[i])) {
+                if (visited.insert(successor)) {
+                    queue.push_back(successor);
+                }
+            }
+        }
+        reached = queue.size();
+    }
+    state.counters["reached"] = (double) reached;
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// One multiplication y = A x per iteration, with the number of threads given by the fourth argument
+static void BM_DKTreeMultiply(benchmark::State &state) {
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    vector<double> x(state.range(0), 1.0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.tree->multiply(x, state.range(3)));
+    }
+    state.SetItemsProcessed(state.iterations() * graph.edges.size());
+    state.SetLabel(std::string(GRAPH_KIND_NAMES[state.range(2)]) + "/" + std::to_string(state.range(3)) + " threads");
+}
+
+static void multiplyArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 17}, {8}, {UNIFORM, RMAT}, {1, 2, 4, 8}});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+// Counts the common successors of two random vertices per iteration, by descending both rows in lockstep
+static void BM_DKTreeCountCommonSuccessors(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    auto rows = accessPositions(RANDOM, BATCH, size, 8);
+    unsigned long i = 0, found = 0;
+    for (auto _ : state) {
+        found += graph.tree->countCommonSuccessors(rows[i % BATCH], rows[(i + 1) % BATCH]);
+        i++;
+    }
+    state.counters["common"] = benchmark::Counter((double) found, benchmark::Counter::kAvgIterations);
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// The same count, by listing the successors of both vertices and intersecting the lists
+static void BM_DKTreeCountCommonSuccessorsByLists(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    auto rows = accessPositions(RANDOM, BATCH, size, 8);
+    unsigned long i = 0, found = 0;
+    vector<unsigned long> common;
+    for (auto _ : state) {
+        auto a = graph.tree->reportSuccessors(rows[i % BATCH]);
+        auto b = graph.tree->reportSuccessors(rows[(i + 1) % BATCH]);
+        common.clear();
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+        found += common.size();
+        i++;
+    }
+    state.counters["common"] = benchmark::Counter((double) found, benchmark::Counter::kAvgIterations);
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// The edges added to a benchmark graph on the next day, a tenth of its edges, of which half were already present
+static vector<std::pair<unsigned long, unsigned long>> nextDayEdges(const BenchGraph &graph, unsigned long size,
+                                                                    GraphKind kind) {
+    auto edges = generateGraph(kind, size, 1, size * 17 + 3);
+    edges.resize(std::min(edges.size(), graph.edges.size() / 20));
+    for (unsigned long i = 0; i < graph.edges.size() / 20; i++) {
+        edges.push_back(graph.edges[i * 7 % graph.edges.size()]);
+    }
+    return edges;
+}
+
+// The union of a graph with the edges of the next day, by co-traversal of the two trees
+static void BM_DKTreeUnite(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    DKTree *delta = DKTree::fromEdges(size, nextDayEdges(graph, size, (GraphKind) state.range(2)));
+    for (auto _ : state) {
+        DKTree *united = graph.tree->unite(*delta);
+        benchmark::DoNotOptimize(united);
+        delete united;
+    }
+    delete delta;
+    state.SetItemsProcessed(state.iterations() * graph.edges.size());
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// The same union, by adding the edges of the next day one by one to a copy of the graph
+static void BM_DKTreeUniteByAddEdge(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    auto delta = nextDayEdges(graph, size, (GraphKind) state.range(2));
+    for (auto _ : state) {
+        state.PauseTiming();
+        DKTree *united = DKTree::fromEdges(size, graph.edges);
+        state.ResumeTiming();
+        for (auto &edge : delta) {
+            united->addEdge(edge.first, edge.second);
+        }
+        state.PauseTiming();
+        delete united;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * graph.edges.size());
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// The transpose of a graph, by permuting the blocks of the tree
+static void BM_DKTreeTransposed(benchmark::State &state) {
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    for (auto _ : state) {
+        DKTree *transposed = graph.tree->transposed();
+        benchmark::DoNotOptimize(transposed);
+        delete transposed;
+    }
+    state.SetItemsProcessed(state.iterations() * graph.edges.size());
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// The same transpose, by bulk-loading the reversed edges
+static void BM_DKTreeTransposedByEdges(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    for (auto _ : state) {
+        vector<std::pair<unsigned long, unsigned long>> reversed;
+        reversed.reserve(graph.edges.size());
+        for (auto &edge : graph.edges) {
+            reversed.emplace_back(edge.second, edge.first);
+        }
+        DKTree *transposed = DKTree::fromEdges(size, reversed);
+        benchmark::DoNotOptimize(transposed);
+        delete transposed;
+    }
+    state.SetItemsProcessed(state.iterations() * graph.edges.size());
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// Adding the edges of the next day while a snapshot for the readers is taken every range(3) edges, 0 for never.
+// Every snapshot shares the nodes of the tree, so the first changes after it copy the paths they touch
+static void BM_DKTreeAddEdgeWithSnapshots(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto every = (unsigned long) state.range(3);
+    auto &graph = benchGraph(state.range(0), state.range(1), (GraphKind) state.range(2));
+    auto delta = nextDayEdges(graph, size, (GraphKind) state.range(2));
+    for (auto _ : state) {
+        state.PauseTiming();
+        DKTree *tree = DKTree::fromEdges(size, graph.edges);
+        DKTree *snapshot = nullptr;
+        state.ResumeTiming();
+        for (unsigned long i = 0; i < delta.size(); i++) {
+            if (every != 0 && i % every == 0) {
+                delete snapshot;
+                snapshot = tree->snapshot();
+            }
+            tree->addEdge(delta[i].first, delta[i].second);
+        }
+        state.PauseTiming();
+        delete snapshot;
+        delete tree;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * delta.size());
+    state.SetLabel(GRAPH_KIND_NAMES[state.range(2)]);
+}
+
+// Adding random edges to a tree directly (mode 0), through the log without syncing it (1), with a sync for every
+// group commit (2), and with a checkpoint in the background every 2^16 edges as well (3)
+static void BM_DurableDKTreeAddEdge(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto mode = state.range(1);
+    std::string directory = (std::filesystem::temp_directory_path() / "dk2tree_bench_durable").string();
+    std::filesystem::remove_all(directory);
+    DurabilityOptions options;
+    options.sync = mode >= 2;
+    options.checkpointInterval = mode == 3 ? 1ul << 16 : 0;
+    {
+        DurableDKTree durable(directory, size, options);
+        std::mt19937_64 random(size);
+        for (auto _ : state) {
+            unsigned long row = random() % size, column = random() % size;
+            if (mode == 0) {
+                durable.tree().addEdge(row, column);
+            } else {
+                durable.addEdge(row, column);
+            }
+        }
+        durable.commit();
+    }
+    std::filesystem::remove_all(directory);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Adding a batch of random edges to a tree with the given number of shards per side, on the given number of
+// threads, against the same edges added one by one to a single DKTree (0 shards)
+static void BM_ShardedDKTreeAddEdges(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto shardsPerSide = (unsigned long) state.range(1);
+    auto threads = (unsigned int) state.range(2);
+    auto edges = uniformEdges(size, size * 8, 5);
+    for (auto _ : state) {
+        if (shardsPerSide == 0) {
+            DKTree *tree = DKTree::withSize(size);
+            for (auto &edge : edges) {
+                tree->addEdge(edge.first, edge.second);
+            }
+            delete tree;
+        } else {
+            ShardedDKTree tree(size, shardsPerSide);
+            tree.addEdges(edges, threads);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * edges.size());
+}
+
+// Taking a snapshot of the published version and querying random edges of it, with the given number of
+// queries per snapshot, on a tree with eight random edges per vertex
+static void BM_EpochDKTreeRead(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto queries = (unsigned long) state.range(1);
+    EpochDKTree tree(size);
+    for (auto &edge : uniformEdges(size, size * 8, 6)) {
+        tree.writer().addEdge(edge.first, edge.second);
+    }
+    tree.publish();
+    std::mt19937_64 random(size);
+    for (auto _ : state) {
+        DKTree *version = tree.read();
+        for (unsigned long i = 0; i < queries; i++) {
+            benchmark::DoNotOptimize(version->reportEdge(random() % size, random() % size));
+        }
+        delete version;
+    }
+    state.SetItemsProcessed(state.iterations() * queries);
+}
+
+// A triple store with the given number of vertices and predicates and eight triples per vertex, in which
+// a few predicates are used far more often than the others. Stores are built once and shared
+static K2TripleStore &benchTripleStore(unsigned long size, unsigned long predicates, bool indexSubjects) {
+    static std::map<std::tuple<unsigned long, unsigned long, bool>, std::unique_ptr<K2TripleStore>> stores;
+    auto &store = stores[std::make_tuple(size, predicates, indexSubjects)];
+    if (!store) {
+        std::mt19937_64 random(size + predicates);
+        vector<Triple> triples;
+        for (unsigned long i = 0; i < size * 8; i++) {
+            unsigned long predicate = random() % 4 == 0 ? random() % predicates : random() % 8;
+            triples.push_back(Triple{random() % size, predicate, random() % size});
+        }
+        store.reset(K2TripleStore::fromTriples(size, triples, indexSubjects));
+    }
+    return *store;
+}
+
+// The pattern (s, ?, ?) for random subjects, with and without the index of the predicates of every subject
+static void BM_K2TripleStoreSubjectPattern(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &store = benchTripleStore(size, state.range(1), state.range(2));
+    auto subjects = accessPositions(RANDOM, BATCH, size, 9);
+    unsigned long i = 0, found = 0;
+    for (auto _ : state) {
+        found += store.predicatesAndObjects(subjects[i % BATCH]).size();
+        i++;
+    }
+    state.counters["triples"] = benchmark::Counter((double) found, benchmark::Counter::kAvgIterations);
+    state.SetLabel(state.range(2) ? "indexed" : "all predicates");
+}
+
+// Point queries at random times on a graph with 64 time slices, each of which changes 1% of the edges of a
+// uniform graph, with the checkpoint interval given by the second argument
+static void BM_TemporalGraphReportEdge(benchmark::State &state) {
+    auto size = (unsigned long) state.range(0);
+    auto &graph = benchGraph(size, 8, UNIFORM);
+    TemporalGraph temporal(size, state.range(1));
+    std::mt19937_64 random(size);
+    for (auto &edge : graph.edges) {
+        temporal.addEdge(edge.first, edge.second);
+    }
+    const unsigned long times = 64;
+    for (unsigned long time = 1; time < times; time++) {
+        temporal.advance();
+        for (unsigned long i = 0; i < graph.edges.size() / 200; i++) {
+            auto &edge = graph.edges[random() % graph.edges.size()];
+            temporal.removeEdge(edge.first, edge.second);
+            temporal.addEdge(random() % size, random() % size);
+        }
+    }
+    auto cells = accessCells(RANDOM, BATCH, size, 3);
+    unsigned long i = 0;
+    for (auto _ : state) {
+        auto &cell = cells[i % BATCH];
+        benchmark::DoNotOptimize(temporal.reportEdge(cell.first, cell.second, i * 7 % times));
+        i++;
+    }
+    setThroughput(state, 1);
+    state.counters["bytes"] = (double) temporal.memoryUsage();
+}
+
+static void setOperationArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 14, 1 << 17}, {8}, {UNIFORM, RMAT}});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+static void intersectionArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 14, 1 << 17}, {8}, {UNIFORM, RMAT, COMMUNITY}});
+    benchmark->Unit(benchmark::kMicrosecond);
+}
+
+// The traversal benchmarks take the number of vertices, the average number of edges per vertex, the kind of
+// graph and the search direction as arguments
+static void traversalArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 14, 1 << 17}, {8}, {UNIFORM, RMAT, BARABASI_ALBERT, GRID, COMMUNITY},
+                            {PUSH, DIRECTION_OPTIMIZING}});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+// The same arguments for the searches that only push
+static void pushTraversalArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 14, 1 << 17}, {8}, {UNIFORM, RMAT, BARABASI_ALBERT, GRID, COMMUNITY}, {PUSH}});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+static void dkTreeArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgsProduct({{1 << 10, 1 << 14, 1 << 17}, {1, 8}, {RANDOM, CLUSTERED, SEQUENTIAL}, {UNIFORM}});
+    // The structured graphs are only measured at their typical density
+    benchmark->ArgsProduct({{1 << 14, 1 << 17}, {8}, {RANDOM, CLUSTERED, SEQUENTIAL},
+                            {RMAT, BARABASI_ALBERT, GRID, COMMUNITY}});
+    benchmark->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(BM_DKTreeReportEdge)->Apply(dkTreeArguments);
+BENCHMARK(BM_DKTreeAddEdge)->Apply(dkTreeArguments);
+BENCHMARK(BM_DKTreeRemoveEdge)->Apply(dkTreeArguments);
+BENCHMARK(BM_DKTreeReportAllEdges)->Apply(dkTreeArguments);
+BENCHMARK(BM_DKTreeBreadthFirstSearch)->Apply(traversalArguments);
+BENCHMARK(BM_DKTreeBreadthFirstSearchPerVertex)->Apply(pushTraversalArguments);
+BENCHMARK(BM_DKTreeMultiply)->Apply(multiplyArguments)->UseRealTime();
+BENCHMARK(BM_DKTreeCountCommonSuccessors)->Apply(intersectionArguments);
+BENCHMARK(BM_DKTreeCountCommonSuccessorsByLists)->Apply(intersectionArguments);
+BENCHMARK(BM_DKTreeUnite)->Apply(setOperationArguments);
+BENCHMARK(BM_DKTreeUniteByAddEdge)->Apply(setOperationArguments);
+BENCHMARK(BM_DKTreeTransposed)->Apply(setOperationArguments);
+BENCHMARK(BM_DKTreeTransposedByEdges)->Apply(setOperationArguments);
+BENCHMARK(BM_DKTreeAddEdgeWithSnapshots)->ArgsProduct({{1 << 17}, {8}, {UNIFORM, RMAT}, {0, 1000, 10}})
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DurableDKTreeAddEdge)->ArgsProduct({{1 << 17}, {0, 1, 2, 3}});
+BENCHMARK(BM_EpochDKTreeRead)->ArgsProduct({{1 << 14}, {1, 64}});
+BENCHMARK(BM_ShardedDKTreeAddEdges)->Args({1 << 17, 0, 1})->ArgsProduct({{1 << 17}, {2, 4}, {1, 2, 4}})
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_TemporalGraphReportEdge)->ArgsProduct({{1 << 14}, {1, 4, 16}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_K2TripleStoreSubjectPattern)->ArgsProduct({{1 << 16}, {30, 300}, {0, 1}})
+        ->Unit(benchmark::kMicrosecond);
+
@@ -6,9 +6,12 @@
 //
 #include <cstdio>
 #include <iostream>
+#include <set>
+#include <thread>
 #include "gtest/gtest.h"
 #include "stdlib.h"
 #include "DKTree.h"
+#include "GraphGenerator.h"
 
 using namespace std;
 
@@ -551,6 +554,526 @@ namespace {
         graphWithXEntriesRandomDeleteAndFind(1000);
     }
 
+    TEST(DKTreeTest, bulkLoadEqualsAddingEdges){
+        std::cout << "bulkLoadEqualsAddingEdges test\n";
+        const unsigned long x = 1000;
+        vector<std::pair<unsigned long, unsigned long>> edges;
+        for (unsigned long i = 0; i < 20000; i++) {
+            edges.emplace_back(rand() % x, rand() % x);
+        }
+        DKTree *bulk = DKTree::fromEdges(x, edges);
+        DKTree *incremental = DKTree::withSize(x);
+        for (auto &edge : edges) {
+            incremental->addEdge(edge.first, edge.second);
+        }
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+        }
+        auto expected = incremental->reportAllEdges(all, all);
+        auto findings = bulk->reportAllEdges(all, all);
+        ASSERT_EQ(expected, findings);
+
+        // The bulk-loaded tree must still support all dynamic operations
+        for (unsigned long i = 0; i < 1000; i++) {
+            auto edge = edges[i];
+            bulk->removeEdge(edge.first, edge.second);
+            incremental->removeEdge(edge.first, edge.second);
+            bulk->addEdge(i % x, (i * 7) % x);
+            incremental->addEdge(i % x, (i * 7) % x);
+        }
+        ASSERT_EQ(incremental->reportAllEdges(all, all), bulk->reportAllEdges(all, all));
+        delete bulk;
+        delete incremental;
+    }
+
+    TEST(DKTreeTest, bulkLoadEmptyAndInvalid){
+        std::cout << "bulkLoadEmptyAndInvalid test\n";
+        vector<std::pair<unsigned long, unsigned long>> edges;
+        DKTree *empty = DKTree::fromEdges(5, edges);
+        ASSERT_FALSE(empty->reportEdge(4, 4));
+        empty->addEdge(4, 4);
+        ASSERT_TRUE(empty->reportEdge(4, 4));
+        delete empty;
+
+        edges.emplace_back(3, 5);
+        try {
+            DKTree::fromEdges(5, edges);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) { }
+    }
+
+    TEST(DKTreeTest, insertEntryGrowsFullMatrix){
+        std::cout << "insertEntryGrowsFullMatrix test\n";
+        DKTree dktree;
+        unsigned long size = dktree.capacity();
+        for (unsigned long i = 0; i <= size; i++) {
+            dktree.insertEntry();
+        }
+        ASSERT_EQ(size * k, dktree.capacity());
+        dktree.addEdge(size, size);
+        ASSERT_TRUE(dktree.reportEdge(size, size));
+        ASSERT_FALSE(dktree.reportEdge(0, 0));
+    }
+
+    TEST(DKTreeTest, reserveAvoidsGrowing){
+        std::cout << "reserveAvoidsGrowing test\n";
+        DKTree dktree;
+        dktree.insertEntry();
+        dktree.insertEntry();
+        dktree.addEdge(1, 0);
+        dktree.reserve(1000);
+        unsigned long capacity = dktree.capacity();
+        ASSERT_LE(1000, capacity);
+        for (unsigned long i = 2; i < 1000; i++) {
+            dktree.insertEntry();
+            dktree.addEdge(i, i - 1);
+        }
+        ASSERT_EQ(capacity, dktree.capacity());
+        for (unsigned long i = 1; i < 1000; i++) {
+            ASSERT_TRUE(dktree.reportEdge(i, i - 1));
+            ASSERT_FALSE(dktree.reportEdge(i - 1, i));
+        }
+    }
+
+    // The statistics of a tree should stay consistent while edges are added and
+    // removed, see TTreeTest.InsertDeleteReportNodes for the node counts themselves
+    TEST(DKTreeTest, memoryStatsTrackNodes) {
+        std::cout << "memoryStatsTrackNodes test\n";
+        auto *tree = DKTree::withSize(500);
+        std::mt19937_64 random(3);
+        vector<std::pair<unsigned long, unsigned long>> edges;
+        MemoryStats previous = tree->memoryStats();
+        for (unsigned long round = 0; round < 3; round++) {
+            for (unsigned long i = 0; i < 3000; i++) {
+                edges.emplace_back(random() % 500, random() % 500);
+                tree->addEdge(edges.back().first, edges.back().second);
+            }
+            MemoryStats grown = tree->memoryStats();
+            ASSERT_LT(previous.nodeHeaders, grown.nodeHeaders);
+            for (unsigned long i = 0; i < edges.size(); i += 2) {
+                tree->removeEdge(edges[i].first, edges[i].second);
+            }
+            MemoryStats stats = tree->memoryStats();
+            ASSERT_GT(grown.nodeHeaders, stats.nodeHeaders);
+            ASSERT_LT(0, stats.internalNodes);
+            ASSERT_EQ(stats.total(), tree->memoryUsage());
+            previous = stats;
+        }
+        delete tree;
+    }
+
+    TEST(DKTreeTest, hotPathCounters) {
+        std::cout << "hotPathCounters test\n";
+        resetHotPathCounters();
+        DKTree dktree;
+        for (unsigned long i = 0; i < 300; i++) {
+            dktree.insertEntry();
+            dktree.addEdge(i, (i * 7) % (i + 1));
+        }
+        for (unsigned long i = 0; i < 300; i++) {
+            dktree.reportEdge(i, (i * 7) % (i + 1));
+        }
+        HotPathCounters counters = hotPathSnapshot();
+        if (HOT_PATH_COUNTERS_ENABLED) {
+            ASSERT_LT(0, counters.pathHits);
+            ASSERT_LT(0, counters.rootDescents);
+            ASSERT_LT(0, counters.findChildSteps);
+            ASSERT_LT(0, counters.leafSplits);
+            ASSERT_LT(0, counters.internalSplits);
+            ASSERT_LT(0, counters.matrixGrowths);
+            ASSERT_LT(0, counters.bitsShifted);
+        } else {
+            ASSERT_EQ(0, counters.pathHits + counters.rootDescents + counters.findChildSteps
+                         + counters.leafSplits + counters.matrixGrowths + counters.bitsShifted);
+        }
+    }
+
+    // the order of reportAllEdges depends on the arities of the levels, so trees of different shapes are compared sorted
+    vector<std::pair<unsigned long, unsigned long>> sortedEdges(vector<std::pair<unsigned long, unsigned long>> edges) {
+        sort(edges.begin(), edges.end());
+        return edges;
+    }
+
+    TEST(DKTreeTest, vocabularyModeEqualsRawMode){
+        std::cout << "vocabularyModeEqualsRawMode test\n";
+        const unsigned long x = 600;
+        DKTree *raw = DKTree::withSize(x);
+        DKTree *coded = DKTree::withSize(x, true);
+        ASSERT_FALSE(raw->usesVocabulary());
+        ASSERT_TRUE(coded->usesVocabulary());
+        std::mt19937_64 random(5);
+        vector<std::pair<unsigned long, unsigned long>> edges;
+        for (unsigned long i = 0; i < 8000; i++) {
+            edges.emplace_back(random() % x, random() % x);
+            raw->addEdge(edges.back().first, edges.back().second);
+            coded->addEdge(edges.back().first, edges.back().second);
+        }
+        for (unsigned long i = 0; i < edges.size(); i += 3) {
+            raw->removeEdge(edges[i].first, edges[i].second);
+            coded->removeEdge(edges[i].first, edges[i].second);
+        }
+        raw->deleteEntry(17);
+        coded->deleteEntry(17);
+        for (unsigned long i = 0; i < 2000; i++) {
+            unsigned long row = random() % x, column = random() % x;
+            if (row != 17 && column != 17) {
+                ASSERT_EQ(raw->reportEdge(row, column), coded->reportEdge(row, column));
+            }
+        }
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            if (i != 17) {
+                all.push_back(i);
+            }
+        }
+        ASSERT_EQ(sortedEdges(raw->reportAllEdges(all, all)), sortedEdges(coded->reportAllEdges(all, all)));
+
+        // Removing every edge must remove every leaf
+        for (auto &edge : edges) {
+            if (edge.first != 17 && edge.second != 17) {
+                coded->removeEdge(edge.first, edge.second);
+            }
+        }
+        ASSERT_TRUE(coded->reportAllEdges(all, all).empty());
+        delete raw;
+        delete coded;
+    }
+
+    TEST(DKTreeTest, vocabularyBulkLoadSavesMemory){
+        std::cout << "vocabularyBulkLoadSavesMemory test\n";
+        const unsigned long x = 1 << 14;
+        auto edges = rmatEdges(x, 8 * x, 3);
+        DKTree *raw = DKTree::fromEdges(x, edges);
+        DKTree *coded = DKTree::fromEdges(x, edges, true);
+        DKTree *incremental = DKTree::withSize(x, true);
+        for (auto &edge : edges) {
+            incremental->addEdge(edge.first, edge.second);
+        }
+        for (unsigned long i = 0; i < 3000; i++) {
+            auto &edge = edges[(i * 7919) % edges.size()];
+            ASSERT_TRUE(coded->reportEdge(edge.first, edge.second));
+            ASSERT_EQ(raw->reportEdge(i % x, (i * 31) % x), coded->reportEdge(i % x, (i * 31) % x));
+        }
+        vector<unsigned long> rows, all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+            if (i % 97 == 0) {
+                rows.push_back(i);
+            }
+        }
+        ASSERT_EQ(sortedEdges(raw->reportAllEdges(rows, all)), sortedEdges(coded->reportAllEdges(rows, all)));
+        ASSERT_EQ(coded->reportAllEdges(rows, all), incremental->reportAllEdges(rows, all));
+        ASSERT_LT(coded->memoryUsage(), raw->memoryUsage());
+        delete raw;
+        delete coded;
+        delete incremental;
+
+        // The root block has to stay above the leaf submatrices
+        try {
+            DKTree(2, true);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) { }
+    }
+
+    TEST(DKTreeTest, hybridArityEqualsUniform){
+        std::cout << "hybridArityEqualsUniform test\n";
+        const unsigned long x = 700;
+        vector<Arities> shapes(4);
+        shapes[0].top = 4;
+        shapes[0].topLevels = 2;
+        shapes[1].leaf = 4;
+        shapes[2].top = 8;
+        shapes[2].topLevels = 1;
+        shapes[2].middle = 4;
+        shapes[2].leaf = 8;
+        shapes[3].top = 4;
+        shapes[3].topLevels = 1;
+        shapes[3].leaf = 8;
+        std::mt19937_64 random(9);
+        vector<std::pair<unsigned long, unsigned long>> edges;
+        for (unsigned long i = 0; i < 6000; i++) {
+            edges.emplace_back(random() % x, random() % x);
+        }
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+        }
+        DKTree *uniform = DKTree::withSize(x);
+        for (auto &edge : edges) {
+            uniform->addEdge(edge.first, edge.second);
+        }
+        for (unsigned long i = 0; i < edges.size(); i += 4) {
+            uniform->removeEdge(edges[i].first, edges[i].second);
+        }
+        auto expected = sortedEdges(uniform->reportAllEdges(all, all));
+
+        for (unsigned long s = 0; s < shapes.size(); s++) {
+            DKTree *hybrid = DKTree::withSize(x, s == 3, shapes[s]);
+            ASSERT_LE(hybrid->levelTable().height(), uniform->levelTable().height());
+            for (auto &edge : edges) {
+                hybrid->addEdge(edge.first, edge.second);
+            }
+            for (unsigned long i = 0; i < edges.size(); i += 4) {
+                hybrid->removeEdge(edges[i].first, edges[i].second);
+            }
+            for (unsigned long i = 0; i < 2000; i++) {
+                unsigned long row = random() % x, column = random() % x;
+                ASSERT_EQ(uniform->reportEdge(row, column), hybrid->reportEdge(row, column));
+            }
+            ASSERT_EQ(expected, sortedEdges(hybrid->reportAllEdges(all, all)));
+
+            DKTree *bulk = DKTree::fromEdges(x, edges, s == 3, shapes[s]);
+            for (unsigned long i = 0; i < edges.size(); i += 4) {
+                bulk->removeEdge(edges[i].first, edges[i].second);
+            }
+            ASSERT_EQ(hybrid->reportAllEdges(all, all), bulk->reportAllEdges(all, all));
+
+            // Growing the matrix adds a root level, after which the old edges must still be found
+            while (hybrid->insertEntry() < hybrid->capacity() - 1) {}
+            unsigned long last = hybrid->insertEntry();
+            hybrid->addEdge(last, 3);
+            ASSERT_TRUE(hybrid->reportEdge(last, 3));
+            hybrid->deleteEntry(last);
+            hybrid->deleteEntry(5);
+            vector<unsigned long> others;
+            vector<std::pair<unsigned long, unsigned long>> remaining;
+            for (unsigned long i = 0; i < x; i++) {
+                if (i != 5) {
+                    others.push_back(i);
+                }
+            }
+            for (auto &edge : expected) {
+                if (edge.first != 5 && edge.second != 5) {
+                    remaining.push_back(edge);
+                }
+            }
+            ASSERT_EQ(remaining, sortedEdges(hybrid->reportAllEdges(others, others)));
+            delete hybrid;
+            delete bulk;
+        }
+        delete uniform;
+
+        Arities unsupported;
+        unsupported.top = 3;
+        unsupported.topLevels = 1;
+        try {
+            DKTree::withSize(x, false, unsupported);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) { }
+    }
+
+    TEST(DKTreeTest, setOperationsMatchReference){
+        std::cout << "setOperationsMatchReference test\n";
+        const unsigned long x = 600;
+        std::mt19937_64 random(11);
+        vector<std::pair<unsigned long, unsigned long>> first, second;
+        for (unsigned long i = 0; i < 4000; i++) {
+            first.emplace_back(random() % x, random() % x);
+            // the second graph shares part of the edges, and is denser in the top left corner
+            second.push_back(i % 3 == 0 ? first.back() : std::make_pair(random() % (x / 3), random() % x));
+        }
+        std::set<std::pair<unsigned long, unsigned long>> a(first.begin(), first.end()), b(second.begin(), second.end());
+        vector<std::pair<unsigned long, unsigned long>> united, common, difference;
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(united));
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(difference));
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+        }
+
+        Arities hybrid;
+        hybrid.top = 4;
+        hybrid.topLevels = 2;
+        for (int mode = 0; mode < 3; mode++) {
+            Arities shape = mode == 1 ? hybrid : Arities();
+            DKTree *treeA = DKTree::fromEdges(x, first, mode == 2, shape);
+            DKTree *treeB = DKTree::fromEdges(x, second, mode == 2, shape);
+            DKTree *unionAB = treeA->unite(*treeB);
+            DKTree *intersectionAB = treeA->intersect(*treeB);
+            DKTree *differenceAB = treeA->subtract(*treeB);
+            ASSERT_EQ(united, sortedEdges(unionAB->reportAllEdges(all, all)));
+            ASSERT_EQ(common, sortedEdges(intersectionAB->reportAllEdges(all, all)));
+            ASSERT_EQ(difference, sortedEdges(differenceAB->reportAllEdges(all, all)));
+            ASSERT_EQ(mode == 2, unionAB->usesVocabulary());
+            // the results are ordinary dynamic trees
+            differenceAB->addEdge(first[0].first, first[0].second);
+            ASSERT_TRUE(differenceAB->reportEdge(first[0].first, first[0].second));
+            DKTree *empty = treeA->subtract(*treeA);
+            ASSERT_TRUE(sortedEdges(empty->reportAllEdges(all, all)).empty());
+            delete empty;
+            delete unionAB;
+            delete intersectionAB;
+            delete differenceAB;
+            delete treeA;
+            delete treeB;
+        }
+
+        // a tree with an extra root level is combined with a lower one, and the vertices are merged
+        DKTree *small = DKTree::fromEdges(x, first);
+        DKTree *large = DKTree::fromEdges(x, second);
+        while (large->insertEntry() < large->capacity() - 1) {}
+        unsigned long last = large->insertEntry();
+        large->addEdge(last, 2);
+        large->deleteEntry(7);
+        ASSERT_LT(small->levelTable().height(), large->levelTable().height());
+        std::set<std::pair<unsigned long, unsigned long>> largeEdges;
+        for (auto &edge : b) {
+            if (edge.first != 7 && edge.second != 7) {
+                largeEdges.insert(edge);
+            }
+        }
+        largeEdges.emplace(last, 2);
+        united.clear();
+        std::set_union(a.begin(), a.end(), largeEdges.begin(), largeEdges.end(), std::back_inserter(united));
+        DKTree *unionSmallLarge = small->unite(*large);
+        DKTree *unionLargeSmall = large->unite(*small);
+        ASSERT_EQ(large->levelTable().height(), unionSmallLarge->levelTable().height());
+        all.push_back(last);
+        ASSERT_EQ(united, sortedEdges(unionSmallLarge->reportAllEdges(all, all)));
+        ASSERT_EQ(united, sortedEdges(unionLargeSmall->reportAllEdges(all, all)));
+        // vertex 7 is still present in the small tree
+        ASSERT_EQ(last + 1, unionSmallLarge->insertEntry());
+        DKTree *intersectionSmallLarge = small->intersect(*large);
+        // vertex 7 was deleted from the large tree, so it is free again in the intersection
+        ASSERT_EQ(7, intersectionSmallLarge->insertEntry());
+        delete intersectionSmallLarge;
+        delete unionSmallLarge;
+        delete unionLargeSmall;
+        delete small;
+        delete large;
+
+        Arities other;
+        other.leaf = 4;
+        DKTree *uniform = DKTree::withSize(x);
+        DKTree *different = DKTree::withSize(x, false, other);
+        try {
+            uniform->unite(*different);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) { }
+        delete uniform;
+        delete different;
+    }
+
+    TEST(DKTreeTest, transposedSwapsRowsAndColumns){
+        std::cout << "transposedSwapsRowsAndColumns test\n";
+        const unsigned long x = 700;
+        std::mt19937_64 random(13);
+        vector<std::pair<unsigned long, unsigned long>> edges, swapped;
+        for (unsigned long i = 0; i < 5000; i++) {
+            // rows are denser at the start, so the transposed tree has a different shape
+            edges.emplace_back(random() % (x / 4), random() % x);
+            swapped.emplace_back(edges.back().second, edges.back().first);
+        }
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+        }
+        auto expected = sortedEdges(DKTree::fromEdges(x, swapped)->reportAllEdges(all, all));
+
+        vector<Arities> shapes(3);
+        shapes[0].top = 4;
+        shapes[0].topLevels = 2;
+        shapes[1].leaf = 4;
+        for (unsigned long s = 0; s < 4; s++) {
+            DKTree *tree = DKTree::fromEdges(x, edges, s == 3, shapes[s % 3]);
+            tree->deleteEntry(3);
+            DKTree *transposed = tree->transposed();
+            vector<std::pair<unsigned long, unsigned long>> remaining;
+            for (auto &edge : expected) {
+                if (edge.first != 3 && edge.second != 3) {
+                    remaining.push_back(edge);
+                }
+            }
+            all.erase(std::find(all.begin(), all.end(), 3));
+            ASSERT_EQ(remaining, sortedEdges(transposed->reportAllEdges(all, all)));
+            all.insert(all.begin() + 3, 3);
+            ASSERT_EQ(s == 3, transposed->usesVocabulary());
+            ASSERT_EQ(3, transposed->insertEntry());
+
+            // transposing twice gives the original tree
+            DKTree *twice = transposed->transposed();
+            for (unsigned long i = 0; i < 2000; i++) {
+                unsigned long row = random() % x, column = random() % x;
+                if (row == 3 || column == 3) {
+                    continue;
+                }
+                ASSERT_EQ(transposed->reportEdge(row, column), twice->reportEdge(column, row));
+                ASSERT_EQ(transposed->reportEdge(row, column), tree->reportEdge(column, row));
+            }
+            delete twice;
+            delete transposed;
+            delete tree;
+        }
+    }
+
+    TEST(DKTreeTest, snapshotsSeeNoLaterChanges){
+        std::cout << "snapshotsSeeNoLaterChanges test\n";
+        typedef std::set<std::pair<unsigned long, unsigned long>> EdgeSet;
+        const unsigned long x = 400;
+        std::mt19937_64 random(11);
+        vector<unsigned long> all;
+        for (unsigned long i = 0; i < x; i++) {
+            all.push_back(i);
+        }
+        auto change = [&](DKTree *tree, EdgeSet &edges, unsigned long count) {
+            for (unsigned long i = 0; i < count; i++) {
+                unsigned long row = random() % x, column = random() % x;
+                if (random() % 3 == 0) {
+                    tree->removeEdge(row, column);
+                    edges.erase({row, column});
+                } else {
+                    tree->addEdge(row, column);
+                    edges.insert({row, column});
+                }
+            }
+        };
+        auto expectEdges = [&](DKTree *tree, const EdgeSet &edges) {
+            ASSERT_EQ((vector<std::pair<unsigned long, unsigned long>>(edges.begin(), edges.end())),
+                      sortedEdges(tree->reportAllEdges(all, all)));
+        };
+
+        for (bool vocabulary : {false, true}) {
+            DKTree *tree = DKTree::withSize(x, vocabulary);
+            EdgeSet edges;
+            change(tree, edges, 4000);
+            DKTree *first = tree->snapshot();
+            EdgeSet firstEdges = edges;
+            change(tree, edges, 3000);
+            DKTree *second = tree->snapshot();
+            EdgeSet secondEdges = edges;
+
+            // a snapshot is queried by another thread while the tree keeps changing
+            std::thread reader([&] {
+                for (unsigned long round = 0; round < 3; round++) {
+                    expectEdges(second, secondEdges);
+                }
+            });
+            change(tree, edges, 3000);
+            reader.join();
+            expectEdges(tree, edges);
+            expectEdges(first, firstEdges);
+            expectEdges(second, secondEdges);
+
+            // a snapshot can be changed as well, without changing the trees it shares nodes with
+            change(first, firstEdges, 2000);
+            expectEdges(first, firstEdges);
+            expectEdges(second, secondEdges);
+            expectEdges(tree, edges);
+
+            // the shared nodes are freed by the last tree that refers to them
+            delete second;
+            change(tree, edges, 1000);
+            delete tree;
+            expectEdges(first, firstEdges);
+            // the last tree no longer shares nodes, and changes it with its cached paths again
+            change(first, firstEdges, 2000);
+            expectEdges(first, firstEdges);
+            delete first;
+        }
+    }
+
 //    TEST(DKTreeTest, randomTenThousandGraph){
 //        std::cout << "randomTenThousandGraph test\n";
 //        graphWithXEntriesRandomSet(10000);
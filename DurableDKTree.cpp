@@ -0,0 +1,386 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "DurableDKTree.h"
+#include "EdgeList.h"
+
+using namespace std;
+
+// the kinds of changes in the log
+static const char ADD_EDGE = 'a', REMOVE_EDGE = 'r', INSERT_ENTRY = 'i', DELETE_ENTRY = 'd';
+
+/// The committer is woken before the commit interval is over once this many bytes of changes are pending
+static const unsigned long COMMIT_BYTES = 1ul << 16;
+
+/// The header of every group commit in the log, followed by `length` bytes of changes
+struct LogRecordHeader {
+    uint32_t length;
+    uint32_t checksum; // the CRC-32 of the changes
+};
+
+/**
+ * The file `checkpoint` in the directory of a durable tree. It is followed by the
+ * free entries of the tree, and the edges are stored as a binary edge-list in
+ * the file `checkpoint.<segment>.edges`
+ */
+struct CheckpointHeader {
+    char magic[4]; // always "DK2C"
+    uint32_t unused;
+    uint64_t segment; // the first log segment that is not part of the checkpoint
+    uint64_t vertexBound;
+    uint64_t freeEntries; // the number of free entries below vertexBound
+};
+
+static const char CHECKPOINT_MAGIC[4] = {'D', 'K', '2', 'C'};
+
+/// The CRC-32 of zlib, by which a record that was only partly written before a crash is recognised
+static uint32_t crc32(const char *data, unsigned long length) {
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> result{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = crc & 1 ? 0xEDB88320 ^ crc >> 1 : crc >> 1;
+            }
+            result[i] = crc;
+        }
+        return result;
+    }();
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned long i = 0; i < length; i++) {
+        crc = table[(crc ^ (uint8_t) data[i]) & 0xFF] ^ crc >> 8;
+    }
+    return ~crc;
+}
+
+static string segmentName(unsigned long segment) {
+    return "log." + to_string(segment);
+}
+
+static string checkpointEdgesName(unsigned long segment) {
+    return "checkpoint." + to_string(segment) + ".edges";
+}
+
+/// Makes the contents of a file or directory durable
+static void syncPath(const string &name) {
+    int file = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0 || fsync(file) != 0) {
+        if (file >= 0) {
+            close(file);
+        }
+        throw runtime_error("DurableDKTree: could not sync " + name + "\n");
+    }
+    close(file);
+}
+
+/// Writes all of the given bytes, and returns false if that failed
+static bool writeAll(int file, const char *data, unsigned long length) {
+    while (length > 0) {
+        ssize_t written = write(file, data, length);
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+DurableDKTree::DurableDKTree(const string &directory, unsigned long size, DurabilityOptions options)
+        : directory(directory), options(options) {
+    try {
+        filesystem::create_directories(directory);
+        recover(size);
+    } catch (...) {
+        delete dktree;
+        if (logFile >= 0) {
+            close(logFile);
+        }
+        throw;
+    }
+    committer = thread(&DurableDKTree::commitLoop, this);
+}
+
+DurableDKTree::~DurableDKTree() {
+    if (checkpointer.joinable()) {
+        checkpointer.join();
+    }
+    {
+        lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCommitter.notify_one();
+    committer.join();
+    close(logFile);
+    delete dktree;
+}
+
+void DurableDKTree::recover(unsigned long size) {
+    ifstream state(path("checkpoint"), ios::binary);
+    if (state) {
+        CheckpointHeader header{};
+        vector<unsigned long> free;
+        if (state.read((char *) &header, sizeof(header))) {
+            free.resize(header.freeEntries);
+            state.read((char *) free.data(), free.size() * sizeof(unsigned long));
+        }
+        if (!state || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+            throw runtime_error("DurableDKTree: " + path("checkpoint") + " is not a valid checkpoint\n");
+        }
+        auto edges = readBinaryEdgeList(path(checkpointEdgesName(header.segment)));
+        dktree = DKTree::fromEdges(header.vertexBound, edges);
+        dktree->setFreeEntries(free);
+        segment = header.segment;
+    } else {
+        dktree = DKTree::withSize(size);
+    }
+
+    // a checkpoint is only complete once its segment has started, so the segments after it follow without gaps
+    uint64_t validBytes = replay(path(segmentName(segment)));
+    while (filesystem::exists(path(segmentName(segment + 1)))) {
+        segment++;
+        validBytes = replay(path(segmentName(segment)));
+    }
+    string name = path(segmentName(segment));
+    logFile = open(name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    // new records are appended after the last complete one, not after a record that was torn by a crash
+    if (logFile < 0 || ftruncate(logFile, validBytes) != 0) {
+        throw runtime_error("DurableDKTree: could not open " + name + "\n");
+    }
+}
+
+uint64_t DurableDKTree::replay(const string &name) {
+    ifstream file(name, ios::binary);
+    if (!file) {
+        return 0;
+    }
+    vector<char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    uint64_t offset = 0;
+    while (offset + sizeof(LogRecordHeader) <= data.size()) {
+        LogRecordHeader header{};
+        memcpy(&header, data.data() + offset, sizeof(header));
+        const char *p = data.data() + offset + sizeof(header);
+        if (header.length > data.size() - offset - sizeof(header) || crc32(p, header.length) != header.checksum) {
+            // the end of the log, where a crash interrupted a group commit
+            break;
+        }
+        const char *end = p + header.length;
+        while (p < end) {
+            char kind = *p++;
+            if (kind == ADD_EDGE || kind == REMOVE_EDGE) {
+                unsigned long row = getVarint(p, end);
+                unsigned long column = getVarint(p, end);
+                if (kind == ADD_EDGE) {
+                    dktree->addEdge(row, column);
+                } else {
+                    dktree->removeEdge(row, column);
+                }
+            } else if (kind == INSERT_ENTRY) {
+                dktree->insertEntry();
+            } else if (kind == DELETE_ENTRY) {
+                dktree->deleteEntry(getVarint(p, end));
+            } else {
+                throw runtime_error("DurableDKTree: invalid change in " + name + "\n");
+            }
+        }
+        offset += sizeof(header) + header.length;
+    }
+    return offset;
+}
+
+void DurableDKTree::addEdge(unsigned long row, unsigned long column) {
+    dktree->addEdge(row, column);
+    log(ADD_EDGE, {row, column});
+}
+
+void DurableDKTree::removeEdge(unsigned long row, unsigned long column) {
+    dktree->removeEdge(row, column);
+    log(REMOVE_EDGE, {row, column});
+}
+
+unsigned long DurableDKTree::insertEntry() {
+    unsigned long entry = dktree->insertEntry();
+    log(INSERT_ENTRY, {});
+    return entry;
+}
+
+void DurableDKTree::deleteEntry(unsigned long a) {
+    dktree->deleteEntry(a);
+    log(DELETE_ENTRY, {a});
+}
+
+void DurableDKTree::log(char kind, initializer_list<unsigned long> arguments) {
+    {
+        lock_guard<std::mutex> lock(stateMutex);
+        if (!logError.empty()) {
+            throw runtime_error(logError);
+        }
+        pending.push_back(kind);
+        for (unsigned long argument : arguments) {
+            putVarint(pending, argument);
+        }
+        appended++;
+        if (pending.size() >= COMMIT_BYTES) {
+            wakeCommitter.notify_one();
+        }
+    }
+    if (options.checkpointInterval != 0 && ++changesSinceCheckpoint >= options.checkpointInterval) {
+        checkpoint();
+    }
+}
+
+void DurableDKTree::commitLoop() {
+    unique_lock<std::mutex> lock(stateMutex);
+    vector<char> batch;
+    while (true) {
+        wakeCommitter.wait_for(lock, chrono::microseconds(options.commitInterval), [&] {
+            return stopping || commitRequested || pending.size() >= COMMIT_BYTES;
+        });
+        commitRequested = false;
+        if (pending.empty()) {
+            if (stopping) {
+                return;
+            }
+            continue;
+        }
+        // the changes made while this batch is written are collected in the other buffer
+        batch.clear();
+        batch.swap(pending);
+        uint64_t batchEnd = appended;
+        int file = logFile;
+        lock.unlock();
+
+        LogRecordHeader header{(uint32_t) batch.size(), crc32(batch.data(), batch.size())};
+        bool written = writeAll(file, (const char *) &header, sizeof(header))
+                       && writeAll(file, batch.data(), batch.size())
+                       && (!options.sync || fdatasync(file) == 0);
+
+        lock.lock();
+        if (written) {
+            durable = batchEnd;
+        } else {
+            logError = "DurableDKTree: could not write the log in " + directory + "\n";
+        }
+        committed.notify_all();
+    }
+}
+
+void DurableDKTree::commit() {
+    unique_lock<std::mutex> lock(stateMutex);
+    uint64_t target = appended;
+    commitRequested = true;
+    wakeCommitter.notify_one();
+    committed.wait(lock, [&] { return durable >= target || !logError.empty(); });
+    if (!logError.empty()) {
+        throw runtime_error(logError);
+    }
+}
+
+void DurableDKTree::checkpoint() {
+    waitForCheckpoint();
+    changesSinceCheckpoint = 0;
+    // the snapshot contains exactly the changes of the segments before the new one
+    commit();
+    string name = path(segmentName(segment + 1));
+    int file = open(name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (file < 0) {
+        throw runtime_error("DurableDKTree: could not open " + name + "\n");
+    }
+    if (options.sync) {
+        syncPath(directory);
+    }
+    {
+        lock_guard<std::mutex> lock(stateMutex);
+        close(logFile);
+        logFile = file;
+    }
+    segment++;
+    checkpointer = thread(&DurableDKTree::writeCheckpoint, this, dktree->snapshot(), segment);
+}
+
+void DurableDKTree::waitForCheckpoint() {
+    if (!checkpointer.joinable()) {
+        return;
+    }
+    checkpointer.join();
+    if (!checkpointError.empty()) {
+        string error = checkpointError;
+        checkpointError.clear();
+        throw runtime_error(error);
+    }
+}
+
+void DurableDKTree::writeCheckpoint(DKTree *snapshot, unsigned long checkpointSegment) {
+    try {
+        const vector<unsigned long> &free = snapshot->freeEntries();
+        vector<unsigned long> vertices;
+        for (unsigned long vertex = 0, next = 0; vertex < snapshot->vertexBound(); vertex++) {
+            if (next < free.size() && free[next] == vertex) {
+                next++;
+            } else {
+                vertices.push_back(vertex);
+            }
+        }
+        vector<Edge> edges;
+        if (!vertices.empty()) {
+            edges = snapshot->reportAllEdges(vertices, vertices);
+        }
+        string edgesName = path(checkpointEdgesName(checkpointSegment));
+        writeBinaryEdgeList(edgesName, edges, DELTA_VARINT);
+
+        // the new checkpoint replaces the old one at once, by renaming it
+        CheckpointHeader header{};
+        memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.segment = checkpointSegment;
+        header.vertexBound = snapshot->vertexBound();
+        header.freeEntries = free.size();
+        {
+            ofstream state(path("checkpoint.tmp"), ios::binary | ios::trunc);
+            state.write((const char *) &header, sizeof(header));
+            state.write((const char *) free.data(), free.size() * sizeof(unsigned long));
+            if (!state) {
+                throw runtime_error("DurableDKTree: could not write " + path("checkpoint.tmp") + "\n");
+            }
+        }
+        if (options.sync) {
+            syncPath(edgesName);
+            syncPath(path("checkpoint.tmp"));
+        }
+        filesystem::rename(path("checkpoint.tmp"), path("checkpoint"));
+        if (options.sync) {
+            syncPath(directory);
+        }
+
+        // the older segments and checkpoints are no longer needed for recovery
+        vector<filesystem::path> obsolete;
+        for (auto &entry : filesystem::directory_iterator(directory)) {
+            string name = entry.path().filename().string();
+            unsigned long number;
+            char rest;
+            if ((sscanf(name.c_str(), "log.%lu%c", &number, &rest) == 1 && number < checkpointSegment)
+                || (sscanf(name.c_str(), "checkpoint.%lu.edges%c", &number, &rest) == 1
+                    && name == checkpointEdgesName(number) && number != checkpointSegment)) {
+                obsolete.push_back(entry.path());
+            }
+        }
+        for (auto &file : obsolete) {
+            filesystem::remove(file);
+        }
+    } catch (const exception &e) {
+        checkpointError = e.what();
+    }
+    delete snapshot;
+}
@@ -0,0 +1,158 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_DURABLE_DKTREE_H
+#define DK2TREE_DURABLE_DKTREE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DKTree.h"
+
+/// When a `DurableDKTree` makes its changes durable and takes checkpoints
+struct DurabilityOptions {
+    // the longest time in microseconds that a change waits in memory before it is written to the log, all
+    // changes made in that time are written and synced together (group commit)
+    unsigned long commitInterval = 2000;
+    // the number of changes after which a checkpoint is started in the background, 0 for only explicit ones
+    unsigned long checkpointInterval = 1ul << 20;
+    // whether every group commit is synced to the disk, without it a crash of the operating system may lose
+    // changes that were committed, but a crash of the process does not
+    bool sync = true;
+};
+
+/**
+ * A DKTree whose changes survive a crash. Every `addEdge`, `removeEdge`,
+ * `insertEntry` and `deleteEntry` is applied to the tree and appended to an
+ * in-memory buffer, and a background thread writes the buffer to an
+ * append-only binary log and syncs it, so many changes share one sync (group
+ * commit) and the caller never waits for the disk, unless it asks to with
+ * `commit`.
+ *
+ * The log consists of segments `log.<n>` in the directory of the tree. A
+ * checkpoint takes a snapshot of the tree (see `DKTree::snapshot`), starts a
+ * new segment, and writes the edges of the snapshot as a binary edge-list in
+ * the background, while changes continue. Once it is complete, the older
+ * segments and checkpoints are deleted. Recovery loads the last complete
+ * checkpoint and replays the segments after it, up to the last complete
+ * group commit.
+ *
+ * Every group commit is one record of the log: its length, a CRC-32 of its
+ * contents, and the changes, each one byte for the kind of change followed by
+ * its arguments as LEB128 varints.
+ */
+class DurableDKTree {
+public:
+    /**
+     * Opens the durable tree stored in the given directory, recovering it from
+     * its checkpoint and log, or creates an empty one if there is none
+     * @param directory the directory of the checkpoints and the log, created if it does not exist
+     * @param size the number of vertices of a new tree, ignored when the tree is recovered
+     * @param options when to commit and take checkpoints
+     * @throws runtime error if the directory, checkpoint or log can not be read or written
+     */
+    explicit DurableDKTree(const std::string &directory, unsigned long size = 0,
+                           DurabilityOptions options = DurabilityOptions());
+
+    /// Commits the remaining changes and waits for a running checkpoint
+    ~DurableDKTree();
+
+    DurableDKTree(const DurableDKTree &) = delete;
+
+    DurableDKTree &operator=(const DurableDKTree &) = delete;
+
+    /// Adds the edge (row, column), see `DKTree::addEdge`
+    void addEdge(unsigned long row, unsigned long column);
+
+    /// Removes the edge (row, column), see `DKTree::removeEdge`
+    void removeEdge(unsigned long row, unsigned long column);
+
+    /// Adds a row/column, see `DKTree::insertEntry`
+    unsigned long insertEntry();
+
+    /// Deletes a row/column and its edges, see `DKTree::deleteEntry`
+    void deleteEntry(unsigned long a);
+
+    /**
+     * The tree itself, for queries. It must not be changed directly, since
+     * those changes would not be logged
+     */
+    DKTree &tree() {
+        return *dktree;
+    }
+
+    /**
+     * Waits until all changes made so far are written to the log, and synced
+     * if the options ask for it
+     * @throws runtime error if writing the log failed
+     */
+    void commit();
+
+    /**
+     * Starts a checkpoint in the background, after waiting for the previous one
+     * @throws runtime error if the previous checkpoint or writing the log failed
+     */
+    void checkpoint();
+
+    /**
+     * Waits until the running checkpoint, if any, is complete
+     * @throws runtime error if the checkpoint could not be written
+     */
+    void waitForCheckpoint();
+
+    /// @return the number of the log segment that changes are appended to
+    unsigned long logSegment() const {
+        return segment;
+    }
+
+private:
+    std::string directory;
+    DurabilityOptions options;
+    DKTree *dktree = nullptr;
+    unsigned long segment = 0; // the number of the current log segment
+    unsigned long changesSinceCheckpoint = 0;
+
+    // the state shared with the committer, guarded by `stateMutex`
+    std::mutex stateMutex;
+    std::condition_variable wakeCommitter; // there is something to write, or the committer has to stop
+    std::condition_variable committed; // the durable changes have increased
+    std::vector<char> pending; // the encoded changes that are not written yet
+    uint64_t appended = 0; // the number of changes made
+    uint64_t durable = 0; // the number of changes written to the log
+    bool commitRequested = false;
+    bool stopping = false;
+    std::string logError; // the reason writing the log failed, empty if it did not
+    int logFile = -1; // the file descriptor of the current log segment
+    std::thread committer;
+
+    std::thread checkpointer;
+    std::string checkpointError; // the reason the last checkpoint failed, written by the checkpointer
+
+    /// Recovers the tree from the last checkpoint and the log segments after it
+    void recover(unsigned long size);
+
+    /// Applies the changes of a log segment, and returns the number of bytes of its complete records
+    uint64_t replay(const std::string &name);
+
+    /// Appends a change and its arguments to the pending changes, and starts a checkpoint if it is time for one
+    void log(char kind, std::initializer_list<unsigned long> arguments);
+
+    /// Writes the pending changes to the log until the tree is closed
+    void commitLoop();
+
+    /// Writes the edges and vertices of a snapshot as the checkpoint of the given segment, and deletes the
+    /// segments and checkpoints before it
+    void writeCheckpoint(DKTree *snapshot, unsigned long checkpointSegment);
+
+    /// @return the path of a file in the directory of the tree
+    std::string path(const std::string &name) const {
+        return directory + "/" + name;
+    }
+};
+
+#endif // DK2TREE_DURABLE_DKTREE_H
@@ -0,0 +1,139 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DURABLE_DKTREE_TEST
+#define DURABLE_DKTREE_TEST
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "DurableDKTree.h"
+#include "gtest/gtest.h"
+
+// the edges, vertex bound and free entries of a tree, which a recovered tree must have as well
+static std::string durableStateOf(DKTree &tree) {
+    std::vector<unsigned long> vertices;
+    for (unsigned long vertex = 0; vertex < tree.vertexBound(); vertex++) {
+        if (!std::binary_search(tree.freeEntries().begin(), tree.freeEntries().end(), vertex)) {
+            vertices.push_back(vertex);
+        }
+    }
+    auto edges = tree.reportAllEdges(vertices, vertices);
+    std::sort(edges.begin(), edges.end());
+    std::stringstream state;
+    state << "bound " << tree.vertexBound() << " free";
+    for (unsigned long entry : tree.freeEntries()) {
+        state << " " << entry;
+    }
+    state << " edges";
+    for (auto &edge : edges) {
+        state << " " << edge.first << "," << edge.second;
+    }
+    return state.str();
+}
+
+// makes random changes of all four kinds to the present vertices, which are kept up to date
+static void durableRandomChanges(DurableDKTree &tree, std::vector<unsigned long> &vertices,
+                                 std::mt19937_64 &random, unsigned long count) {
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long kind = random() % 100;
+        if (kind == 0 && vertices.size() > 2) {
+            unsigned long index = random() % vertices.size();
+            tree.deleteEntry(vertices[index]);
+            vertices.erase(vertices.begin() + index);
+        } else if (kind < 3) {
+            vertices.push_back(tree.insertEntry());
+        } else {
+            unsigned long row = vertices[random() % vertices.size()], column = vertices[random() % vertices.size()];
+            if (kind < 30) {
+                tree.removeEdge(row, column);
+            } else {
+                tree.addEdge(row, column);
+            }
+        }
+    }
+}
+
+static unsigned long countFiles(const std::string &directory, const std::string &prefix) {
+    unsigned long count = 0;
+    for (auto &entry : std::filesystem::directory_iterator(directory)) {
+        count += entry.path().filename().string().rfind(prefix, 0) == 0 ? 1 : 0;
+    }
+    return count;
+}
+
+TEST(DurableDKTreeTest, RecoversFromCheckpointAndLog) {
+    std::string directory = testing::TempDir() + "durable_dktree_test";
+    std::filesystem::remove_all(directory);
+    DurabilityOptions options;
+    options.checkpointInterval = 0;
+    options.sync = false;
+    std::mt19937_64 random(7);
+    std::vector<unsigned long> vertices;
+    for (unsigned long vertex = 0; vertex < 200; vertex++) {
+        vertices.push_back(vertex);
+    }
+    std::string expected;
+    {
+        DurableDKTree tree(directory, 200, options);
+        durableRandomChanges(tree, vertices, random, 3000);
+        tree.checkpoint();
+        // the changes continue while the checkpoint is written
+        durableRandomChanges(tree, vertices, random, 3000);
+        tree.waitForCheckpoint();
+        durableRandomChanges(tree, vertices, random, 500);
+        ASSERT_EQ(1, tree.logSegment());
+        expected = durableStateOf(tree.tree());
+    }
+    ASSERT_EQ(1, countFiles(directory, "log."));
+
+    // a group commit that was only partly written before a crash is ignored, and overwritten
+    {
+        std::ofstream log(directory + "/log.1", std::ios::binary | std::ios::app);
+        log.write("\x20\0\0\0garbage", 11);
+    }
+    {
+        DurableDKTree tree(directory, 0, options);
+        ASSERT_EQ(expected, durableStateOf(tree.tree()));
+        durableRandomChanges(tree, vertices, random, 500);
+        tree.commit();
+        expected = durableStateOf(tree.tree());
+    }
+    {
+        DurableDKTree tree(directory, 0, options);
+        ASSERT_EQ(expected, durableStateOf(tree.tree()));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DurableDKTreeTest, AutomaticCheckpointsReplaceOldSegments) {
+    std::string directory = testing::TempDir() + "durable_dktree_checkpoints_test";
+    std::filesystem::remove_all(directory);
+    DurabilityOptions options;
+    options.checkpointInterval = 1000;
+    std::mt19937_64 random(8);
+    std::vector<unsigned long> vertices;
+    std::string expected;
+    {
+        DurableDKTree tree(directory, 0, options);
+        for (unsigned long vertex = 0; vertex < 100; vertex++) {
+            vertices.push_back(tree.insertEntry());
+        }
+        durableRandomChanges(tree, vertices, random, 4500);
+        tree.waitForCheckpoint();
+        ASSERT_EQ(4, tree.logSegment());
+        expected = durableStateOf(tree.tree());
+    }
+    // only the last checkpoint and the segment after it are kept
+    ASSERT_EQ(1, countFiles(directory, "log."));
+    ASSERT_EQ(1, countFiles(directory, "checkpoint.4"));
+    ASSERT_EQ(2, countFiles(directory, "checkpoint"));
+    {
+        DurableDKTree tree(directory, 0, options);
+        ASSERT_EQ(expected, durableStateOf(tree.tree()));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+#endif // DURABLE_DKTREE_TEST
@@ -0,0 +1,330 @@
+//
+// Created by agent on 19-10-26.
+//
+
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EdgeList.h"
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void failParse(const char *at, const char *origin) {
+    std::stringstream error;
+    error << "parseEdgeList: malformed edge at byte " << (at - origin) << "\n";
+    throw std::invalid_argument(error.str());
+}
+
+/**
+ * Parses all lines in [begin, end) and appends the edges to `out`. The range
+ * must start at the beginning of a line, and end at the end of a line (or the
+ * end of the text)
+ *
+ * @param origin the start of the whole text, only used for error messages
+ */
+static void parseLines(const char *begin, const char *end, const char *origin,
+                       std::vector<Edge> &out) {
+    const char *p = begin;
+    while (p < end) {
+        while (p < end && isBlank(*p)) {
+            p++;
+        }
+        if (p == end) {
+            break;
+        }
+        if (*p == '\n') {
+            // Blank line
+            p++;
+            continue;
+        }
+        if (*p != '#' && *p != '%') {
+            unsigned long a, b;
+            auto result = std::from_chars(p, end, a);
+            if (result.ec != std::errc() || result.ptr == end || !isBlank(*result.ptr)) {
+                failParse(p, origin);
+            }
+            p = result.ptr;
+            while (p < end && isBlank(*p)) {
+                p++;
+            }
+            result = std::from_chars(p, end, b);
+            if (result.ec != std::errc()) {
+                failParse(p, origin);
+            }
+            p = result.ptr;
+            out.emplace_back(a, b);
+        }
+        // Skip comments and anything following the second integer
+        auto newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (newline == nullptr) {
+            break;
+        }
+        p = newline + 1;
+    }
+}
+
+std::vector<Edge> parseEdgeList(const char *begin, const char *end, unsigned int threads) {
+    unsigned long length = end - begin;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    unsigned long chunks = std::max(1ul, std::min((unsigned long) threads, length / MIN_PARSE_CHUNK));
+
+    std::vector<Edge> result;
+    if (chunks == 1) {
+        parseLines(begin, end, begin, result);
+        return result;
+    }
+
+    // Divide the text into chunks of roughly equal size, and move every
+    // boundary forward to the start of the next line
+    std::vector<const char *> bounds(chunks + 1);
+    bounds[0] = begin;
+    bounds[chunks] = end;
+    for (unsigned long i = 1; i < chunks; i++) {
+        const char *p = std::max(bounds[i - 1], begin + i * (length / chunks));
+        auto newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        bounds[i] = newline == nullptr ? end : newline + 1;
+    }
+
+    std::vector<std::vector<Edge>> parts(chunks);
+    std::vector<std::exception_ptr> errors(chunks);
+    std::vector<std::thread> workers;
+    for (unsigned long i = 0; i < chunks; i++) {
+        workers.emplace_back([&, i]() {
+            try {
+                parseLines(bounds[i], bounds[i + 1], begin, parts[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Concatenate the parts, keeping the edges in file order
+    unsigned long total = 0;
+    for (auto &part : parts) {
+        total += part.size();
+    }
+    result.reserve(total);
+    for (auto &part : parts) {
+        result.insert(result.end(), part.begin(), part.end());
+        std::vector<Edge>().swap(part);
+    }
+    return result;
+}
+
+/**
+ * A read-only memory mapping of a whole file, which is unmapped when it goes
+ * out of scope
+ */
+struct MappedFile {
+    const char *data;
+    unsigned long length;
+
+    /**
+     * Maps the file with the given name into memory
+     * @throws runtime error if the file can not be opened or mapped
+     */
+    explicit MappedFile(const std::string &name) : data(nullptr), length(0) {
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("MappedFile: could not open " + name + "\n");
+        }
+        struct stat status{};
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            throw std::runtime_error("MappedFile: could not stat " + name + "\n");
+        }
+        length = (unsigned long) status.st_size;
+        if (length == 0) {
+            close(fd);
+            return;
+        }
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("MappedFile: could not map " + name + "\n");
+        }
+        data = static_cast<const char *>(mapping);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap((void *) data, length);
+        }
+    }
+};
+
+std::vector<Edge> readEdgeList(const std::string &name, unsigned int threads) {
+    MappedFile file(name);
+    if (file.length == 0) {
+        return {};
+    }
+    // All chunks are read concurrently, so ask the kernel for the whole file
+    // instead of just read-ahead from the start
+    madvise((void *) file.data, file.length, MADV_WILLNEED);
+    return parseEdgeList(file.data, file.data + file.length, threads);
+}
+
+static const char BINARY_MAGIC[4] = {'D', 'K', '2', 'E'};
+
+bool isBinaryEdgeList(const std::string &name) {
+    char magic[4];
+    std::ifstream file(name, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+void writeBinaryEdgeList(const std::string &name, std::vector<Edge> &edges,
+                         EdgeEncoding encoding) {
+    BinaryEdgeListHeader header{};
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.encoding = encoding;
+    header.vertices = 0;
+    for (auto &edge : edges) {
+        header.vertices = std::max(header.vertices, (uint64_t) std::max(edge.first, edge.second) + 1);
+    }
+    if (encoding == FIXED_32 && header.vertices > (1ul << 32)) {
+        throw std::invalid_argument("writeBinaryEdgeList: vertex id does not fit in 32 bits\n");
+    }
+    if (encoding == DELTA_VARINT) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+    header.edges = edges.size();
+
+    std::ofstream file(name, std::ios::binary | std::ios::trunc);
+    file.write((const char *) &header, sizeof(header));
+    // Encode the edges in pieces, so the buffer stays small for large graphs
+    const unsigned long EDGES_PER_WRITE = 1ul << 16;
+    std::vector<char> buffer;
+    Edge previous(0, 0);
+    for (unsigned long lo = 0; lo < edges.size(); lo += EDGES_PER_WRITE) {
+        unsigned long hi = std::min(edges.size(), lo + EDGES_PER_WRITE);
+        buffer.clear();
+        for (unsigned long i = lo; i < hi; i++) {
+            const Edge &edge = edges[i];
+            if (encoding == FIXED_32) {
+                uint32_t pair[2] = {(uint32_t) edge.first, (uint32_t) edge.second};
+                buffer.insert(buffer.end(), (const char *) pair, (const char *) (pair + 2));
+            } else if (encoding == FIXED_64) {
+                uint64_t pair[2] = {edge.first, edge.second};
+                buffer.insert(buffer.end(), (const char *) pair, (const char *) (pair + 2));
+            } else {
+                putVarint(buffer, edge.first - previous.first);
+                if (edge.first == previous.first) {
+                    putVarint(buffer, edge.second - previous.second);
+                } else {
+                    putVarint(buffer, edge.second);
+                }
+                previous = edge;
+            }
+        }
+        file.write(buffer.data(), buffer.size());
+    }
+    if (!file) {
+        throw std::runtime_error("writeBinaryEdgeList: could not write " + name + "\n");
+    }
+}
+
+std::vector<Edge> readBinaryEdgeList(const std::string &name, unsigned long *vertices) {
+    MappedFile file(name);
+    BinaryEdgeListHeader header{};
+    if (file.length < sizeof(header)) {
+        throw std::runtime_error("readBinaryEdgeList: " + name + " is not a binary edge-list\n");
+    }
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("readBinaryEdgeList: " + name + " is not a binary edge-list\n");
+    }
+    const char *p = file.data + sizeof(header);
+    const char *end = file.data + file.length;
+    unsigned long available = end - p;
+    // The fixed encodings take exactly this many bytes per edge, and a varint
+    // edge at least two, so a corrupt count is caught before allocating
+    unsigned long edgeBytes;
+    if (header.encoding == FIXED_32) {
+        edgeBytes = 2 * sizeof(uint32_t);
+    } else if (header.encoding == FIXED_64) {
+        edgeBytes = 2 * sizeof(uint64_t);
+    } else if (header.encoding == DELTA_VARINT) {
+        edgeBytes = 2;
+    } else {
+        throw std::runtime_error("readBinaryEdgeList: unknown encoding in " + name + "\n");
+    }
+    if (header.edges > available / edgeBytes ||
+        (header.encoding != DELTA_VARINT && available != header.edges * edgeBytes)) {
+        throw std::runtime_error("readBinaryEdgeList: wrong length of " + name + "\n");
+    }
+    madvise((void *) file.data, file.length, MADV_SEQUENTIAL);
+
+    std::vector<Edge> edges(header.edges);
+    if (header.encoding == FIXED_32) {
+        for (auto &edge : edges) {
+            uint32_t pair[2];
+            memcpy(pair, p, sizeof(pair));
+            p += sizeof(pair);
+            edge.first = pair[0];
+            edge.second = pair[1];
+        }
+    } else if (header.encoding == FIXED_64) {
+        for (auto &edge : edges) {
+            uint64_t pair[2];
+            memcpy(pair, p, sizeof(pair));
+            p += sizeof(pair);
+            edge.first = pair[0];
+            edge.second = pair[1];
+        }
+    } else {
+        Edge previous(0, 0);
+        try {
+            for (auto &edge : edges) {
+                edge.first = previous.first + getVarint(p, end);
+                edge.second = getVarint(p, end);
+                if (edge.first == previous.first) {
+                    edge.second += previous.second;
+                }
+                previous = edge;
+            }
+        } catch (const std::runtime_error &e) {
+            throw std::runtime_error("readBinaryEdgeList: " + name + " has fewer edges than its header\n");
+        }
+        if (p != end) {
+            throw std::runtime_error("readBinaryEdgeList: " + name + " has bytes after its last edge\n");
+        }
+    }
+    if (vertices != nullptr) {
+        *vertices = header.vertices;
+    }
+    return edges;
+}
+
+unsigned long convertEdgeList(const std::string &textName, const std::string &binaryName,
+                              EdgeEncoding encoding) {
+    auto edges = readEdgeList(textName);
+    writeBinaryEdgeList(binaryName, edges, encoding);
+    return edges.size();
+}
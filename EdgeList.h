@@ -0,0 +1,142 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_EDGE_LIST_H
+#define DK2TREE_EDGE_LIST_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// A single directed edge (row, column) of the adjacency matrix
+typedef std::pair<unsigned long, unsigned long> Edge;
+
+/// Chunks smaller than this are never handed to a separate thread, since the
+/// cost of starting the thread would exceed the cost of parsing the chunk
+static const unsigned long MIN_PARSE_CHUNK = 1ul << 20;
+
+/**
+ * Parses a text edge-list from the memory range [begin, end).
+ *
+ * Every line contains two non-negative integers separated by white space,
+ * anything after the second integer is ignored (e.g. edge weights). Blank lines
+ * and lines starting with '#' or '%' are skipped, as are '\r' characters, so
+ * SNAP and MatrixMarket style files can be read directly.
+ *
+ * @param begin the first character of the text
+ * @param end one past the last character of the text
+ * @param threads the maximum number of threads to parse with, 0 means one per
+ *        hardware thread
+ * @return the edges in the order in which they appear in the text
+ * @throws invalid argument exception if a line is not a comment and does not
+ *         start with two integers
+ */
+std::vector<Edge>
+parseEdgeList(const char *begin, const char *end, unsigned int threads = 0);
+
+/**
+ * Reads the edge-list file with the given name, by mapping it into memory and
+ * parsing it with `parseEdgeList`
+ *
+ * @param name the location of the file to load
+ * @param threads the maximum number of threads to parse with, 0 means one per
+ *        hardware thread
+ * @return the edges in the order in which they appear in the file
+ * @throws runtime error if the file can not be opened or mapped
+ */
+std::vector<Edge> readEdgeList(const std::string &name, unsigned int threads = 0);
+
+/// The ways in which the edges of a binary edge-list can be stored
+enum EdgeEncoding : uint32_t {
+    FIXED_32 = 1, // every edge is a pair of 32-bit integers
+    FIXED_64 = 2, // every edge is a pair of 64-bit integers
+    DELTA_VARINT = 3 // edges are sorted, and stored as LEB128 varint gaps
+};
+
+/**
+ * The header of a binary edge-list file. It is followed directly by the edges
+ * in the given encoding. In the DELTA_VARINT encoding the edges are sorted
+ * and unique, and every edge is stored as the gap to the previous row,
+ * followed by the column if the row changed or the gap to the previous column
+ * if it did not.
+ */
+struct BinaryEdgeListHeader {
+    char magic[4]; // always "DK2E"
+    uint32_t encoding; // one of the values of `EdgeEncoding`
+    uint64_t vertices; // one more than the highest vertex id in the file
+    uint64_t edges; // the number of edges in the file
+};
+
+/// Appends `value` to `out` as an LEB128 varint
+inline void putVarint(std::vector<char> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char) value);
+}
+
+/**
+ * Decodes an LEB128 varint starting at `p`, which is moved past it
+ * @throws runtime error if the varint does not end before `end`
+ */
+inline uint64_t getVarint(const char *&p, const char *end) {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; p < end && shift < 64; shift += 7) {
+        auto byte = (uint8_t) *p++;
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+    throw std::runtime_error("getVarint: truncated varint\n");
+}
+
+/**
+ * Checks whether the file with the given name starts with the magic bytes of
+ * a binary edge-list
+ */
+bool isBinaryEdgeList(const std::string &name);
+
+/**
+ * Writes the given edges to a binary edge-list file
+ *
+ * @param name the location of the file to write
+ * @param edges the edges to write, these are sorted and deduplicated in place
+ *        when the DELTA_VARINT encoding is used
+ * @param encoding the way to store the edges
+ * @throws invalid argument exception if FIXED_32 is used for a vertex id that
+ *         does not fit in 32 bits
+ * @throws runtime error if the file can not be written
+ */
+void writeBinaryEdgeList(const std::string &name, std::vector<Edge> &edges,
+                         EdgeEncoding encoding);
+
+/**
+ * Reads a binary edge-list file. The edges are decoded from the mapped file
+ * directly into a vector of the exact size, so no allocation is done per edge
+ *
+ * @param name the location of the file to load
+ * @param vertices if not nullptr, receives the number of vertices in the file
+ * @return the edges in the order in which they are stored
+ * @throws runtime error if the file can not be opened or is not a valid
+ *         binary edge-list
+ */
+std::vector<Edge>
+readBinaryEdgeList(const std::string &name, unsigned long *vertices = nullptr);
+
+/**
+ * Converts a text edge-list into a binary edge-list
+ *
+ * @param textName the location of the text file to read
+ * @param binaryName the location of the binary file to write
+ * @param encoding the way to store the edges
+ * @return the number of edges written
+ */
+unsigned long convertEdgeList(const std::string &textName, const std::string &binaryName,
+                              EdgeEncoding encoding);
+
+#endif // DK2TREE_EDGE_LIST_H
@@ -0,0 +1,189 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef EDGE_LIST_TEST
+#define EDGE_LIST_TEST
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "EdgeList.h"
+#include "GraphLoader.h"
+#include "gtest/gtest.h"
+
+TEST(EdgeListTest, CommentsAndBlankLines) {
+    std::string text = "# Directed graph\n"
+                       "% MatrixMarket style comment\n"
+                       "\n"
+                       "0\t1\n"
+                       "  2 3\r\n"
+                       "\t \n"
+                       "4 5 0.25\n"
+                       "18446744073709551615 7";
+    auto edges = parseEdgeList(text.data(), text.data() + text.size(), 1);
+    ASSERT_EQ(4, edges.size());
+    EXPECT_EQ(Edge(0, 1), edges[0]);
+    EXPECT_EQ(Edge(2, 3), edges[1]);
+    EXPECT_EQ(Edge(4, 5), edges[2]);
+    EXPECT_EQ(Edge(~0ul, 7), edges[3]);
+}
+
+TEST(EdgeListTest, MalformedLineThrows) {
+    std::string text = "0 1\n2\n";
+    try {
+        parseEdgeList(text.data(), text.data() + text.size(), 1);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+
+    text = "0 -1\n";
+    try {
+        parseEdgeList(text.data(), text.data() + text.size(), 1);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+/**
+ * Parses a text large enough to be split over several threads, and checks
+ * that the result is the same as when it is parsed by a single thread
+ */
+TEST(EdgeListTest, ParallelMatchesSequential) {
+    std::string text;
+    unsigned long n = 0;
+    while (text.size() < 4 * MIN_PARSE_CHUNK) {
+        if (n % 1000 == 0) {
+            text += "# comment " + std::to_string(n) + "\n\n";
+        }
+        text += std::to_string(n) + " " + std::to_string((n * 7919) % 100003) + "\n";
+        n++;
+    }
+    auto sequential = parseEdgeList(text.data(), text.data() + text.size(), 1);
+    auto parallel = parseEdgeList(text.data(), text.data() + text.size(), 4);
+    ASSERT_EQ(n, sequential.size());
+    ASSERT_EQ(sequential, parallel);
+    for (unsigned long i = 0; i < n; i++) {
+        ASSERT_EQ(Edge(i, (i * 7919) % 100003), parallel[i]);
+    }
+}
+
+TEST(EdgeListTest, ReadFile) {
+    std::string name = testing::TempDir() + "edge_list_test.txt";
+    {
+        std::ofstream file(name);
+        file << "# small graph\n0 1\n1 2\n2 0\n";
+    }
+    auto edges = readEdgeList(name);
+    std::remove(name.c_str());
+    ASSERT_EQ(3, edges.size());
+    EXPECT_EQ(Edge(2, 0), edges[2]);
+
+    try {
+        readEdgeList(name);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::runtime_error &e) {}
+}
+
+TEST(EdgeListTest, BinaryRoundTrip) {
+    std::string name = testing::TempDir() + "edge_list_test.bin";
+    std::vector<Edge> original{{5, 3}, {0, 0}, {70000, 2}, {5, 3}, {5, 1}, {1, 65536}};
+    for (EdgeEncoding encoding : {FIXED_32, FIXED_64, DELTA_VARINT}) {
+        std::vector<Edge> edges(original);
+        writeBinaryEdgeList(name, edges, encoding);
+        ASSERT_TRUE(isBinaryEdgeList(name));
+        unsigned long vertices = 0;
+        auto read = readBinaryEdgeList(name, &vertices);
+        EXPECT_EQ(70001, vertices);
+        if (encoding == DELTA_VARINT) {
+            // The delta encoding stores the edges sorted and without duplicates
+            std::vector<Edge> expected{{0, 0}, {1, 65536}, {5, 1}, {5, 3}, {70000, 2}};
+            EXPECT_EQ(expected, read);
+        } else {
+            EXPECT_EQ(original, read);
+        }
+    }
+    std::remove(name.c_str());
+
+    std::vector<Edge> tooLarge{{0, 1ul << 32}};
+    try {
+        writeBinaryEdgeList(name, tooLarge, FIXED_32);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+TEST(EdgeListTest, CorruptBinaryThrows) {
+    std::string name = testing::TempDir() + "edge_list_test.bin";
+    std::vector<Edge> original{{0, 1}, {2, 3}, {2, 5}, {9, 4}};
+    for (EdgeEncoding encoding : {FIXED_32, FIXED_64, DELTA_VARINT}) {
+        std::vector<Edge> edges(original);
+        writeBinaryEdgeList(name, edges, encoding);
+        std::string bytes;
+        {
+            std::ifstream file(name, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        auto expectThrows = [&](const std::string &contents) {
+            {
+                std::ofstream file(name, std::ios::binary | std::ios::trunc);
+                file.write(contents.data(), contents.size());
+            }
+            try {
+                readBinaryEdgeList(name);
+                ASSERT_FALSE(true); // should not be reached
+            } catch (const std::runtime_error &e) {}
+        };
+        // truncated, with a byte too many, and with an edge count that overflows the length
+        expectThrows(bytes.substr(0, bytes.size() - 1));
+        expectThrows(bytes + '\0');
+        std::string huge = bytes;
+        uint64_t count = (~0ul) / 4 + 1;
+        memcpy(&huge[offsetof(BinaryEdgeListHeader, edges)], &count, sizeof(count));
+        expectThrows(huge);
+    }
+    std::remove(name.c_str());
+}
+
+TEST(EdgeListTest, ConvertTextToBinary) {
+    std::string textName = testing::TempDir() + "edge_list_test.txt";
+    std::string binaryName = testing::TempDir() + "edge_list_test.bin";
+    {
+        std::ofstream file(textName);
+        file << "# small graph\n";
+        for (unsigned long i = 0; i < 1000; i++) {
+            file << i << " " << (i * 31) % 1000 << "\n";
+        }
+    }
+    EXPECT_FALSE(isBinaryEdgeList(textName));
+    ASSERT_EQ(1000, convertEdgeList(textName, binaryName, FIXED_64));
+    EXPECT_EQ(readEdgeList(textName), readBinaryEdgeList(binaryName));
+    std::remove(textName.c_str());
+    std::remove(binaryName.c_str());
+}
+
+TEST(EdgeListTest, MakeGraphFromFile) {
+    std::string name = testing::TempDir() + "edge_list_test.txt";
+    {
+        std::ofstream file(name);
+        file << "0 1\n1 2\n2 0\n40 3\n";
+    }
+    DKTree *tree = makeGraphFromFile(name);
+    ASSERT_EQ(64, tree->capacity());
+    EXPECT_TRUE(tree->reportEdge(40, 3));
+    EXPECT_FALSE(tree->reportEdge(3, 40));
+    try {
+        tree->reportEdge(41, 0);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    delete tree;
+
+    // A size hint larger than the highest id adds isolated vertices
+    tree = makeGraphFromFile(name, false, 100);
+    ASSERT_EQ(128, tree->capacity());
+    EXPECT_FALSE(tree->reportEdge(99, 99));
+    delete tree;
+    std::remove(name.c_str());
+}
+
+#endif // EDGE_LIST_TEST
@@ -0,0 +1,81 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "EpochDKTree.h"
+
+using namespace std;
+
+EpochDKTree::EpochDKTree(unsigned long size, unsigned long readerSlots, Arities shape) : slotCount(readerSlots) {
+    if (readerSlots == 0) {
+        throw invalid_argument("EpochDKTree: invalid argument, there has to be at least one reader slot\n");
+    }
+    slots.reset(new ReaderSlot[readerSlots]);
+    writerTree = DKTree::withSize(size, false, shape);
+    published = writerTree->snapshot();
+}
+
+EpochDKTree::~EpochDKTree() {
+    for (auto &version : retired) {
+        delete version.first;
+    }
+    delete published.load();
+    delete writerTree;
+}
+
+EpochDKTree::ReaderSlot &EpochDKTree::enter() {
+    // readers start looking at different slots, so they rarely compete for one
+    unsigned long first = hash<thread::id>()(this_thread::get_id()) % slotCount;
+    while (true) {
+        for (unsigned long i = 0; i < slotCount; i++) {
+            ReaderSlot &slot = slots[(first + i) % slotCount];
+            unsigned long idle = IDLE;
+            // the epoch may be incremented before the slot is claimed, which only delays the reclamation
+            if (slot.epoch.load() == IDLE && slot.epoch.compare_exchange_strong(idle, epoch.load())) {
+                return slot;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+DKTree *EpochDKTree::read() {
+    ReaderSlot &slot = enter();
+    DKTree *snapshot;
+    try {
+        snapshot = published.load()->snapshot();
+    } catch (...) {
+        slot.epoch.store(IDLE);
+        throw;
+    }
+    slot.epoch.store(IDLE);
+    return snapshot;
+}
+
+void EpochDKTree::publish() {
+    DKTree *version = writerTree->snapshot();
+    DKTree *previous = published.exchange(version);
+    // a reader that announced this epoch or an earlier one may still have loaded the previous version
+    retired.emplace_back(previous, epoch.fetch_add(1));
+    reclaim();
+}
+
+void EpochDKTree::reclaim() {
+    unsigned long oldest = IDLE;
+    for (unsigned long i = 0; i < slotCount; i++) {
+        oldest = min(oldest, slots[i].epoch.load());
+    }
+    auto end = remove_if(retired.begin(), retired.end(), [&](const pair<DKTree *, unsigned long> &version) {
+        if (version.second < oldest) {
+            delete version.first;
+            return true;
+        }
+        return false;
+    });
+    retired.erase(end, retired.end());
+}
@@ -0,0 +1,102 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_EPOCH_DKTREE_H
+#define DK2TREE_EPOCH_DKTREE_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "DKTree.h"
+
+/**
+ * A DKTree that one writer thread changes while any number of reader threads
+ * query it, without locks. The writer changes its own tree, and `publish`
+ * makes the changes visible by replacing the published version with a new
+ * snapshot of the writer's tree (see `DKTree::snapshot`), which shares all
+ * nodes with it. A reader takes a snapshot of the latest published version
+ * with `read`, which has its own cached paths and is never changed, so it
+ * sees the state of one `publish` for as long as it keeps it.
+ *
+ * Versions that are no longer published are retired, and are only deleted,
+ * together with the nodes only they refer to, once no reader can be between
+ * loading the published version and taking its snapshot (epoch-based
+ * reclamation). A reader announces the global epoch in a slot of its own while
+ * it does so, and `publish` increments the epoch after replacing the version,
+ * so a retired version can be deleted once every busy slot has a later epoch.
+ * The nodes of the snapshots are freed by their reference counts, by the
+ * writer or by the reader that releases them last.
+ *
+ * While versions are published, every change of the writer copies the shared
+ * nodes on its path first, so publishing after every batch of changes is much
+ * cheaper than after every change.
+ */
+class EpochDKTree {
+    // the epoch of a reader slot that is not in use
+    static const unsigned long IDLE = ~0ul;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<unsigned long> epoch{IDLE};
+    };
+
+    DKTree *writerTree;
+    std::atomic<DKTree *> published;
+    std::atomic<unsigned long> epoch{0};
+    std::unique_ptr<ReaderSlot[]> slots;
+    unsigned long slotCount;
+    // the versions that were replaced, with the epoch in which they were replaced, only used by the writer
+    std::vector<std::pair<DKTree *, unsigned long>> retired;
+
+    /// Claims a free reader slot and announces the current epoch in it
+    ReaderSlot &enter();
+
+    /// Deletes the retired versions that no reader can still be taking a snapshot of
+    void reclaim();
+
+public:
+    /**
+     * Creates an empty tree, and publishes it
+     * @param size the number of vertices, see `DKTree::withSize`
+     * @param readerSlots the number of readers that can take a snapshot at the same time, others wait for a slot
+     * @param shape the arities of the levels of the tree
+     * @throws illegal argument exception if readerSlots is 0
+     */
+    explicit EpochDKTree(unsigned long size, unsigned long readerSlots = 64, Arities shape = Arities());
+
+    /// Deletes all versions, after all readers are done
+    ~EpochDKTree();
+
+    EpochDKTree(const EpochDKTree &) = delete;
+
+    EpochDKTree &operator=(const EpochDKTree &) = delete;
+
+    /**
+     * The tree of the writer, whose changes are visible to the readers after the next `publish`. Only the
+     * writer thread may use it
+     */
+    DKTree &writer() {
+        return *writerTree;
+    }
+
+    /**
+     * Publishes the current state of the writer's tree, retires the previous version, and deletes the retired
+     * versions that no reader can use anymore. Only the writer thread may call it
+     */
+    void publish();
+
+    /**
+     * Returns a snapshot of the latest published version, which the calling thread can query for as long as
+     * it likes. Any number of threads may call it at the same time, and it does not wait for the writer
+     * @return the snapshot, to be deleted by the caller
+     */
+    DKTree *read();
+
+    /// @return the number of retired versions that are not deleted yet, only for the writer thread
+    unsigned long retiredVersions() const {
+        return retired.size();
+    }
+};
+
+#endif // DK2TREE_EPOCH_DKTREE_H
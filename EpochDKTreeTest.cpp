@@ -0,0 +1,81 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef EPOCH_DKTREE_TEST
+#define EPOCH_DKTREE_TEST
+
+#include <atomic>
+#include <thread>
+#include "EpochDKTree.h"
+#include "gtest/gtest.h"
+
+TEST(EpochDKTreeTest, ReadersSeePublishedVersions) {
+    // in round r, row r gets an edge to every fourth column and row r - 2 loses its edges, so the merges and
+    // splits of the writer replace nodes that readers still use
+    const unsigned long size = 256, rounds = 120;
+    EpochDKTree tree(size, 2);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    std::vector<std::string> failures(4);
+    for (unsigned long t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            unsigned long lastRound = 0;
+            while (!done.load()) {
+                DKTree *version = tree.read();
+                // the published round is the last row with edges, and the rows before it must match it
+                unsigned long round = 0;
+                for (unsigned long row = 0; row < rounds; row++) {
+                    if (!version->reportSuccessors(row).empty()) {
+                        round = row + 1;
+                    }
+                }
+                for (unsigned long row = 0; row < round; row++) {
+                    bool present = row + 2 >= round;
+                    unsigned long expected = present ? size / 4 : 0;
+                    if (version->reportSuccessors(row).size() != expected) {
+                        failures[t] = "row " + std::to_string(row) + " in round " + std::to_string(round);
+                    }
+                }
+                if (round < lastRound) {
+                    failures[t] = "round " + std::to_string(round) + " after " + std::to_string(lastRound);
+                }
+                lastRound = round;
+                delete version;
+            }
+        });
+    }
+    for (unsigned long round = 0; round < rounds; round++) {
+        for (unsigned long column = 0; column < size; column += 4) {
+            tree.writer().addEdge(round, column);
+            if (round >= 2) {
+                tree.writer().removeEdge(round - 2, column);
+            }
+        }
+        tree.publish();
+        if (round % 8 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (auto &failure : failures) {
+        ASSERT_EQ("", failure);
+    }
+    // without readers, every retired version is deleted by the next publish
+    tree.publish();
+    ASSERT_EQ(0, tree.retiredVersions());
+    DKTree *version = tree.read();
+    ASSERT_EQ(size / 4, version->reportSuccessors(rounds - 1).size());
+    ASSERT_TRUE(version->reportSuccessors(rounds - 3).empty());
+    delete version;
+
+    try {
+        EpochDKTree none(size, 0);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+#endif // EPOCH_DKTREE_TEST
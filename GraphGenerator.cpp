@@ -0,0 +1,157 @@
+//
+// Created by agent on 19-10-26.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include "GraphGenerator.h"
+
+static std::vector<Edge> sortedUnique(std::vector<Edge> edges) {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    return edges;
+}
+
+std::vector<Edge> uniformEdges(unsigned long vertices, unsigned long edges, unsigned long seed) {
+    std::mt19937_64 generator(seed);
+    std::vector<Edge> result;
+    result.reserve(edges);
+    for (unsigned long i = 0; i < edges && vertices > 0; i++) {
+        unsigned long row = generator() % vertices;
+        result.emplace_back(row, generator() % vertices);
+    }
+    return sortedUnique(std::move(result));
+}
+
+std::vector<Edge> rmatEdges(unsigned long vertices, unsigned long edges, unsigned long seed,
+                            double a, double b, double c) {
+    if (a < 0 || b < 0 || c < 0 || a + b + c > 1) {
+        throw std::invalid_argument("rmatEdges: invalid quadrant probabilities\n");
+    }
+    unsigned long scale = 0;
+    while ((1ul << scale) < vertices) {
+        scale++;
+    }
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<Edge> result;
+    result.reserve(edges);
+    while (result.size() < edges && vertices > 0) {
+        unsigned long row = 0, column = 0;
+        for (unsigned long level = 0; level < scale; level++) {
+            double r = uniform(generator);
+            unsigned long down = r >= a + b, right = (r >= a && r < a + b) || r >= a + b + c;
+            row = (row << 1) | down;
+            column = (column << 1) | right;
+        }
+        if (row < vertices && column < vertices) {
+            result.emplace_back(row, column);
+        }
+    }
+    return sortedUnique(std::move(result));
+}
+
+std::vector<Edge> barabasiAlbertEdges(unsigned long vertices, unsigned long edgesPerVertex,
+                                      unsigned long seed) {
+    std::mt19937_64 generator(seed);
+    std::vector<Edge> result;
+    // Every vertex appears here once for each edge it is an endpoint of, so a
+    // uniform choice from this list is a choice proportional to the degree
+    std::vector<unsigned long> endpoints;
+    std::vector<unsigned long> targets;
+    for (unsigned long v = 1; v < vertices; v++) {
+        targets.clear();
+        if (v <= edgesPerVertex) {
+            // The first vertices are connected to all vertices before them
+            for (unsigned long target = 0; target < v; target++) {
+                targets.push_back(target);
+            }
+        }
+        while (targets.size() < std::min(edgesPerVertex, v)) {
+            unsigned long target = endpoints[generator() % endpoints.size()];
+            if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+        }
+        for (unsigned long target : targets) {
+            result.emplace_back(v, target);
+            endpoints.push_back(v);
+            endpoints.push_back(target);
+        }
+    }
+    return sortedUnique(std::move(result));
+}
+
+std::vector<Edge> gridEdges(unsigned long rows, unsigned long columns) {
+    std::vector<Edge> result;
+    for (unsigned long r = 0; r < rows; r++) {
+        for (unsigned long c = 0; c < columns; c++) {
+            unsigned long v = r * columns + c;
+            if (c + 1 < columns) {
+                result.emplace_back(v, v + 1);
+                result.emplace_back(v + 1, v);
+            }
+            if (r + 1 < rows) {
+                result.emplace_back(v, v + columns);
+                result.emplace_back(v + columns, v);
+            }
+        }
+    }
+    return sortedUnique(std::move(result));
+}
+
+std::vector<Edge> communityEdges(unsigned long vertices, unsigned long edges, unsigned long communities,
+                                 unsigned long seed, double locality) {
+    if (communities == 0 || communities > vertices) {
+        throw std::invalid_argument("communityEdges: invalid number of communities\n");
+    }
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    unsigned long blockSize = (vertices + communities - 1) / communities;
+    std::vector<Edge> result;
+    result.reserve(edges);
+    for (unsigned long i = 0; i < edges; i++) {
+        unsigned long row = generator() % vertices;
+        unsigned long column;
+        if (uniform(generator) < locality) {
+            unsigned long first = row / blockSize * blockSize;
+            column = first + generator() % (std::min(vertices, first + blockSize) - first);
+        } else {
+            column = generator() % vertices;
+        }
+        result.emplace_back(row, column);
+    }
+    return sortedUnique(std::move(result));
+}
+
+std::vector<Edge> generateGraph(GraphKind kind, unsigned long vertices, unsigned long density,
+                                unsigned long seed) {
+    switch (kind) {
+        case UNIFORM:
+            return uniformEdges(vertices, vertices * density, seed);
+        case RMAT:
+            return rmatEdges(vertices, vertices * density, seed);
+        case BARABASI_ALBERT:
+            return barabasiAlbertEdges(vertices, density, seed);
+        case GRID: {
+            auto rows = (unsigned long) std::sqrt((double) vertices);
+            return gridEdges(rows, rows == 0 ? 0 : vertices / rows);
+        }
+        case COMMUNITY:
+            return communityEdges(vertices, vertices * density,
+                                  std::max(1ul, std::min(vertices, vertices / 256)), seed);
+    }
+    throw std::invalid_argument("generateGraph: unknown graph kind\n");
+}
+
+GraphKind graphKindFromName(const std::string &name) {
+    for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+        if (name == GRAPH_KIND_NAMES[kind]) {
+            return (GraphKind) kind;
+        }
+    }
+    throw std::invalid_argument("graphKindFromName: unknown graph kind " + name + "\n");
+}
@@ -0,0 +1,79 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_GRAPH_GENERATOR_H
+#define DK2TREE_GRAPH_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include "EdgeList.h"
+
+/// The kinds of synthetic graphs that can be generated
+enum GraphKind {
+    UNIFORM = 0, // every edge connects two uniformly random vertices
+    RMAT = 1, // recursive matrix (Kronecker) graph with a power-law degree distribution
+    BARABASI_ALBERT = 2, // preferential attachment graph
+    GRID = 3, // two-dimensional mesh
+    COMMUNITY = 4 // dense blocks of consecutive vertices with few edges between them
+};
+
+inline constexpr const char *GRAPH_KIND_NAMES[] = {"uniform", "rmat", "ba", "grid", "community"};
+
+// All generators are deterministic for a given seed, and return their edges
+// sorted and without duplicates, so they can be passed to DKTree::fromEdges
+// directly. Since duplicates are removed, the number of edges may be slightly
+// lower than requested.
+
+/**
+ * Generates `edges` edges between uniformly random vertices in [0, vertices)
+ */
+std::vector<Edge> uniformEdges(unsigned long vertices, unsigned long edges, unsigned long seed = 1);
+
+/**
+ * Generates an R-MAT graph. Every edge is placed by recursively choosing one
+ * of the four quadrants of the adjacency matrix with probabilities a, b, c and
+ * 1 - a - b - c, until a single cell is left. The default probabilities are
+ * those of the Graph500 benchmark. Edges outside [0, vertices) are redrawn.
+ */
+std::vector<Edge> rmatEdges(unsigned long vertices, unsigned long edges, unsigned long seed = 1,
+                            double a = 0.57, double b = 0.19, double c = 0.19);
+
+/**
+ * Generates a Barabási–Albert graph. Vertices are added one at a time, and
+ * every new vertex gets an edge to `edgesPerVertex` distinct earlier vertices,
+ * chosen with a probability proportional to their degree.
+ */
+std::vector<Edge> barabasiAlbertEdges(unsigned long vertices, unsigned long edgesPerVertex,
+                                      unsigned long seed = 1);
+
+/**
+ * Generates a `rows` by `columns` mesh, where vertex r * columns + c has an
+ * edge to and from each of its horizontal and vertical neighbours
+ */
+std::vector<Edge> gridEdges(unsigned long rows, unsigned long columns);
+
+/**
+ * Generates a graph of `communities` blocks of consecutive vertices. Every edge
+ * starts at a uniformly random vertex, and ends in the same block with
+ * probability `locality` and at a uniformly random vertex otherwise.
+ */
+std::vector<Edge> communityEdges(unsigned long vertices, unsigned long edges, unsigned long communities,
+                                 unsigned long seed = 1, double locality = 0.9);
+
+/**
+ * Generates a graph of the given kind with about `vertices * density` edges,
+ * using the default parameters of its generator. Grids are as square as
+ * possible and always have about four edges per vertex.
+ */
+std::vector<Edge> generateGraph(GraphKind kind, unsigned long vertices, unsigned long density,
+                                unsigned long seed = 1);
+
+/**
+ * Returns the graph kind with the given name from GRAPH_KIND_NAMES
+ *
+ * @throws invalid argument exception if there is no kind with that name
+ */
+GraphKind graphKindFromName(const std::string &name);
+
+#endif // DK2TREE_GRAPH_GENERATOR_H
@@ -0,0 +1,106 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef GRAPH_GENERATOR_TEST
+#define GRAPH_GENERATOR_TEST
+
+#include "DKTree.h"
+#include "GraphGenerator.h"
+#include "gtest/gtest.h"
+
+static void expectValidGraph(const std::vector<Edge> &edges, unsigned long vertices) {
+    for (unsigned long i = 0; i < edges.size(); i++) {
+        ASSERT_LT(edges[i].first, vertices);
+        ASSERT_LT(edges[i].second, vertices);
+        if (i > 0) {
+            ASSERT_LT(edges[i - 1], edges[i]);
+        }
+    }
+}
+
+TEST(GraphGeneratorTest, Deterministic) {
+    for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+        auto edges = generateGraph((GraphKind) kind, 1000, 4, 7);
+        expectValidGraph(edges, 1000);
+        EXPECT_EQ(edges, generateGraph((GraphKind) kind, 1000, 4, 7));
+        EXPECT_GT(edges.size(), 1000);
+        EXPECT_EQ((GraphKind) kind, graphKindFromName(GRAPH_KIND_NAMES[kind]));
+    }
+    EXPECT_NE(rmatEdges(1000, 4000, 1), rmatEdges(1000, 4000, 2));
+    try {
+        graphKindFromName("lattice");
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+TEST(GraphGeneratorTest, Grid) {
+    auto edges = gridEdges(3, 4);
+    // 3 * 3 horizontal and 2 * 4 vertical neighbours, in both directions
+    ASSERT_EQ(2 * (9 + 8), edges.size());
+    EXPECT_TRUE(std::binary_search(edges.begin(), edges.end(), Edge(5, 6)));
+    EXPECT_TRUE(std::binary_search(edges.begin(), edges.end(), Edge(5, 1)));
+    EXPECT_FALSE(std::binary_search(edges.begin(), edges.end(), Edge(3, 4)));
+}
+
+/**
+ * R-MAT and Barabási–Albert graphs should have a few vertices with a much
+ * higher degree than the average, unlike uniform graphs
+ */
+TEST(GraphGeneratorTest, PowerLawDegrees) {
+    unsigned long n = 1 << 14;
+    auto maxDegree = [n](const std::vector<Edge> &edges) {
+        std::vector<unsigned long> degree(n);
+        unsigned long result = 0;
+        for (auto &edge : edges) {
+            result = std::max(result, ++degree[edge.first]);
+            result = std::max(result, ++degree[edge.second]);
+        }
+        return result;
+    };
+    unsigned long uniform = maxDegree(uniformEdges(n, 8 * n));
+    EXPECT_GT(maxDegree(rmatEdges(n, 8 * n)), 10 * uniform);
+    EXPECT_GT(maxDegree(barabasiAlbertEdges(n, 8)), 10 * uniform);
+
+    auto edges = barabasiAlbertEdges(n, 8);
+    EXPECT_EQ(8 * n - 8 * 9 / 2, edges.size());
+}
+
+TEST(GraphGeneratorTest, CommunitiesAreLocal) {
+    auto edges = communityEdges(10000, 50000, 10, 3, 0.9);
+    unsigned long local = 0;
+    for (auto &edge : edges) {
+        local += edge.first / 1000 == edge.second / 1000;
+    }
+    EXPECT_GT(local, 0.85 * edges.size());
+}
+
+/**
+ * Builds every kind of graph by adding its edges one by one, and checks
+ * that the result equals the bulk loaded graph
+ */
+TEST(GraphGeneratorTest, DKTreeFromGenerators) {
+    unsigned long n = 3000;
+    for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+        auto edges = generateGraph((GraphKind) kind, n, 3, 5);
+        DKTree *tree = DKTree::withSize(n);
+        for (auto &edge : edges) {
+            tree->addEdge(edge.first, edge.second);
+        }
+        DKTree *bulk = DKTree::fromEdges(n, edges);
+        std::vector<unsigned long> all(n);
+        for (unsigned long i = 0; i < n; i++) {
+            all[i] = i;
+        }
+        auto added = tree->reportAllEdges(all, all);
+        auto loaded = bulk->reportAllEdges(all, all);
+        std::sort(added.begin(), added.end());
+        std::sort(loaded.begin(), loaded.end());
+        ASSERT_EQ(edges, added);
+        ASSERT_EQ(edges, loaded);
+        delete tree;
+        delete bulk;
+    }
+}
+
+#endif // GRAPH_GENERATOR_TEST
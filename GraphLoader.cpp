@@ -0,0 +1,38 @@
+//
+// Created by hugo on 01/03/19.
+//
+
+#include <algorithm>
+#include <iostream>
+
+#include "GraphLoader.h"
+#include "EdgeList.h"
+
+using std::string;
+
+DKTree *makeGraphFromFile(const string &name, bool verbose, unsigned long sizeHint) {
+    auto edges = readEdgeList(name);
+    // Make sure that the tree has nodes for all endpoints, so that we can
+    // connect them properly
+    unsigned long size = std::max(sizeHint, 1ul);
+    for (auto &edge : edges) {
+        size = std::max(size, std::max(edge.first, edge.second) + 1);
+    }
+    auto tree = DKTree::withSize(size);
+    unsigned long n = 1;
+    for (auto &edge : edges) {
+        if (verbose && n % 10000 == 0) {
+            std::cout << n << '\r';
+            std::cout.flush();
+        }
+        n++;
+        tree->addEdge(edge.first, edge.second);
+    }
+    return tree;
+}
+
+DKTree *makeGraphFromBinaryFile(const string &name, unsigned long sizeHint) {
+    unsigned long vertices = 0;
+    auto edges = readBinaryEdgeList(name, &vertices);
+    return DKTree::fromEdges(std::max({vertices, sizeHint, 1ul}), edges);
+}
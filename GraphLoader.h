@@ -0,0 +1,31 @@
+//
+// Created by hugo on 01/03/19.
+//
+
+#ifndef DK2TREE_GRAPH_LOADER_H
+#define DK2TREE_GRAPH_LOADER_H
+
+#include <string>
+#include "DKTree.h"
+
+/**
+ * Reads an edge-list file with the given name and loads a DKTree from it.
+ * The size of the matrix is determined before any edge is added, so that the
+ * matrix never has to grow while loading
+ * @param name the location of the file to load
+ * @param verbose whether to print the number of edges added so far
+ * @param sizeHint the minimum number of vertices the graph should have
+ * @return a DKTree containing exactly the edges specified by the file
+ */
+DKTree *makeGraphFromFile(const std::string &name, bool verbose = false, unsigned long sizeHint = 0);
+
+/**
+ * Reads a binary edge-list file with the given name and bulk-loads a DKTree
+ * from it, without adding the edges one by one
+ * @param name the location of the binary file to load
+ * @param sizeHint the minimum number of vertices the graph should have
+ * @return a DKTree containing exactly the edges specified by the file
+ */
+DKTree *makeGraphFromBinaryFile(const std::string &name, unsigned long sizeHint = 0);
+
+#endif //DK2TREE_GRAPH_LOADER_H
@@ -0,0 +1,148 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "GraphTraversal.h"
+
+using namespace std;
+
+/// Sorts the sources and removes doubles, checks that they are vertices of the tree, and adds them to the visited set
+static vector<unsigned long> initialFrontier(const DKTree &tree, const vector<unsigned long> &sources,
+                                             VertexSet &visited) {
+    if (sources.empty()) {
+        throw invalid_argument("breadthFirstSearch: invalid argument, no sources\n");
+    }
+    vector<unsigned long> frontier(sources);
+    sort(frontier.begin(), frontier.end());
+    frontier.erase(unique(frontier.begin(), frontier.end()), frontier.end());
+    for (unsigned long source : frontier) {
+        if (source >= tree.vertexBound()) {
+            stringstream error;
+            error << "breadthFirstSearch: invalid argument " << source << ", position does not exist\n";
+            throw invalid_argument(error.str());
+        }
+        if (binary_search(tree.freeEntries().begin(), tree.freeEntries().end(), source)) {
+            stringstream error;
+            error << "breadthFirstSearch: invalid argument " << source << ", vertex has been deleted\n";
+            throw invalid_argument(error.str());
+        }
+        visited.insert(source);
+    }
+    return frontier;
+}
+
+/// Decides whether the next level of a search is found by pulling, based on the size of the frontier compared
+/// to the number of vertices, which leaves out the padding of the matrix beyond vertexBound()
+static bool shouldPull(SearchDirection direction, bool pulling, unsigned long frontier, unsigned long vertices,
+                       const VertexSet &visited) {
+    switch (direction) {
+        case PUSH:
+            return false;
+        case PULL:
+            return true;
+        default:
+            if (pulling) {
+                return frontier * PUSH_FACTOR >= vertices;
+            }
+            return frontier * PULL_FACTOR > vertices - visited.size();
+    }
+}
+
+/// Finds the vertices with a predecessor in the frontier by checking all unvisited vertices below vertexBound()
+static void pullStep(DKTree &tree, const vector<unsigned long> &frontier, vector<unsigned long> &next,
+                     VertexSet &visited) {
+    const unsigned long vertices = tree.vertexBound();
+    vector<unsigned long> candidates;
+    candidates.reserve(vertices - visited.size());
+    for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+        if (!visited.contains(vertex)) {
+            candidates.push_back(vertex);
+        }
+    }
+    tree.expandFrontierPull(frontier, candidates, next, visited);
+}
+
+Traversal breadthFirstSearch(DKTree &tree, const vector<unsigned long> &sources, unsigned long maxHops,
+                             SearchDirection direction) {
+    VertexSet visited(tree.capacity());
+    vector<unsigned long> frontier = initialFrontier(tree, sources, visited);
+    Traversal result;
+    result.vertices = frontier;
+    result.levelStarts.push_back(frontier.size());
+
+    bool pulling = false;
+    vector<unsigned long> next;
+    for (unsigned long hop = 0; hop < maxHops; hop++) {
+        next.clear();
+        pulling = shouldPull(direction, pulling, frontier.size(), tree.vertexBound(), visited);
+        if (pulling) {
+            pullStep(tree, frontier, next, visited);
+        } else {
+            tree.expandFrontier(frontier, next, &visited);
+        }
+        if (next.empty()) {
+            break;
+        }
+        // the frontier has to be sorted for the next expansion
+        sort(next.begin(), next.end());
+        result.vertices.insert(result.vertices.end(), next.begin(), next.end());
+        result.levelStarts.push_back(result.vertices.size());
+        frontier.swap(next);
+    }
+    return result;
+}
+
+vector<unsigned long> kHopNeighbourhood(DKTree &tree, unsigned long source, unsigned long hops) {
+    vector<unsigned long> neighbourhood = breadthFirstSearch(tree, {source}, hops).vertices;
+    sort(neighbourhood.begin(), neighbourhood.end());
+    return neighbourhood;
+}
+
+vector<unsigned long> depthFirstSearch(DKTree &tree, unsigned long source) {
+    // every frame holds the successors of a vertex on the current path, and the next one to visit
+    struct Frame {
+        vector<unsigned long> successors;
+        unsigned long next;
+    };
+    VertexSet visited(tree.capacity());
+    vector<unsigned long> order{source};
+    vector<Frame> path{Frame{tree.reportSuccessors(source), 0}};
+    visited.insert(source);
+    while (!path.empty()) {
+        Frame &top = path.back();
+        if (top.next == top.successors.size()) {
+            path.pop_back();
+            continue;
+        }
+        unsigned long vertex = top.successors[top.next++];
+        if (visited.insert(vertex)) {
+            order.push_back(vertex);
+            path.push_back(Frame{tree.reportSuccessors(vertex), 0});
+        }
+    }
+    return order;
+}
+
+bool isReachable(DKTree &tree, unsigned long source, unsigned long target) {
+    VertexSet visited(tree.capacity());
+    vector<unsigned long> frontier = initialFrontier(tree, {source, target}, visited);
+    // the target was only added to check that it exists
+    visited.erase(target);
+    frontier = {source};
+    visited.insert(source);
+    vector<unsigned long> next;
+    while (!visited.contains(target)) {
+        next.clear();
+        tree.expandFrontier(frontier, next, &visited);
+        if (next.empty()) {
+            return false;
+        }
+        sort(next.begin(), next.end());
+        frontier.swap(next);
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_GRAPH_TRAVERSAL_H
+#define DK2TREE_GRAPH_TRAVERSAL_H
+
+#include <climits>
+#include <vector>
+#include "DKTree.h"
+
+/// The hop limit of an unbounded traversal
+static const unsigned long UNBOUNDED_HOPS = ULONG_MAX;
+
+/// A direction-optimizing search switches from push to pull steps once the
+/// frontier is larger than the number of unvisited vertices divided by this
+static const unsigned long PULL_FACTOR = 14;
+
+/// A direction-optimizing search switches back from pull to push steps once the
+/// frontier is smaller than the number of vertices divided by this
+static const unsigned long PUSH_FACTOR = 24;
+
+/**
+ * How a breadth-first search finds the next level: PUSH expands the successors
+ * of the frontier, PULL checks for every unvisited vertex whether it has a
+ * predecessor in the frontier, and DIRECTION_OPTIMIZING pulls while the
+ * frontier is large and pushes otherwise
+ */
+enum SearchDirection {
+    PUSH, PULL, DIRECTION_OPTIMIZING
+};
+
+/**
+ * The vertices reached by a breadth-first search, level by level: the vertices
+ * at distance `d` from the sources are vertices[levelStarts[d]] ...
+ * vertices[levelStarts[d + 1] - 1], in increasing order, and the sources
+ * themselves form level 0
+ */
+struct Traversal {
+    std::vector<unsigned long> vertices;
+    std::vector<unsigned long> levelStarts{0};
+
+    /// @return the number of levels, one more than the largest distance reached
+    unsigned long levels() const {
+        return levelStarts.size() - 1;
+    }
+
+    /// @return the vertices at distance `distance` of the sources
+    std::vector<unsigned long> level(unsigned long distance) const {
+        return std::vector<unsigned long>(vertices.begin() + levelStarts[distance],
+                                          vertices.begin() + levelStarts[distance + 1]);
+    }
+};
+
+/**
+ * Breadth-first search from all sources at once. Every level is found with a
+ * single `DKTree::expandFrontier` or `DKTree::expandFrontierPull`, which
+ * descend the tree once for the whole frontier, and a visited bitmap makes sure
+ * every vertex is reported once. In the middle levels of a search on a graph
+ * with a small diameter, the frontier contains a large part of the graph, and
+ * pulling is much cheaper than pushing since every unvisited vertex only needs
+ * one predecessor in the frontier.
+ *
+ * @param tree the graph to search
+ * @param sources the vertices at distance 0, doubles are allowed
+ * @param maxHops the largest distance to search, UNBOUNDED_HOPS for all reachable vertices
+ * @param direction how the levels are expanded, the result is the same for all directions
+ * @return the vertices within maxHops hops of a source, grouped by their distance
+ * @throws illegal argument exception if there are no sources, or if a source is
+ *         not below the first free column of the tree or has been deleted
+ */
+Traversal breadthFirstSearch(DKTree &tree, const std::vector<unsigned long> &sources,
+                             unsigned long maxHops = UNBOUNDED_HOPS,
+                             SearchDirection direction = DIRECTION_OPTIMIZING);
+
+/**
+ * Reports the k-hop neighbourhood of a vertex
+ * @return all vertices that can be reached from source in at most hops steps, in increasing order,
+ *         including the source itself
+ */
+std::vector<unsigned long> kHopNeighbourhood(DKTree &tree, unsigned long source, unsigned long hops);
+
+/**
+ * Depth-first search from a single source, which visits the successors of every
+ * vertex in increasing order
+ * @return the vertices reachable from source in the order in which they are first visited
+ * @throws illegal argument exception if source is not present in the tree
+ */
+std::vector<unsigned long> depthFirstSearch(DKTree &tree, unsigned long source);
+
+/// @return whether there is a path from source to target, found by a breadth-first search that stops at the target
+bool isReachable(DKTree &tree, unsigned long source, unsigned long target);
+
+#endif // DK2TREE_GRAPH_TRAVERSAL_H
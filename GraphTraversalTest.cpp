@@ -0,0 +1,186 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef GRAPH_TRAVERSAL_TEST
+#define GRAPH_TRAVERSAL_TEST
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include "GraphGenerator.h"
+#include "GraphTraversal.h"
+#include "gtest/gtest.h"
+
+// the distance of every vertex from the sources by a textbook breadth-first search, ULONG_MAX if unreachable
+static std::vector<unsigned long> referenceDistances(const std::vector<Edge> &edges, unsigned long vertices,
+                                                     const std::vector<unsigned long> &sources) {
+    std::vector<std::vector<unsigned long>> successors(vertices);
+    for (auto &edge : edges) {
+        successors[edge.first].push_back(edge.second);
+    }
+    std::vector<unsigned long> distance(vertices, ULONG_MAX);
+    std::queue<unsigned long> queue;
+    for (unsigned long source : sources) {
+        distance[source] = 0;
+        queue.push(source);
+    }
+    while (!queue.empty()) {
+        unsigned long vertex = queue.front();
+        queue.pop();
+        for (unsigned long successor : successors[vertex]) {
+            if (distance[successor] == ULONG_MAX) {
+                distance[successor] = distance[vertex] + 1;
+                queue.push(successor);
+            }
+        }
+    }
+    return distance;
+}
+
+static void expectLevelsMatch(const Traversal &traversal, const std::vector<unsigned long> &distance,
+                              unsigned long maxHops) {
+    std::vector<unsigned long> expected;
+    for (unsigned long hop = 0; hop < traversal.levels(); hop++) {
+        expected.clear();
+        for (unsigned long vertex = 0; vertex < distance.size(); vertex++) {
+            if (distance[vertex] == hop) {
+                expected.push_back(vertex);
+            }
+        }
+        ASSERT_EQ(expected, traversal.level(hop)) << "level " << hop;
+    }
+    // nothing within the hop limit was missed
+    for (unsigned long vertex = 0; vertex < distance.size(); vertex++) {
+        if (distance[vertex] < traversal.levels()) {
+            continue;
+        }
+        ASSERT_TRUE(distance[vertex] == ULONG_MAX || distance[vertex] > maxHops) << "vertex " << vertex;
+    }
+}
+
+TEST(GraphTraversalTest, BreadthFirstSearchMatchesReference) {
+    const unsigned long vertices = 3000;
+    Arities hybrid;
+    hybrid.top = 4;
+    hybrid.topLevels = 2;
+    for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+        auto edges = generateGraph((GraphKind) kind, vertices, 2, 5);
+        auto distance = referenceDistances(edges, vertices, {0});
+        auto multiDistance = referenceDistances(edges, vertices, {7, 1500, 2999});
+        for (int mode = 0; mode < 3; mode++) {
+            DKTree *tree = DKTree::fromEdges(vertices, edges, mode == 2, mode == 1 ? hybrid : Arities());
+            for (int direction = PUSH; direction <= DIRECTION_OPTIMIZING; direction++) {
+                expectLevelsMatch(breadthFirstSearch(*tree, {0}, UNBOUNDED_HOPS, (SearchDirection) direction),
+                                  distance, UNBOUNDED_HOPS);
+                expectLevelsMatch(breadthFirstSearch(*tree, {2999, 7, 1500, 7}, UNBOUNDED_HOPS,
+                                                     (SearchDirection) direction), multiDistance, UNBOUNDED_HOPS);
+            }
+            Traversal bounded = breadthFirstSearch(*tree, {0}, 2);
+            ASSERT_LE(bounded.levels(), 3);
+            expectLevelsMatch(bounded, distance, 2);
+
+            std::vector<unsigned long> twoHops;
+            for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+                if (distance[vertex] <= 2) {
+                    twoHops.push_back(vertex);
+                }
+            }
+            ASSERT_EQ(twoHops, kHopNeighbourhood(*tree, 0, 2));
+            delete tree;
+        }
+    }
+}
+
+TEST(GraphTraversalTest, SuccessorsAndDepthFirstSearch) {
+    const unsigned long vertices = 500;
+    auto edges = uniformEdges(vertices, 1500, 3);
+    DKTree *tree = DKTree::fromEdges(vertices, edges);
+    std::vector<std::vector<unsigned long>> successors(vertices);
+    for (auto &edge : edges) {
+        successors[edge.first].push_back(edge.second);
+    }
+    for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+        std::sort(successors[vertex].begin(), successors[vertex].end());
+        successors[vertex].erase(std::unique(successors[vertex].begin(), successors[vertex].end()),
+                                 successors[vertex].end());
+        ASSERT_EQ(successors[vertex], tree->reportSuccessors(vertex));
+    }
+
+    // a recursive depth-first search that visits the successors in increasing order
+    std::vector<unsigned long> expected;
+    std::vector<bool> visited(vertices, false);
+    std::function<void(unsigned long)> visit = [&](unsigned long vertex) {
+        visited[vertex] = true;
+        expected.push_back(vertex);
+        for (unsigned long successor : successors[vertex]) {
+            if (!visited[successor]) {
+                visit(successor);
+            }
+        }
+    };
+    visit(42);
+    ASSERT_EQ(expected, depthFirstSearch(*tree, 42));
+
+    auto distance = referenceDistances(edges, vertices, {42});
+    for (unsigned long target = 0; target < vertices; target += 7) {
+        ASSERT_EQ(distance[target] != ULONG_MAX, isReachable(*tree, 42, target));
+    }
+    delete tree;
+}
+
+TEST(GraphTraversalTest, InvalidArguments) {
+    DKTree *tree = DKTree::withSize(10);
+    tree->addEdge(1, 2);
+    std::vector<unsigned long> next;
+    try {
+        tree->expandFrontier({2, 1}, next);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        tree->expandFrontier({10}, next);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        breadthFirstSearch(*tree, {});
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    // 12 is below capacity() but not a vertex, and a deleted vertex is no source either
+    tree->deleteEntry(5);
+    for (int direction = PUSH; direction <= DIRECTION_OPTIMIZING; direction++) {
+        for (unsigned long source : {12ul, 5ul}) {
+            for (unsigned long maxHops : {0ul, UNBOUNDED_HOPS}) {
+                try {
+                    breadthFirstSearch(*tree, {1, source}, maxHops, (SearchDirection) direction);
+                    ASSERT_FALSE(true); // should not be reached
+                } catch (const std::invalid_argument &e) {}
+            }
+        }
+    }
+    std::vector<unsigned long> frontier{1};
+    VertexSet visited(tree->capacity());
+    try {
+        tree->expandFrontierPull(frontier, {3, 2}, next, visited);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        tree->expandFrontierPull({2, 1}, {2}, next, visited);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        VertexSet small(5);
+        tree->expandFrontierPull(frontier, {2}, next, small);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    ASSERT_TRUE(next.empty());
+    tree->expandFrontierPull(frontier, {0, 1, 2, 3}, next, visited);
+    ASSERT_EQ(std::vector<unsigned long>{2}, next);
+    ASSERT_TRUE(visited.contains(2));
+    next.clear();
+    ASSERT_FALSE(isReachable(*tree, 2, 1));
+    ASSERT_TRUE(isReachable(*tree, 1, 2));
+    ASSERT_TRUE(next.empty());
+    delete tree;
+}
+
+#endif // GRAPH_TRAVERSAL_TEST
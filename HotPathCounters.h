@@ -0,0 +1,78 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_HOT_PATH_COUNTERS_H
+#define DK2TREE_HOT_PATH_COUNTERS_H
+
+#include <ostream>
+
+/**
+ * Counts of the events on the hot paths of the TTree, LTree and DKTree, used
+ * to find out why a workload is slow. The counters are only maintained when
+ * compiling with DK2TREE_COUNTERS defined (the CMake option of the same name),
+ * otherwise `HOT_PATH_COUNT` compiles to nothing and all counters stay zero.
+ * The counters are thread local, so they only count the calling thread's work
+ */
+struct HotPathCounters {
+    unsigned long pathHits = 0; // leaf searches that started from a cached path below the root
+    unsigned long rootDescents = 0; // leaf searches that started at the root
+    unsigned long findChildSteps = 0; // entries of internal nodes inspected while searching
+    unsigned long leafSplits = 0;
+    unsigned long internalSplits = 0;
+    unsigned long leafMerges = 0;
+    unsigned long internalMerges = 0;
+    unsigned long spills = 0; // blocks or children moved to a sibling instead of splitting
+    unsigned long steals = 0; // blocks or children taken from a sibling instead of merging
+    unsigned long matrixGrowths = 0; // calls to DKTree::increaseMatrixSize
+    unsigned long bitsShifted = 0; // bits moved by BitVector::insert and BitVector::erase
+};
+
+#ifdef DK2TREE_COUNTERS
+inline thread_local HotPathCounters hotPathCounters;
+#define HOT_PATH_COUNT(field, n) (hotPathCounters.field += (n))
+#else
+#define HOT_PATH_COUNT(field, n) ((void) 0)
+#endif
+
+/// Whether this build maintains the hot path counters
+static const bool HOT_PATH_COUNTERS_ENABLED =
+#ifdef DK2TREE_COUNTERS
+        true;
+#else
+        false;
+#endif
+
+/**
+ * @return a copy of the current thread's counters, all zeros if they are disabled
+ */
+inline HotPathCounters hotPathSnapshot() {
+#ifdef DK2TREE_COUNTERS
+    return hotPathCounters;
+#else
+    return HotPathCounters();
+#endif
+}
+
+/// Sets all counters of the current thread to zero
+inline void resetHotPathCounters() {
+#ifdef DK2TREE_COUNTERS
+    hotPathCounters = HotPathCounters();
+#endif
+}
+
+inline std::ostream &operator<<(std::ostream &out, const HotPathCounters &counters) {
+    return out << "path hits " << counters.pathHits
+               << ", root descents " << counters.rootDescents
+               << ", findChild steps " << counters.findChildSteps
+               << ", leaf splits " << counters.leafSplits
+               << ", internal splits " << counters.internalSplits
+               << ", leaf merges " << counters.leafMerges
+               << ", internal merges " << counters.internalMerges
+               << ", spills " << counters.spills
+               << ", steals " << counters.steals
+               << ", matrix growths " << counters.matrixGrowths
+               << ", bits shifted " << counters.bitsShifted;
+}
+
+#endif // DK2TREE_HOT_PATH_COUNTERS_H
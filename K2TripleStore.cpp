@@ -0,0 +1,228 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "K2TripleStore.h"
+
+using namespace std;
+
+K2TripleStore::K2TripleStore(bool indexSubjects, bool vocabulary, Arities shape)
+        : indexSubjects(indexSubjects), vocabulary(vocabulary), shape(shape), treeSize(0) {}
+
+K2TripleStore::~K2TripleStore() {
+    for (DKTree *tree : trees) {
+        delete tree;
+    }
+}
+
+K2TripleStore *K2TripleStore::fromTriples(unsigned long size, const vector<Triple> &triples, bool indexSubjects,
+                                          bool vocabulary, Arities shape) {
+    auto store = new K2TripleStore(indexSubjects, vocabulary, shape);
+    store->treeSize = size;
+    store->firstFreeVertex = size;
+    // the edges of every predicate, which are loaded into its tree at once
+    vector<vector<pair<unsigned long, unsigned long>>> edges;
+    for (const Triple &triple : triples) {
+        if (triple.predicate >= edges.size()) {
+            edges.resize(triple.predicate + 1);
+        }
+        edges[triple.predicate].emplace_back(triple.subject, triple.object);
+    }
+    store->trees.resize(edges.size(), nullptr);
+    if (indexSubjects) {
+        store->subjectPredicates.resize(size);
+    }
+    try {
+        for (unsigned long predicate = 0; predicate < edges.size(); predicate++) {
+            if (edges[predicate].empty()) {
+                continue;
+            }
+            store->trees[predicate] = DKTree::fromEdges(size, edges[predicate], vocabulary, shape);
+            if (!indexSubjects) {
+                continue;
+            }
+            // the predicates are visited in increasing order, so every index stays sorted
+            for (auto &edge : edges[predicate]) {
+                auto &predicates = store->subjectPredicates[edge.first];
+                if (predicates.empty() || predicates.back() != predicate) {
+                    predicates.push_back(predicate);
+                }
+            }
+        }
+    } catch (...) {
+        delete store;
+        throw;
+    }
+    return store;
+}
+
+void K2TripleStore::checkVertex(unsigned long vertex, const char *functionName) const {
+    if (vertex >= firstFreeVertex || binary_search(freeVertices.begin(), freeVertices.end(), vertex)) {
+        stringstream error;
+        error << functionName << ": invalid argument " << vertex << ", vertex not present in the store\n";
+        throw invalid_argument(error.str());
+    }
+}
+
+unsigned long K2TripleStore::insertVertex() {
+    if (!freeVertices.empty()) {
+        unsigned long vertex = freeVertices.front();
+        freeVertices.erase(freeVertices.begin());
+        return vertex;
+    }
+    if (firstFreeVertex == treeSize) {
+        // all trees grow together, by doubling, so a tree is not touched for every new vertex
+        treeSize = max(2 * treeSize, 1ul);
+        for (DKTree *tree : trees) {
+            if (tree != nullptr) {
+                tree->extendTo(treeSize);
+            }
+        }
+    }
+    if (indexSubjects) {
+        subjectPredicates.resize(firstFreeVertex + 1);
+    }
+    return firstFreeVertex++;
+}
+
+void K2TripleStore::deleteVertex(unsigned long vertex) {
+    checkVertex(vertex, "deleteVertex");
+    for (unsigned long predicate = 0; predicate < trees.size(); predicate++) {
+        DKTree *tree = trees[predicate];
+        if (tree == nullptr) {
+            continue;
+        }
+        vector<unsigned long> subjects;
+        if (indexSubjects) {
+            subjects = tree->reportPredecessors(vertex);
+        }
+        tree->clearEntry(vertex);
+        for (unsigned long subject : subjects) {
+            unindexIfEmpty(subject, predicate);
+        }
+    }
+    if (indexSubjects) {
+        subjectPredicates[vertex].clear();
+    }
+    if (vertex == firstFreeVertex - 1) {
+        firstFreeVertex--;
+    } else {
+        freeVertices.insert(lower_bound(freeVertices.begin(), freeVertices.end(), vertex), vertex);
+    }
+}
+
+void K2TripleStore::unindexIfEmpty(unsigned long subject, unsigned long predicate) {
+    if (!trees[predicate]->reportSuccessors(subject).empty()) {
+        return;
+    }
+    auto &predicates = subjectPredicates[subject];
+    auto position = lower_bound(predicates.begin(), predicates.end(), predicate);
+    if (position != predicates.end() && *position == predicate) {
+        predicates.erase(position);
+    }
+}
+
+void K2TripleStore::addTriple(unsigned long subject, unsigned long predicate, unsigned long object) {
+    checkVertex(subject, "addTriple");
+    checkVertex(object, "addTriple");
+    if (predicate >= trees.size()) {
+        trees.resize(predicate + 1, nullptr);
+    }
+    if (trees[predicate] == nullptr) {
+        trees[predicate] = DKTree::withSize(treeSize, vocabulary, shape);
+    }
+    trees[predicate]->addEdge(subject, object);
+    if (indexSubjects) {
+        auto &predicates = subjectPredicates[subject];
+        auto position = lower_bound(predicates.begin(), predicates.end(), predicate);
+        if (position == predicates.end() || *position != predicate) {
+            predicates.insert(position, predicate);
+        }
+    }
+}
+
+void K2TripleStore::removeTriple(unsigned long subject, unsigned long predicate, unsigned long object) {
+    checkVertex(subject, "removeTriple");
+    checkVertex(object, "removeTriple");
+    DKTree *tree = treeOf(predicate);
+    if (tree == nullptr) {
+        return;
+    }
+    tree->removeEdge(subject, object);
+    if (indexSubjects) {
+        unindexIfEmpty(subject, predicate);
+    }
+}
+
+bool K2TripleStore::containsTriple(unsigned long subject, unsigned long predicate, unsigned long object) {
+    checkVertex(subject, "containsTriple");
+    checkVertex(object, "containsTriple");
+    DKTree *tree = treeOf(predicate);
+    return tree != nullptr && tree->reportEdge(subject, object);
+}
+
+vector<unsigned long> K2TripleStore::objects(unsigned long subject, unsigned long predicate) {
+    checkVertex(subject, "objects");
+    DKTree *tree = treeOf(predicate);
+    return tree == nullptr ? vector<unsigned long>() : tree->reportSuccessors(subject);
+}
+
+vector<unsigned long> K2TripleStore::subjects(unsigned long predicate, unsigned long object) {
+    checkVertex(object, "subjects");
+    DKTree *tree = treeOf(predicate);
+    return tree == nullptr ? vector<unsigned long>() : tree->reportPredecessors(object);
+}
+
+vector<unsigned long> K2TripleStore::predicates(unsigned long subject, unsigned long object) {
+    checkVertex(subject, "predicates");
+    checkVertex(object, "predicates");
+    vector<unsigned long> result;
+    auto check = [&](unsigned long predicate) {
+        DKTree *tree = trees[predicate];
+        if (tree != nullptr && tree->reportEdge(subject, object)) {
+            result.push_back(predicate);
+        }
+    };
+    if (indexSubjects) {
+        for (unsigned long predicate : subjectPredicates[subject]) {
+            check(predicate);
+        }
+    } else {
+        for (unsigned long predicate = 0; predicate < trees.size(); predicate++) {
+            check(predicate);
+        }
+    }
+    return result;
+}
+
+vector<pair<unsigned long, unsigned long>> K2TripleStore::predicatesAndObjects(unsigned long subject) {
+    checkVertex(subject, "predicatesAndObjects");
+    vector<pair<unsigned long, unsigned long>> result;
+    auto collect = [&](unsigned long predicate) {
+        DKTree *tree = trees[predicate];
+        if (tree == nullptr) {
+            return;
+        }
+        for (unsigned long object : tree->reportSuccessors(subject)) {
+            result.emplace_back(predicate, object);
+        }
+    };
+    if (indexSubjects) {
+        for (unsigned long predicate : subjectPredicates[subject]) {
+            collect(predicate);
+        }
+    } else {
+        for (unsigned long predicate = 0; predicate < trees.size(); predicate++) {
+            collect(predicate);
+        }
+    }
+    return result;
+}
+
+unsigned long K2TripleStore::predicateTrees() const {
+    return count_if(trees.begin(), trees.end(), [](DKTree *tree) { return tree != nullptr; });
+}
@@ -0,0 +1,156 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_K2_TRIPLE_STORE_H
+#define DK2TREE_K2_TRIPLE_STORE_H
+
+#include <utility>
+#include <vector>
+#include "DKTree.h"
+
+/// A single (subject, predicate, object) statement of a triple store
+struct Triple {
+    unsigned long subject;
+    unsigned long predicate;
+    unsigned long object;
+};
+
+/**
+ * A set of triples, stored as one k2-tree per predicate, in which a triple
+ * (s, p, o) is the edge (s, o) of the tree of p (the vertical partitioning of
+ * the k2-triples representation). Subjects and objects share a single vertex
+ * id space with one free-list for the whole store, so adding or deleting a
+ * vertex does not touch every tree separately, and the tree of a predicate is
+ * only created by its first triple.
+ *
+ * Patterns with a fixed predicate are answered by a single tree. Patterns with
+ * a variable predicate have to ask every tree, unless the store keeps an index
+ * of the predicates used by every subject, in which case only those trees are
+ * asked.
+ *
+ * Predicates are numbered 0, 1, ..., and the store keeps a slot for every
+ * predicate below the highest one used.
+ */
+class K2TripleStore {
+    std::vector<DKTree *> trees; // the tree of every predicate, nullptr if the predicate has no tree yet
+    // the predicates of every subject, in increasing order, if subjects are indexed
+    std::vector<std::vector<unsigned long>> subjectPredicates;
+    bool indexSubjects;
+    bool vocabulary;
+    Arities shape;
+    unsigned long treeSize; // every tree contains the vertices 0 ... treeSize - 1
+    unsigned long firstFreeVertex = 0;
+    std::vector<unsigned long> freeVertices; // the deleted vertices below firstFreeVertex, in increasing order
+
+    /// @throws illegal argument exception if the vertex is not present in the store
+    void checkVertex(unsigned long vertex, const char *functionName) const;
+
+    /// @return the tree of the predicate, nullptr if there are no triples with it
+    DKTree *treeOf(unsigned long predicate) const {
+        return predicate < trees.size() ? trees[predicate] : nullptr;
+    }
+
+    /// Removes the predicate from the index of the subject if the subject has no triples with it anymore
+    void unindexIfEmpty(unsigned long subject, unsigned long predicate);
+
+public:
+    /**
+     * Creates an empty triple store
+     * @param indexSubjects whether to keep the predicates of every subject, which speeds up the patterns
+     *        with a variable predicate at the cost of one entry per (subject, predicate) pair
+     * @param vocabulary whether the trees of the predicates use vocabulary mode, see `DKTree::withSize`
+     * @param shape the arities of the levels of the trees of the predicates
+     */
+    explicit K2TripleStore(bool indexSubjects = true, bool vocabulary = false, Arities shape = Arities());
+
+    ~K2TripleStore();
+
+    K2TripleStore(const K2TripleStore &) = delete;
+
+    K2TripleStore &operator=(const K2TripleStore &) = delete;
+
+    /**
+     * Builds a triple store with `size` vertices containing exactly the given triples, by bulk-loading the
+     * tree of every predicate with `DKTree::fromEdges`
+     * @param size the number of vertices, which get the ids 0 ... size - 1
+     * @param triples the triples, duplicates are allowed
+     * @throws illegal argument exception if a subject or object is >= size
+     */
+    static K2TripleStore *fromTriples(unsigned long size, const std::vector<Triple> &triples,
+                                      bool indexSubjects = true, bool vocabulary = false, Arities shape = Arities());
+
+    /**
+     * Adds a vertex to the store, reusing the lowest deleted vertex if there is one
+     * @return the id of the new vertex
+     */
+    unsigned long insertVertex();
+
+    /**
+     * Deletes a vertex and all triples in which it is the subject or the object
+     * @throws illegal argument exception if the vertex is not present in the store
+     */
+    void deleteVertex(unsigned long vertex);
+
+    /**
+     * Adds the triple (subject, predicate, object), creating the tree of the predicate if needed
+     * @throws illegal argument exception if subject or object is not present in the store
+     */
+    void addTriple(unsigned long subject, unsigned long predicate, unsigned long object);
+
+    /**
+     * Removes the triple (subject, predicate, object), if it is in the store
+     * @throws illegal argument exception if subject or object is not present in the store
+     */
+    void removeTriple(unsigned long subject, unsigned long predicate, unsigned long object);
+
+    /**
+     * @return whether the triple (subject, predicate, object) is in the store
+     * @throws illegal argument exception if subject or object is not present in the store
+     */
+    bool containsTriple(unsigned long subject, unsigned long predicate, unsigned long object);
+
+    /**
+     * The pattern (s, p, ?)
+     * @return the objects of the triples with the given subject and predicate, in increasing order
+     * @throws illegal argument exception if subject is not present in the store
+     */
+    std::vector<unsigned long> objects(unsigned long subject, unsigned long predicate);
+
+    /**
+     * The pattern (?, p, o)
+     * @return the subjects of the triples with the given predicate and object, in increasing order
+     * @throws illegal argument exception if object is not present in the store
+     */
+    std::vector<unsigned long> subjects(unsigned long predicate, unsigned long object);
+
+    /**
+     * The pattern (s, ?, o), which checks a single bit in the tree of every predicate of the subject
+     * @return the predicates of the triples with the given subject and object, in increasing order
+     * @throws illegal argument exception if subject or object is not present in the store
+     */
+    std::vector<unsigned long> predicates(unsigned long subject, unsigned long object);
+
+    /**
+     * The pattern (s, ?, ?), which reads the row of the subject in the tree of every predicate of the subject
+     * @return the (predicate, object) pairs of the triples with the given subject, ordered by predicate and
+     *         then by object
+     * @throws illegal argument exception if subject is not present in the store
+     */
+    std::vector<std::pair<unsigned long, unsigned long>> predicatesAndObjects(unsigned long subject);
+
+    /// @return the number of predicates that have a tree, those with at least one triple at some point
+    unsigned long predicateTrees() const;
+
+    /// @return one more than the largest vertex id in use
+    unsigned long vertexBound() const {
+        return firstFreeVertex;
+    }
+
+    /// @return whether the predicates of every subject are indexed
+    bool indexesSubjects() const {
+        return indexSubjects;
+    }
+};
+
+#endif // DK2TREE_K2_TRIPLE_STORE_H
@@ -0,0 +1,153 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef K2_TRIPLE_STORE_TEST
+#define K2_TRIPLE_STORE_TEST
+
+#include <random>
+#include <set>
+#include <tuple>
+#include "K2TripleStore.h"
+#include "gtest/gtest.h"
+
+typedef std::tuple<unsigned long, unsigned long, unsigned long> TripleKey;
+
+// answers all four patterns from a plain set of triples, and compares them with the store
+static void expectPatternsMatch(K2TripleStore &store, const std::set<TripleKey> &reference,
+                                const std::vector<unsigned long> &vertices, unsigned long predicates) {
+    for (unsigned long subject : vertices) {
+        std::vector<std::pair<unsigned long, unsigned long>> expected;
+        for (auto &triple : reference) {
+            if (std::get<0>(triple) == subject) {
+                expected.emplace_back(std::get<1>(triple), std::get<2>(triple));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        ASSERT_EQ(expected, store.predicatesAndObjects(subject)) << "subject " << subject;
+    }
+    for (unsigned long predicate = 0; predicate < predicates; predicate++) {
+        for (unsigned long i = 0; i < vertices.size(); i += 7) {
+            unsigned long vertex = vertices[i];
+            std::vector<unsigned long> objects, subjects, between;
+            for (auto &triple : reference) {
+                if (std::get<1>(triple) != predicate) {
+                    continue;
+                }
+                if (std::get<0>(triple) == vertex) {
+                    objects.push_back(std::get<2>(triple));
+                }
+                if (std::get<2>(triple) == vertex) {
+                    subjects.push_back(std::get<0>(triple));
+                }
+            }
+            std::sort(subjects.begin(), subjects.end());
+            ASSERT_EQ(objects, store.objects(vertex, predicate));
+            ASSERT_EQ(subjects, store.subjects(predicate, vertex));
+        }
+    }
+    for (auto &triple : reference) {
+        std::vector<unsigned long> expected;
+        for (unsigned long predicate = 0; predicate < predicates; predicate++) {
+            if (reference.count(TripleKey(std::get<0>(triple), predicate, std::get<2>(triple)))) {
+                expected.push_back(predicate);
+            }
+        }
+        ASSERT_EQ(expected, store.predicates(std::get<0>(triple), std::get<2>(triple)));
+        ASSERT_TRUE(store.containsTriple(std::get<0>(triple), std::get<1>(triple), std::get<2>(triple)));
+    }
+}
+
+TEST(K2TripleStoreTest, PatternsMatchReference) {
+    const unsigned long vertices = 400, predicates = 30;
+    std::mt19937_64 random(5);
+    std::vector<Triple> triples;
+    std::set<TripleKey> reference;
+    for (unsigned long i = 0; i < 6000; i++) {
+        // a few predicates are used much more often than the others
+        unsigned long predicate = random() % 3 == 0 ? random() % predicates : random() % 4;
+        Triple triple{random() % vertices, predicate, random() % vertices};
+        triples.push_back(triple);
+        reference.emplace(triple.subject, triple.predicate, triple.object);
+    }
+    std::vector<unsigned long> all;
+    for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+        all.push_back(vertex);
+    }
+
+    for (int mode = 0; mode < 3; mode++) {
+        // bulk-loaded with and without the subject index, and built triple by triple
+        K2TripleStore *store;
+        if (mode < 2) {
+            store = K2TripleStore::fromTriples(vertices, triples, mode == 0);
+        } else {
+            store = new K2TripleStore(true, true);
+            for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+                ASSERT_EQ(vertex, store->insertVertex());
+            }
+            for (auto &triple : triples) {
+                store->addTriple(triple.subject, triple.predicate, triple.object);
+            }
+        }
+        ASSERT_EQ(predicates, store->predicateTrees());
+        expectPatternsMatch(*store, reference, all, predicates);
+        delete store;
+    }
+
+    // removing triples and deleting a vertex keep the patterns and the subject index exact
+    K2TripleStore *store = K2TripleStore::fromTriples(vertices, triples);
+    std::set<TripleKey> remaining = reference;
+    unsigned long i = 0;
+    for (auto it = reference.begin(); it != reference.end(); it++, i++) {
+        if (i % 3 == 0) {
+            store->removeTriple(std::get<0>(*it), std::get<1>(*it), std::get<2>(*it));
+            remaining.erase(*it);
+        }
+    }
+    store->deleteVertex(17);
+    for (auto it = remaining.begin(); it != remaining.end();) {
+        it = std::get<0>(*it) == 17 || std::get<2>(*it) == 17 ? remaining.erase(it) : std::next(it);
+    }
+    all.erase(all.begin() + 17);
+    expectPatternsMatch(*store, remaining, all, predicates);
+    // the deleted vertex is reused, without any of its old triples
+    ASSERT_EQ(17, store->insertVertex());
+    ASSERT_TRUE(store->predicatesAndObjects(17).empty());
+    ASSERT_TRUE(store->subjects(0, 17).empty());
+    delete store;
+}
+
+TEST(K2TripleStoreTest, SharedVertexSpace) {
+    K2TripleStore store;
+    try {
+        store.addTriple(0, 0, 0);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    // the trees grow together while vertices are added
+    for (unsigned long vertex = 0; vertex < 100; vertex++) {
+        ASSERT_EQ(vertex, store.insertVertex());
+        store.addTriple(vertex, vertex % 5, 0);
+        store.addTriple(0, 7, vertex);
+    }
+    ASSERT_EQ(6, store.predicateTrees());
+    ASSERT_EQ(100, store.vertexBound());
+    ASSERT_EQ(20, store.subjects(3, 0).size());
+    ASSERT_EQ(100, store.objects(0, 7).size());
+    ASSERT_TRUE(store.objects(0, 6).empty());
+    ASSERT_TRUE(store.objects(0, 1000).empty());
+    ASSERT_EQ((std::vector<unsigned long>{0, 7}), store.predicates(0, 0));
+
+    store.deleteVertex(50);
+    try {
+        store.objects(50, 7);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    ASSERT_EQ(99, store.objects(0, 7).size());
+    ASSERT_EQ(50, store.insertVertex());
+    ASSERT_EQ(100, store.insertVertex());
+    store.addTriple(100, 6, 50);
+    ASSERT_EQ((std::vector<unsigned long>{100}), store.subjects(6, 50));
+    ASSERT_EQ((std::vector<std::pair<unsigned long, unsigned long>>{{6, 50}}), store.predicatesAndObjects(100));
+}
+
+#endif // K2_TRIPLE_STORE_TEST
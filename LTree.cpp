@@ -2,6 +2,7 @@
 // Created by anneke on 18/12/18.
 //
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include "LTree.h"
@@ -49,7 +50,7 @@ LInternalNode::Entry::Entry(LTree *P) :
         P(P) {}
 
 void LInternalNode::Entry::remove() {
-    delete P;
+    LTree::release(P);
 }
 
 LRecord LTree::findChild(unsigned long n) {
@@ -60,6 +61,7 @@ LRecord LTree::findChild(unsigned long n) {
     for (i = 0; i < node->size; i++) {
         auto &entry = node->entries[i];
         if (bitsBefore + entry.b > n) {
+            HOT_PATH_COUNT(findChildSteps, i + 1);
             return {bitsBefore, i};
         }
         bitsBefore += entry.b;
@@ -67,6 +69,7 @@ LRecord LTree::findChild(unsigned long n) {
     // If the required bit is one after the last bit in this tree,
     // return the last child anyway
     // This is necessary for appending bits
+    HOT_PATH_COUNT(findChildSteps, i);
     if (i == node->size && bitsBefore == n) {
         auto &entry = node->entries[i - 1];
         return {bitsBefore - entry.b, i - 1};
@@ -78,6 +81,7 @@ LRecord LTree::findChild(unsigned long n) {
 
 LInternalNode::Entry LTree::findLeaf(unsigned long n, vector<LNesbo> *path) {
     if (path == nullptr) {
+        HOT_PATH_COUNT(rootDescents, 1);
         auto *current = this;
         unsigned long bitsBefore = 0;
         while (!current->isLeaf) {
@@ -97,6 +101,7 @@ LInternalNode::Entry LTree::findLeaf2(unsigned long n, vector<LNesbo> &path) {
     if (path.empty()) {
         // If the path is empty, we have to do a regular findLeaf and store the
         // results in the path vector
+        HOT_PATH_COUNT(rootDescents, 1);
         current = this;
         bitsBefore = 0;
     } else {
@@ -111,6 +116,7 @@ LInternalNode::Entry LTree::findLeaf2(unsigned long n, vector<LNesbo> &path) {
             // regular search from there
             path.pop_back();
             if (k == 0) {
+                HOT_PATH_COUNT(rootDescents, 1);
                 current = nesbo.node;
                 break;
             }
@@ -121,6 +127,7 @@ LInternalNode::Entry LTree::findLeaf2(unsigned long n, vector<LNesbo> &path) {
         // If we didn't exit early, then set the start of the search path to the
         // last entry of path that still exists
         if (current == nullptr) {
+            HOT_PATH_COUNT(pathHits, 1);
             current = nesbo.node->node.internalNode->entries[nesbo.index].P;
             bitsBefore = nesbo.bitsBefore;
         }
@@ -143,6 +150,18 @@ bool LTree::access(unsigned long n, vector<LNesbo> *path) {
     return entry.P->node.leafNode->bv[n - entry.b];
 }
 
+u64 LTree::accessBits(unsigned long n, unsigned long count, vector<LNesbo> *path) {
+    auto entry = findLeaf(n, path);
+    auto &bv = entry.P->node.leafNode->bv;
+    unsigned long available = bv.size() - (n - entry.b);
+    if (count <= available) {
+        return bv.get(n - entry.b, count);
+    }
+    // the bits continue in the next leaf
+    u64 first = bv.get(n - entry.b, available);
+    return first | accessBits(n + available, count - available, path) << available;
+}
+
 bool LTree::setBit(unsigned long n, bool b, vector<LNesbo> *path) {
     // Find the leaf node that contains this bit
     auto entry = findLeaf(n, path);
@@ -166,8 +185,20 @@ void LTree::updateCounters(long dBits) {
     }
 }
 
+// Repairs the path to a leaf after inserting (dBits > 0) or deleting bits in it, of which the given number
+// of levels were rebalanced, from the leaf up. The subtrees of the other nodes on the path start at the same
+// bit, and only change in size, while the entries of the rebalanced nodes are dropped, so that the next search
+// continues from the lowest node that still has the same children
+static void repairPath(vector<LNesbo> &path, long dBits, unsigned long levels) {
+    unsigned long kept = levels < path.size() ? path.size() - levels : 0;
+    path.erase(path.begin() + kept, path.end());
+    for (auto &nesbo : path) {
+        nesbo.size += dBits;
+    }
+}
+
 LTree *LTree::insertBits(long unsigned index, long unsigned count,
-                         vector<LNesbo> *path) {
+                         vector<LNesbo> *path, NodeCounts *nodes) {
     auto entry = findLeaf(index, path);
     auto leaf = entry.P;
     auto &bv = leaf->node.leafNode->bv;
@@ -175,11 +206,20 @@ LTree *LTree::insertBits(long unsigned index, long unsigned count,
     leaf->updateCounters(count);
 
     // Split this node up into two if it exceeds the size limit
-    return leaf->checkSizeUpper();
+    unsigned long levels = 0;
+    NodeCounts changed;
+    auto newRoot = leaf->checkSizeUpper(levels, changed);
+    if (nodes != nullptr) {
+        *nodes += changed;
+    }
+    if (path != nullptr) {
+        repairPath(*path, count, levels);
+    }
+    return newRoot;
 }
 
 LTree *LTree::deleteBits(long unsigned index, long unsigned count,
-                         vector<LNesbo> *path) {
+                         vector<LNesbo> *path, NodeCounts *nodes) {
     auto entry = findLeaf(index, path);
     auto leaf = entry.P;
     auto &bv = leaf->node.leafNode->bv;
@@ -187,15 +227,24 @@ LTree *LTree::deleteBits(long unsigned index, long unsigned count,
     long unsigned end = start + count;
     bv.erase(start, end);
     leaf->updateCounters(-count);
-    return leaf->checkSizeLower();
+    unsigned long levels = 0;
+    NodeCounts changed;
+    auto newRoot = leaf->checkSizeLower(levels, changed);
+    if (nodes != nullptr) {
+        *nodes += changed;
+    }
+    if (path != nullptr) {
+        repairPath(*path, -(long) count, levels);
+    }
+    return newRoot;
 }
 
-LTree *LTree::insertBlock(long unsigned index, vector<LNesbo> *path) {
-    return this->insertBits(index, BLOCK_SIZE, path);
+LTree *LTree::insertBlock(long unsigned index, vector<LNesbo> *path, NodeCounts *nodes) {
+    return this->insertBits(index, BLOCK_SIZE, path, nodes);
 }
 
-LTree *LTree::deleteBlock(long unsigned index, vector<LNesbo> *path) {
-    return this->deleteBits(index, BLOCK_SIZE, path);
+LTree *LTree::deleteBlock(long unsigned index, vector<LNesbo> *path, NodeCounts *nodes) {
+    return this->deleteBits(index, BLOCK_SIZE, path, nodes);
 }
 
 unsigned long LTree::depth() {
@@ -294,30 +343,34 @@ void LInternalNode::remove(unsigned long idx) {
     entries[size] = Entry();
 }
 
-LTree *LTree::checkSizeUpper() {
+LTree *LTree::checkSizeUpper(unsigned long &levels, NodeCounts &nodes) {
     if (isLeaf && size() > leafSizeMax) {
+        levels++;
         if (!trySpillLeaf()) {
-            return splitLeaf();
+            return splitLeaf(levels, nodes);
         }
     } else if (!isLeaf && size() > nodeSizeMax) {
+        levels++;
         if (!trySpillInternal()) {
-            return splitInternal();
+            return splitInternal(levels, nodes);
         }
     }
     return nullptr;
 }
 
-LTree *LTree::checkSizeLower() {
+LTree *LTree::checkSizeLower(unsigned long &levels, NodeCounts &nodes) {
     bool isRoot = (parent == nullptr);
     if (isRoot && (size() >= 2 || isLeaf)) {
         return nullptr;
     } else if (isLeaf && size() < leafSizeMin) {
+        levels++;
         if (!tryStealLeaf()) {
-            return mergeLeaf();
+            return mergeLeaf(levels, nodes);
         }
     } else if (!isLeaf && size() < nodeSizeMin) {
+        levels++;
         if (!tryStealInternal()) {
-            return mergeInternal();
+            return mergeInternal(levels, nodes);
         }
     }
     return nullptr;
@@ -332,9 +385,11 @@ bool LTree::trySpillInternal() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() < nodeSizeMax) {
         this->moveLeftInternal();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() < nodeSizeMax) {
         this->moveRightInternal();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else {
         return false;
@@ -350,9 +405,11 @@ bool LTree::tryStealInternal() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() > nodeSizeMin) {
         entries[idx - 1].P->moveRightInternal();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() > nodeSizeMin) {
         entries[idx + 1].P->moveLeftInternal();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else {
         return false;
@@ -368,9 +425,11 @@ bool LTree::trySpillLeaf() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() < leafSizeMax) {
         this->moveLeftLeaf();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() < leafSizeMax) {
         this->moveRightLeaf();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else {
         return false;
@@ -386,9 +445,11 @@ bool LTree::tryStealLeaf() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() > leafSizeMin) {
         entries[idx - 1].P->moveRightLeaf();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() > leafSizeMin) {
         entries[idx + 1].P->moveLeftLeaf();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else {
         return false;
@@ -460,15 +521,17 @@ void LTree::moveRightLeaf() {
     parent->node.internalNode->entries[idx + 1].b += d_b;
 }
 
-LTree *LTree::splitInternal() {
+LTree *LTree::splitInternal(unsigned long &levels, NodeCounts &nodes) {
+    HOT_PATH_COUNT(internalSplits, 1);
     auto &entries = this->node.internalNode->entries;
     unsigned long n = this->size();
     unsigned long mid = n / 2;
     auto newNode = new LTree();
     newNode->parent = parent;
     newNode->isLeaf = false;
-    newNode->node.leafNode = nullptr;
+    delete newNode->node.leafNode;
     newNode->node.internalNode = new LInternalNode();
+    nodes.internalNodes++;
     unsigned long d_b = 0; // Count bits in right half
     for (unsigned long i = mid; i < n; i++) {
         auto entry = entries[i];
@@ -484,16 +547,18 @@ LTree *LTree::splitInternal() {
     node.internalNode->size = mid;
     if (parent == nullptr) {
         auto *newRoot = new LTree(this, newNode);
+        nodes.internalNodes++;
         return newRoot;
     } else {
         parent->node.internalNode->entries[indexInParent].b -= d_b;
         parent->node.internalNode->insert(indexInParent + 1,
                                           {d_b, newNode});
-        return parent->checkSizeUpper();
+        return parent->checkSizeUpper(levels, nodes);
     }
 }
 
-LTree *LTree::splitLeaf() {
+LTree *LTree::splitLeaf(unsigned long &levels, NodeCounts &nodes) {
+    HOT_PATH_COUNT(leafSplits, 1);
     unsigned long n = this->node.leafNode->bits();
     unsigned long mid = n / 2;
     mid -= mid % BLOCK_SIZE;
@@ -501,8 +566,10 @@ LTree *LTree::splitLeaf() {
     auto right = BitVector<>(left, mid, n);
     left.erase(mid, n);
     auto *newNode = new LTree(right);
+    nodes.leaves++;
     if (parent == nullptr) {
         auto *newRoot = new LTree(this, newNode);
+        nodes.internalNodes++;
         return newRoot;
     } else {
         unsigned long idx = indexInParent;
@@ -510,11 +577,11 @@ LTree *LTree::splitLeaf() {
         LInternalNode::Entry entry(newNode);
         parent->node.internalNode->insert(indexInParent + 1, entry);
         parent->node.internalNode->entries[idx].b -= entry.b;
-        return parent->checkSizeUpper();
+        return parent->checkSizeUpper(levels, nodes);
     }
 }
 
-LTree *LTree::mergeInternal() {
+LTree *LTree::mergeInternal(unsigned long &levels, NodeCounts &nodes) {
     // If we are the root and we are too small, then we have only one child
     if (parent == nullptr) {
         // Delete this, our only child should become the root
@@ -522,11 +589,14 @@ LTree *LTree::mergeInternal() {
         // Overwrite the pointer in the entry, so that it is not deleted
         node.internalNode->entries[0].P = nullptr;
         delete this;
+        nodes.internalNodes--;
         child->parent = nullptr;
         child->indexInParent = 0;
         return child;
     }
 
+    HOT_PATH_COUNT(internalMerges, 1);
+    LTree *parent = this->parent; // `this` may be deleted below
     unsigned long idx = indexInParent;
     LTree *left = nullptr, *right = nullptr;
     if (idx > 0) {
@@ -552,13 +622,17 @@ LTree *LTree::mergeInternal() {
     // Delete the right child, and update the b counter for left
     parent->node.internalNode->remove(idx + 1);
     parent->node.internalNode->entries[idx].b += d_b;
-    return parent->checkSizeLower();
+    delete right;
+    nodes.internalNodes--;
+    return parent->checkSizeLower(levels, nodes);
 }
 
-LTree *LTree::mergeLeaf() {
+LTree *LTree::mergeLeaf(unsigned long &levels, NodeCounts &nodes) {
     if (parent == nullptr) {
         return nullptr;
     }
+    HOT_PATH_COUNT(leafMerges, 1);
+    LTree *parent = this->parent; // `this` may be deleted below
     unsigned long idx = indexInParent;
     LTree *left = nullptr, *right = nullptr;
     if (idx > 0) {
@@ -577,7 +651,9 @@ LTree *LTree::mergeLeaf() {
     unsigned long d_b = parent->node.internalNode->entries[idx + 1].b;
     parent->node.internalNode->entries[idx].b += d_b;
     parent->node.internalNode->remove(idx + 1);
-    return parent->checkSizeLower();
+    delete right;
+    nodes.leaves--;
+    return parent->checkSizeLower(levels, nodes);
 }
 
 unsigned long LTree::memoryUsage() {
@@ -595,3 +671,133 @@ unsigned long LTree::memoryUsage() {
     }
     return result;
 }
+
+LTree *LTree::fromBlocks(const vector<u64> &blocks) {
+    unsigned long n = blocks.size();
+    if (n == 0) {
+        return new LTree();
+    }
+
+    // Distribute the blocks as evenly as possible over the smallest number of
+    // leaves, which guarantees that every leaf has at least leafSizeMin blocks
+    unsigned long leaves = (n + leafSizeMax - 1) / leafSizeMax;
+    vector<LTree *> level;
+    level.reserve(leaves);
+    unsigned long next = 0;
+    for (unsigned long i = 0; i < leaves; i++) {
+        unsigned long count = n / leaves + (i < n % leaves ? 1 : 0);
+        auto *leaf = new LTree(count * BLOCK_SIZE);
+        auto &bv = leaf->node.leafNode->bv;
+        for (unsigned long j = 0; j < count; j++, next++) {
+            u64 block = blocks[next];
+            while (block != 0) {
+                bv.set(j * BLOCK_SIZE + __builtin_ctzll(block), true);
+                block &= block - 1;
+            }
+        }
+        level.push_back(leaf);
+    }
+
+    // Then group the nodes of each level under new parents in the same way,
+    // until only the root is left
+    while (level.size() > 1) {
+        unsigned long children = level.size();
+        unsigned long parents = (children + nodeSizeMax - 1) / nodeSizeMax;
+        vector<LTree *> above;
+        above.reserve(parents);
+        next = 0;
+        for (unsigned long i = 0; i < parents; i++) {
+            unsigned long count = children / parents + (i < children % parents ? 1 : 0);
+            auto *parent = new LTree(level[next], level[next + 1]);
+            for (unsigned long j = 2; j < count; j++) {
+                level[next + j]->parent = parent;
+                parent->node.internalNode->append(LInternalNode::Entry(level[next + j]));
+            }
+            next += count;
+            above.push_back(parent);
+        }
+        level.swap(above);
+    }
+    return level[0];
+}
+
+void LTree::release(LTree *node) {
+    if (node != nullptr && node->references.fetch_sub(1) == 1) {
+        delete node;
+    }
+}
+
+LTree *LTree::copy() {
+    if (isLeaf) {
+        auto *result = new LTree(node.leafNode->bv);
+        result->parent = parent;
+        result->indexInParent = indexInParent;
+        return result;
+    }
+    auto *result = new LTree();
+    result->parent = parent;
+    result->indexInParent = indexInParent;
+    result->isLeaf = false;
+    delete result->node.leafNode;
+    result->node.internalNode = new LInternalNode();
+    result->node.internalNode->size = node.internalNode->size;
+    for (unsigned long i = 0; i < node.internalNode->size; i++) {
+        auto &entry = node.internalNode->entries[i];
+        entry.P->references++;
+        result->node.internalNode->entries[i] = entry;
+    }
+    return result;
+}
+
+bool LTree::unshareChild(unsigned long i) {
+    auto &entry = node.internalNode->entries[i];
+    LTree *child = entry.P;
+    bool shared = child->references > 1;
+    if (shared) {
+        entry.P = child->copy();
+        // the old child stays alive for the snapshots that refer to it
+        release(child);
+    }
+    entry.P->parent = this;
+    entry.P->indexInParent = i;
+    return shared;
+}
+
+LTree *LTree::unsharePath(LTree *root, unsigned long n, vector<LNesbo> *path) {
+    bool copied = false;
+    if (root->references > 1) {
+        LTree *old = root;
+        root = old->copy();
+        release(old);
+        copied = true;
+    }
+    root->parent = nullptr;
+    LTree *current = root;
+    unsigned long bitsBefore = 0;
+    while (!current->isLeaf) {
+        LRecord record = current->findChild(n - bitsBefore);
+        bitsBefore += record.b;
+        unsigned long first = record.i > 0 ? record.i - 1 : 0;
+        unsigned long last = std::min(record.i + 1, current->node.internalNode->size - 1);
+        for (unsigned long i = first; i <= last; i++) {
+            copied |= current->unshareChild(i);
+        }
+        current = current->node.internalNode->entries[record.i].P;
+    }
+    if (copied && path != nullptr) {
+        path->clear();
+    }
+    return root;
+}
+
+void LTree::restoreParents(LTree *root) {
+    if (root->isLeaf) {
+        return;
+    }
+    for (unsigned long i = 0; i < root->node.internalNode->size; i++) {
+        LTree *child = root->node.internalNode->entries[i].P;
+        child->parent = root;
+        child->indexInParent = i;
+        restoreParents(child);
+    }
+}
@@ -5,9 +5,11 @@
 #ifndef DK2TREE_LTREE_H
 #define DK2TREE_LTREE_H
 
+#include <atomic>
 #include "BitVector.h"
+#include "MemoryStats.h"
 #include <utility>
-#include "parameters.cpp"
+#include "parameters.h"
 
 /// LRecord type containing the number pf preceding bits, and the
 /// index of a child node in the parent's `entries` list
@@ -61,7 +63,7 @@ struct LInternalNode {
 
         /**
          * This function is called in the destructor of `LInternalNode`, to
-         * delete the child nodes. It is not part of the destructor of `Entry`,
+         * release the child nodes. It is not part of the destructor of `Entry`,
          * since that causes problems when the struct is used in methods such as
          * `findLeaf`
          */
@@ -152,6 +154,8 @@ struct LLeafNode {
     explicit LLeafNode(BitVector<> bv) :
             bv(bv) {}
 
+    LLeafNode(const LLeafNode &) = delete;
+
     /**
      * Get the total number of bits stored in this leaf node
      * @return the size in bits of this leaf
@@ -165,6 +169,9 @@ struct LTree {
     bool isLeaf;
     LTree *parent = nullptr;
     unsigned long indexInParent = 0;
+    /// The number of parents and trees that refer to this node, more than one
+    /// if the node is shared with a snapshot, see `unsharePath`
+    std::atomic<unsigned long> references{1};
 
     union Node {
         LInternalNode *internalNode;
@@ -275,6 +282,14 @@ struct LTree {
      */
     bool access(unsigned long, vector<LNesbo> *path = nullptr);
 
+    /**
+     * Performs the `access` operation on `count` consecutive bits at once
+     * @param n the index of the first bit, with n + count <= (number of bits in the tree)
+     * @param count the number of bits to read, with 0 < count <= 64
+     * @return a word in which bit i is the value of bit n + i of the tree
+     */
+    u64 accessBits(unsigned long n, unsigned long count, vector<LNesbo> *path = nullptr);
+
     /**
      * Sets the bit at position n to the value of b
      * @param n the index of the bit to set
@@ -302,20 +317,80 @@ struct LTree {
     /**
      * Inserts one block of k^2 bits at the specified position
      *
+     * @param nodes if not nullptr, the nodes that the rebalancing created are added to it, and the
+     *        ones it deleted subtracted
      * @return the new root if the tree's root changed, nullptr otherwise
      */
-    LTree *insertBlock(long unsigned, vector<LNesbo> *path = nullptr);
+    LTree *insertBlock(long unsigned, vector<LNesbo> *path = nullptr, NodeCounts *nodes = nullptr);
 
     /**
      * Deletes a block of k^2 bits at the specified position
      *
+     * @param nodes if not nullptr, the nodes that the rebalancing created are added to it, and the
+     *        ones it deleted subtracted
      * @return the new root if the tree's root changed, nullptr otherwise
      */
-    LTree *deleteBlock(long unsigned, vector<LNesbo> *path = nullptr);
+    LTree *deleteBlock(long unsigned, vector<LNesbo> *path = nullptr, NodeCounts *nodes = nullptr);
 
     unsigned long memoryUsage();
 
+    /**
+     * Builds a balanced tree whose leaves contain the given blocks of k^2 bits,
+     * filling the leaves and internal nodes evenly so that they all satisfy the
+     * size constraints of the B+tree
+     *
+     * @param blocks the blocks in order, where bit `i` of blocks[j] is the value
+     *        of bit j * k^2 + i of the resulting bitvector
+     * @return the root of the new tree
+     */
+    static LTree *fromBlocks(const vector<u64> &blocks);
+
+    /**
+     * Drops one reference to the given node, and deletes it (and the children
+     * it is the last reference to) when nothing refers to it anymore
+     */
+    static void release(LTree *node);
+
+    /**
+     * Prepares a tree whose nodes may be shared with snapshots for a change at
+     * position n. Every shared node on the path from the root to the leaf
+     * containing bit n is replaced by a copy, as is every shared sibling of a
+     * node on the path, since the rebalancing after inserting or deleting bits
+     * may change those. A copy of an internal node shares its children, so
+     * only the nodes on and next to this one path are copied.
+     *
+     * Snapshots only read their nodes top-down, so `parent` and
+     * `indexInParent` of a shared node belong to the tree that last walked
+     * through it, and are set for every node on and next to the path here.
+     *
+     * @param root the root of the tree
+     * @param n the position of the bit that is changed, inserted or deleted
+     * @param path the cached path, which is cleared if any node was copied
+     * @return the root, which is a copy if the old root was shared
+     */
+    static LTree *unsharePath(LTree *root, unsigned long n, vector<LNesbo> *path);
+
+    /**
+     * Points `parent` and `indexInParent` of every node below the root to the
+     * node that actually refers to it. A tree that shared nodes with snapshots
+     * may have nodes whose parent is a node of a snapshot, which has to be
+     * done once the snapshots are gone and the tree is changed without
+     * `unsharePath`
+     * @param root the root of a tree that does not share any nodes, or of a subtree of it
+     */
+    static void restoreParents(LTree *root);
+
 private:
+    /// Returns an unshared copy of this node, which shares the children of this node
+    LTree *copy();
+
+    /**
+     * Replaces the i-th child of this internal node by a copy if it is shared,
+     * and points its parent and index to this node
+     * @return true if the child was copied
+     */
+    bool unshareChild(unsigned long i);
+
     /**
      * Inserts the given number of bits (set to zero) at the given position in the tree
      *
@@ -326,13 +401,17 @@ private:
      * if this insert operation created a new root (e.g. when the height of the
      * tree increases)
      *
+     * The path, if given, leads to the leaf afterwards as far as the
+     * rebalancing left its nodes in place, so a search for a nearby position
+     * does not have to start at the root.
+     *
      * This method assumes that after the insertion, the size of the relevant
      * leaf vector is at most one block over the maximum, which can only be
      * guaranteed when only a single block is inserted. That is why this method
      * is private, and insertBlock is public.
      */
     LTree *
-    insertBits(long unsigned, long unsigned, vector<LNesbo> *path = nullptr);
+    insertBits(long unsigned, long unsigned, vector<LNesbo> *path = nullptr, NodeCounts *nodes = nullptr);
 
     /**
      * Deletes the given number of bits in the subtree, assuming they are all in the
@@ -351,17 +430,19 @@ private:
      * is private, and deleteBlock is public.
      */
     LTree *
-    deleteBits(long unsigned, long unsigned, vector<LNesbo> *path = nullptr);
+    deleteBits(long unsigned, long unsigned, vector<LNesbo> *path = nullptr, NodeCounts *nodes = nullptr);
 
     /**
      * Checks if this node satisfies the maximum size for an internal node
      * or leaf node. If not, tries to spill a node to a sibling, or if that
      * fails will split this node into two and recursively check the parent
      *
+     * @param levels incremented for every node that is rebalanced, this one and the ones above it
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr in most cases, but returns the new root if it has
      *         changed, e.g. if the height of the tree has increased
      */
-    LTree *checkSizeUpper();
+    LTree *checkSizeUpper(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Checks if this node satisfies the minimum size for an internal node
@@ -369,10 +450,12 @@ private:
      * fails will merge this node with one of the siblings, and recursively
      * check the parent
      *
+     * @param levels incremented for every node that is rebalanced, this one and the ones above it
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr in most cases, but returns the new root if it has
      *         changed, e.g. if the height of the tree has decreased
      */
-    LTree *checkSizeLower();
+    LTree *checkSizeLower(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Tries to move a child of an internal node to a sibling, and returns
@@ -396,19 +479,23 @@ private:
      * Splits this node into two nodes of minimum size, and recursively
      * checks the rest of the tree for meeting size requirements
      *
+     * @param levels incremented for every node that is rebalanced, above this one, which is counted by the caller
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr in most cases, but returns the new root if this operation
      *         causes the tree's height to increase, which changes the root
      */
-    LTree *splitInternal();
+    LTree *splitInternal(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Splits this node into two nodes of minimum size, and recursively
      * checks the rest of the tree for meeting size requirements
      *
+     * @param levels incremented for every node that is rebalanced, above this one, which is counted by the caller
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr in most cases, but returns the new root if this operation
      *         causes the tree's height to increase, which changes the root
      */
-    LTree *splitLeaf();
+    LTree *splitLeaf(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Tries to steal a node from one of this node's siblings, and returns true
@@ -432,19 +519,23 @@ private:
      * Merges this node with a sibling, and recursively checks the rest of the
      * tree for meeting size constraints
      *
+     * @param levels incremented for every node that is rebalanced, above this one, which is counted by the caller
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr usually, but returns the new root it it changed due to this
      *         operation, e.g. when the height of the tree changed
      */
-    LTree *mergeInternal();
+    LTree *mergeInternal(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Merges this node with a sibling, and recursively checks the rest of the
      * tree for meeting size constraints
      *
+     * @param levels incremented for every node that is rebalanced, above this one, which is counted by the caller
+     * @param nodes the change in the number of nodes, see `insertBlock`
      * @return nullptr usually, but returns the new root it it changed due to this
      *         operation, e.g. when the height of the tree changed
      */
-    LTree *mergeLeaf();
+    LTree *mergeLeaf(unsigned long &levels, NodeCounts &nodes);
 
     /**
      * Moves a single child (the leftmost child) of this node to the end of the
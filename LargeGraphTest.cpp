@@ -5,19 +5,12 @@
 #ifndef DK2TREE_LARGE_GRAPH_TEST
 #define DK2TREE_LARGE_GRAPH_TEST
 
+#include <algorithm>
 #include <chrono>
 #include <random>
 #include <functional>
 #include <thread>
-
-std::default_random_engine generator(
-        (unsigned long) std::chrono::steady_clock::now().time_since_epoch().count());
-std::uniform_int_distribution<unsigned long> distribution(0,
-                                                          0xFFFFFFFFFFFFFFFF);
-
-unsigned long randRange(unsigned long lo, unsigned long hi) {
-    return lo + distribution(generator) % (hi - lo);
-}
+#include "GraphGenerator.h"
 
 class Timer {
     std::chrono::steady_clock::time_point t0, t1;
@@ -34,39 +27,45 @@ public:
         std::chrono::duration<double, std::nano> d(t1 - t0);
         return d.count() / 1000000000.0;
     }
+
+    uint64_t nanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
 };
 
+/**
+ * Adds m edges of a generated graph of the given kind to a new graph of the
+ * given size, in a random order, and prints how long that takes. The graph is
+ * generated with m / size + 1 edges per vertex and then cut off at m
+ * edges. It can have fewer edges when it is a grid, which always has about four
+ * edges per vertex, or when the generator draws many duplicate edges
+ */
 template<typename G>
-G *largeTest(unsigned long size, unsigned long m, bool verbose = false) {
+G *largeTest(unsigned long size, unsigned long m, bool verbose = false, GraphKind kind = UNIFORM,
+             unsigned long seed = 1) {
+    auto edges = generateGraph(kind, size, m / size + 1, seed);
+    std::mt19937_64 random(seed);
+    std::shuffle(edges.begin(), edges.end(), random);
+    if (edges.size() > m) {
+        edges.resize(m);
+    }
     Timer t;
     t.start();
     G *g = G::withSize(size);
     t.stop();
     printf("Initialisation: %f seconds\n", t.read());
-    if (verbose) {
-        t.start();
-        for (unsigned long k = 1; k <= m; k++) {
-            if (k % 10000 == 0) {
-                printf("%lu / %lu\r", k, m);
-            }
-            unsigned long i = randRange(0, size);
-            unsigned long j = randRange(0, size);
-            g->addEdge(i, j);
-        }
-        t.stop();
-    } else {
-        t.start();
-        for (unsigned long k = 1; k <= m; k++) {
-            unsigned long i = randRange(0, size);
-            unsigned long j = randRange(0, size);
-            g->addEdge(i, j);
+    t.start();
+    for (unsigned long k = 1; k <= edges.size(); k++) {
+        if (verbose && k % 10000 == 0) {
+            printf("%lu / %lu\r", k, edges.size());
         }
-        t.stop();
+        g->addEdge(edges[k - 1].first, edges[k - 1].second);
     }
+    t.stop();
     printf("Adding edges: %f seconds\n", t.read());
     printf("Size in memory: %lu bytes\n", g->memoryUsage());
-    unsigned long i = randRange(0, size);
-    unsigned long j = randRange(0, size);
+    unsigned long i = random() % size;
+    unsigned long j = random() % size;
     printf("%i\n", g->reportEdge(i, j));
     return g;
 }
@@ -0,0 +1,160 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_LATENCY_HISTOGRAM_H
+#define DK2TREE_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// The number of bits of precision kept for every recorded value. Values below
+/// 2^(PRECISION_BITS + 1) are counted exactly, larger values are rounded to
+/// the nearest bucket, with a relative error of at most 2^-PRECISION_BITS
+static const unsigned int PRECISION_BITS = 7;
+
+/// The percentiles that are reported by `writeJson` and `writeCsv`
+static const double REPORTED_PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+
+/**
+ * A histogram of latencies in the style of HdrHistogram. Every value is
+ * stored in a bucket determined by its highest PRECISION_BITS + 1 bits, so
+ * recording a value is a few shifts and an increment, and the memory used is
+ * independent of the number of values recorded.
+ *
+ * Bucket `i` with `i < 2^(PRECISION_BITS + 1)` contains only the value `i`.
+ * Larger values `v` are shifted right by `shift = log2(v) - PRECISION_BITS`
+ * so that `v >> shift` has exactly PRECISION_BITS + 1 bits, and are stored in
+ * bucket `(shift << PRECISION_BITS) + (v >> shift)`.
+ */
+class LatencyHistogram {
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+    double sum = 0;
+
+    static unsigned long bucketOf(uint64_t value) {
+        if (value < (1ul << (PRECISION_BITS + 1))) {
+            return value;
+        }
+        unsigned int shift = 63 - __builtin_clzl(value) - PRECISION_BITS;
+        return ((unsigned long) shift << PRECISION_BITS) + (value >> shift);
+    }
+
+    // The highest value that is stored in the given bucket
+    static uint64_t highestValueOf(unsigned long bucket) {
+        if (bucket < (1ul << (PRECISION_BITS + 1))) {
+            return bucket;
+        }
+        unsigned int shift = (bucket >> PRECISION_BITS) - 1;
+        uint64_t mantissa = bucket - ((unsigned long) shift << PRECISION_BITS);
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(bucketOf(UINT64_MAX) + 1, 0) {}
+
+    /// Adds a single value (typically in nanoseconds) to the histogram
+    void record(uint64_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+        sum += value;
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    /// Adds all values of the other histogram to this one
+    void merge(const LatencyHistogram &other) {
+        for (unsigned long i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    void clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        sum = 0;
+        minimum = UINT64_MAX;
+        maximum = 0;
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    uint64_t min() const {
+        return total == 0 ? 0 : minimum;
+    }
+
+    uint64_t max() const {
+        return maximum;
+    }
+
+    double mean() const {
+        return total == 0 ? 0 : sum / total;
+    }
+
+    /**
+     * Returns the smallest value such that at least `percentile` percent of
+     * the recorded values are at most that value, rounded up to the highest
+     * value of its bucket (and never above the maximum)
+     *
+     * @param percentile a percentage in [0, 100]
+     */
+    uint64_t percentile(double percentile) const {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = (uint64_t) (percentile / 100.0 * total + 0.5);
+        rank = std::max((uint64_t) 1, std::min(rank, total));
+        uint64_t seen = 0;
+        for (unsigned long i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(highestValueOf(i), maximum);
+            }
+        }
+        return maximum;
+    }
+
+    /**
+     * Writes the summary of this histogram as a JSON object of the form
+     * {"name": ..., "count": ..., "mean": ..., "min": ..., "p50": ..., ..., "max": ...}
+     */
+    void writeJson(std::ostream &out, const std::string &name) const {
+        out << "{\"name\": \"" << name << "\", \"count\": " << count()
+            << ", \"mean\": " << mean() << ", \"min\": " << min();
+        for (double p : REPORTED_PERCENTILES) {
+            out << ", \"p" << p << "\": " << percentile(p);
+        }
+        out << ", \"max\": " << max() << "}";
+    }
+
+    /// Writes the header line matching the lines written by `writeCsv`
+    static void writeCsvHeader(std::ostream &out) {
+        out << "name,count,mean,min";
+        for (double p : REPORTED_PERCENTILES) {
+            out << ",p" << p;
+        }
+        out << ",max\n";
+    }
+
+    /// Writes the summary of this histogram as a single line of CSV
+    void writeCsv(std::ostream &out, const std::string &name) const {
+        out << name << "," << count() << "," << mean() << "," << min();
+        for (double p : REPORTED_PERCENTILES) {
+            out << "," << percentile(p);
+        }
+        out << "," << max() << "\n";
+    }
+};
+
+#endif // DK2TREE_LATENCY_HISTOGRAM_H
@@ -0,0 +1,75 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef LATENCY_HISTOGRAM_TEST
+#define LATENCY_HISTOGRAM_TEST
+
+#include <sstream>
+#include "LatencyHistogram.h"
+#include "gtest/gtest.h"
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 100; i++) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(100, histogram.count());
+    EXPECT_EQ(1, histogram.min());
+    EXPECT_EQ(100, histogram.max());
+    EXPECT_DOUBLE_EQ(50.5, histogram.mean());
+    EXPECT_EQ(50, histogram.percentile(50));
+    EXPECT_EQ(90, histogram.percentile(90));
+    EXPECT_EQ(99, histogram.percentile(99));
+    EXPECT_EQ(100, histogram.percentile(100));
+}
+
+TEST(LatencyHistogramTest, LargeValuesWithinPrecision) {
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    for (uint64_t i = 0; i < 10000; i++) {
+        values.push_back(1000 + i * i * 37);
+    }
+    for (auto value : values) {
+        histogram.record(value);
+    }
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        uint64_t exact = values[(uint64_t) (p / 100.0 * values.size() + 0.5) - 1];
+        uint64_t reported = histogram.percentile(p);
+        ASSERT_GE(reported, exact);
+        ASSERT_LE(reported - exact, exact >> PRECISION_BITS);
+    }
+    EXPECT_EQ(values.back(), histogram.max());
+    EXPECT_EQ(values.back(), histogram.percentile(100));
+
+    histogram.record(UINT64_MAX);
+    EXPECT_EQ(UINT64_MAX, histogram.max());
+}
+
+TEST(LatencyHistogramTest, MergeAndOutput) {
+    LatencyHistogram a, b;
+    a.record(10);
+    b.record(20);
+    b.record(30);
+    a.merge(b);
+    EXPECT_EQ(3, a.count());
+    EXPECT_EQ(10, a.min());
+    EXPECT_EQ(30, a.max());
+    EXPECT_EQ(20, a.percentile(50));
+
+    std::ostringstream json;
+    a.writeJson(json, "op");
+    EXPECT_EQ("{\"name\": \"op\", \"count\": 3, \"mean\": 20, \"min\": 10, "
+              "\"p50\": 20, \"p90\": 30, \"p99\": 30, \"p99.9\": 30, \"max\": 30}", json.str());
+
+    std::ostringstream csv;
+    LatencyHistogram::writeCsvHeader(csv);
+    a.writeCsv(csv, "op");
+    EXPECT_EQ("name,count,mean,min,p50,p90,p99,p99.9,max\nop,3,20,10,20,30,30,30,30\n", csv.str());
+
+    a.clear();
+    EXPECT_EQ(0, a.count());
+    EXPECT_EQ(0, a.percentile(99));
+}
+
+#endif // LATENCY_HISTOGRAM_TEST
@@ -0,0 +1,80 @@
+//
+// Created by agent on 19-10-26.
+//
+
+
+#include <algorithm>
+#include "LeafVocabulary.h"
+
+unsigned long LeafVocabulary::acquire(u64 pattern) {
+    auto found = codes.find(pattern);
+    if (found != codes.end()) {
+        references[found->second]++;
+        return found->second;
+    }
+    unsigned long code;
+    if (!freeCodes.empty()) {
+        code = freeCodes.top();
+        freeCodes.pop();
+        patterns[code] = pattern;
+    } else {
+        code = patterns.size();
+        patterns.push_back(pattern);
+        references.push_back(0);
+    }
+    references[code] = 1;
+    codes[pattern] = code;
+    return code;
+}
+
+void LeafVocabulary::release(unsigned long code) {
+    if (--references[code] == 0) {
+        codes.erase(patterns[code]);
+        freeCodes.push(code);
+    }
+}
+
+vector<unsigned long> LeafVocabulary::assignByFrequency(const vector<u64> &leaves) {
+    std::unordered_map<u64, unsigned long> frequencies;
+    for (u64 leaf : leaves) {
+        frequencies[leaf]++;
+    }
+    vector<std::pair<unsigned long, u64>> byFrequency;
+    byFrequency.reserve(frequencies.size());
+    for (auto &entry : frequencies) {
+        byFrequency.emplace_back(entry.second, entry.first);
+    }
+    // Most frequent first, ties are broken by pattern so the result is deterministic
+    std::sort(byFrequency.begin(), byFrequency.end(),
+              [](const std::pair<unsigned long, u64> &a, const std::pair<unsigned long, u64> &b) {
+                  return a.first != b.first ? a.first > b.first : a.second < b.second;
+              });
+
+    patterns.clear();
+    references.clear();
+    codes.clear();
+    freeCodes = decltype(freeCodes)();
+    for (auto &entry : byFrequency) {
+        codes[entry.second] = patterns.size();
+        patterns.push_back(entry.second);
+        references.push_back(entry.first);
+    }
+    vector<unsigned long> result;
+    result.reserve(leaves.size());
+    for (u64 leaf : leaves) {
+        result.push_back(codes[leaf]);
+    }
+    return result;
+}
+
+unsigned long LeafVocabulary::memoryUsage() const {
+    // Every element of the hash map is a separately allocated node holding the
+    // pair and a next pointer, on top of one pointer per bucket
+    unsigned long mapNode = sizeof(void *) + sizeof(std::pair<const u64, unsigned long>);
+    return sizeof(LeafVocabulary)
+           + patterns.capacity() * sizeof(u64)
+           + references.capacity() * sizeof(unsigned long)
+           + codes.bucket_count() * sizeof(void *)
+           + codes.size() * allocationSize(mapNode)
+           + freeCodes.size() * sizeof(unsigned long);
+}
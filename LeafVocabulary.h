@@ -0,0 +1,72 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_LEAF_VOCABULARY_H
+#define DK2TREE_LEAF_VOCABULARY_H
+
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "BitVector.h"
+#include "MemoryStats.h"
+
+/**
+ * A dynamic vocabulary of leaf submatrices. Every distinct submatrix (a
+ * VOCABULARY_K by VOCABULARY_K pattern of bits) that occurs in the leaves of
+ * a DKTree gets a code, and the leaves only store these codes. Every code has
+ * a reference count, and when a pattern is no longer used its code is freed
+ * and handed out again to the next new pattern, smallest codes first.
+ *
+ * Codes are stored with a variable length, so the most frequent patterns should
+ * get the smallest codes. `assignByFrequency` does this when a tree is built
+ * from scratch, patterns added later get the smallest free code, so the code
+ * assignment may become less optimal over time.
+ */
+class LeafVocabulary {
+    vector<u64> patterns; // the pattern of every code
+    vector<unsigned long> references; // the number of leaves using every code, 0 for free codes
+    std::unordered_map<u64, unsigned long> codes; // the code of every pattern in use
+    std::priority_queue<unsigned long, vector<unsigned long>, std::greater<unsigned long>> freeCodes;
+
+public:
+    /**
+     * Returns the code for the given pattern, and increases its reference count.
+     * If the pattern is not in the vocabulary yet, it gets the smallest free code
+     */
+    unsigned long acquire(u64 pattern);
+
+    /**
+     * Decreases the reference count of the given code, and frees the code if it
+     * is no longer used
+     */
+    void release(unsigned long code);
+
+    /// Returns the pattern with the given code
+    u64 pattern(unsigned long code) const {
+        return patterns[code];
+    }
+
+    /// Returns the number of distinct patterns in use
+    unsigned long size() const {
+        return codes.size();
+    }
+
+    /**
+     * Replaces the contents of this vocabulary by the given leaf patterns, where
+     * the most frequent pattern gets code 0, the next one code 1, and so on
+     *
+     * @param leaves the pattern of every leaf
+     * @return the code of every leaf
+     */
+    vector<unsigned long> assignByFrequency(const vector<u64> &leaves);
+
+    /**
+     * Returns an estimate of the memory used by the vocabulary in bytes, in
+     * constant time
+     */
+    unsigned long memoryUsage() const;
+};
+
+#endif // DK2TREE_LEAF_VOCABULARY_H
@@ -0,0 +1,133 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_LEVEL_TABLE_H
+#define DK2TREE_LEVEL_TABLE_H
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "parameters.h"
+
+/**
+ * The arity of every level of a DKTree: the `topLevels` highest levels use
+ * `top`, the leaf level uses `leaf`, and all levels in between use `middle`.
+ * A large k near the root makes the tree shorter, which reduces the number of
+ * rank operations per query, while a small k in the lower levels keeps the
+ * blocks of sparse submatrices small
+ */
+struct Arities {
+    unsigned long top = k;
+    unsigned long topLevels = 0;
+    unsigned long middle = k;
+    unsigned long leaf = k;
+};
+
+/**
+ * The precomputed arity, block size and partition size of every level of a
+ * DKTree. Levels are numbered by their iteration, starting with 1 for the root
+ * block, and the last level is the leaf level. Every arity is a power of two
+ * of at most MAX_LEVEL_K, whose block is a whole number of BLOCK_SIZE blocks of
+ * the TTree and LTree, so that a block of any level fits in a 64-bit word
+ */
+class LevelTable {
+    std::vector<unsigned long> arities; // the k of every level
+    std::vector<unsigned long> partitionSizes; // the number of rows/columns covered by one bit of every level
+
+public:
+    /**
+     * Creates a table with the given arity for every level, from the root down
+     * @throws illegal argument exception if there are less than two levels, or
+     *         if an arity is not supported
+     */
+    explicit LevelTable(const std::vector<unsigned long> &levelArities) :
+            arities(levelArities), partitionSizes(levelArities.size()) {
+        if (arities.size() < 2) {
+            throw std::invalid_argument("LevelTable: the root block and the leaves need at least two levels\n");
+        }
+        for (unsigned long arity : arities) {
+            checkArity(arity);
+        }
+        update();
+    }
+
+    /**
+     * Creates the table with the fewest levels of the given arities whose matrix
+     * has room for `size` rows/columns. There is always at least one level above
+     * the leaf level, since the root block is stored in the TTree
+     */
+    static LevelTable forSize(unsigned long size, const Arities &shape) {
+        std::vector<unsigned long> levelArities{shape.leaf};
+        unsigned long n = shape.leaf, top = 1;
+        for (unsigned long i = 0; i < shape.topLevels; i++) {
+            top *= shape.top;
+        }
+        while (n * top < size || (shape.topLevels == 0 && levelArities.size() < 2)) {
+            levelArities.insert(levelArities.begin(), shape.middle);
+            n *= shape.middle;
+        }
+        levelArities.insert(levelArities.begin(), shape.topLevels, shape.top);
+        return LevelTable(levelArities);
+    }
+
+    /// Returns the number of levels, the leaf level is level `height()`
+    unsigned long height() const {
+        return arities.size();
+    }
+
+    /// Returns the number of rows/columns of the whole matrix
+    unsigned long matrixSize() const {
+        return partitionSizes[0] * arities[0];
+    }
+
+    /// Returns the k of the given level
+    unsigned long arity(unsigned long iteration) const {
+        return arities[iteration - 1];
+    }
+
+    /// Returns the number of bits in one block of the given level, k^2
+    unsigned long blockSize(unsigned long iteration) const {
+        return arities[iteration - 1] * arities[iteration - 1];
+    }
+
+    /// Returns the number of rows/columns covered by one bit of a block of the given level
+    unsigned long partitionSize(unsigned long iteration) const {
+        return partitionSizes[iteration - 1];
+    }
+
+    /// Returns log2 of the block size of the given level, the number of bits needed for an offset
+    unsigned long offsetBits(unsigned long iteration) const {
+        return 2 * __builtin_ctzl(arities[iteration - 1]);
+    }
+
+    /**
+     * Adds a new root level with the same arity as the current root, which
+     * multiplies the matrix size by that arity
+     */
+    void grow() {
+        arities.insert(arities.begin(), arities[0]);
+        partitionSizes.insert(partitionSizes.begin(), 0);
+        update();
+    }
+
+private:
+    static void checkArity(unsigned long arity) {
+        if (arity < 2 || arity > MAX_LEVEL_K || (arity & (arity - 1)) != 0 || (arity * arity) % BLOCK_SIZE != 0) {
+            std::stringstream error;
+            error << "LevelTable: unsupported arity " << arity << ", the arity of a level must be a power of 2"
+                  << " of at most " << MAX_LEVEL_K << " whose blocks consist of whole blocks of " << BLOCK_SIZE << " bits\n";
+            throw std::invalid_argument(error.str());
+        }
+    }
+
+    void update() {
+        unsigned long size = 1;
+        for (unsigned long i = arities.size(); i-- > 0;) {
+            partitionSizes[i] = size;
+            size *= arities[i];
+        }
+    }
+};
+
+#endif // DK2TREE_LEVEL_TABLE_H
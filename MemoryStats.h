@@ -0,0 +1,73 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_MEMORY_STATS_H
+#define DK2TREE_MEMORY_STATS_H
+
+#include <ostream>
+
+/**
+ * The number of leaf and internal nodes of one kind of tree. A DKTree counts
+ * its nodes once when it is built, after which `TTree::insertBlock` and
+ * `TTree::deleteBlock` report the nodes that their splits and merges create
+ * and delete, so that it never has to walk its trees to know their size
+ */
+struct NodeCounts {
+    long leaves = 0;
+    long internalNodes = 0;
+
+    NodeCounts &operator+=(const NodeCounts &other) {
+        leaves += other.leaves;
+        internalNodes += other.internalNodes;
+        return *this;
+    }
+};
+
+/**
+ * Returns an estimate of the number of bytes malloc really uses for an
+ * allocation of the given size. This follows glibc on 64-bit systems, which
+ * adds an 8-byte header to every chunk, and rounds chunks up to a multiple of
+ * 16 bytes with a minimum of 32 bytes
+ */
+inline unsigned long allocationSize(unsigned long size) {
+    unsigned long chunk = (size + 8 + 15) & ~15ul;
+    return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * A breakdown of the memory used by a DKTree, in bytes
+ */
+struct MemoryStats {
+    unsigned long payload = 0; // the bits stored in the leaves, rounded up to whole bytes
+    unsigned long leafSlack = 0; // unused space in the fixed size arrays of the leaves
+    unsigned long counters = 0; // the bit counts and per-word one counts of the leaves
+    unsigned long internalNodes = 0; // the internal nodes, with their (b, o, P) entries
+    unsigned long nodeHeaders = 0; // the tree nodes themselves (type, parent, index and node pointer)
+    unsigned long allocatorSlack = 0; // the estimated overhead of malloc for all nodes
+    unsigned long paths = 0; // the cached paths to the last accessed leaves
+    unsigned long freeList = 0; // the list of deleted rows/columns
+    unsigned long vocabulary = 0; // the leaf vocabulary and leaf codes in vocabulary mode
+    unsigned long base = 0; // the DKTree object itself
+
+    unsigned long total() const {
+        return payload + leafSlack + counters + internalNodes + nodeHeaders + allocatorSlack
+               + paths + freeList + vocabulary + base;
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &out, const MemoryStats &stats) {
+    return out << "total " << stats.total()
+               << " (payload " << stats.payload
+               << ", leaf slack " << stats.leafSlack
+               << ", counters " << stats.counters
+               << ", internal nodes " << stats.internalNodes
+               << ", node headers " << stats.nodeHeaders
+               << ", allocator slack " << stats.allocatorSlack
+               << ", paths " << stats.paths
+               << ", free list " << stats.freeList
+               << ", vocabulary " << stats.vocabulary
+               << ", base " << stats.base << ")";
+}
+
+#endif // DK2TREE_MEMORY_STATS_H
@@ -0,0 +1,51 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <cmath>
+#include <stdexcept>
+
+#include "PageRank.h"
+
+using namespace std;
+
+PageRankResult pageRank(DKTree &tree, double damping, double tolerance, unsigned long maxIterations,
+                        unsigned int threads) {
+    if (!(damping >= 0 && damping <= 1)) {
+        throw invalid_argument("pageRank: the damping factor must be between 0 and 1\n");
+    }
+    PageRankResult result;
+    const unsigned long n = tree.vertexBound();
+    if (n == 0) {
+        result.converged = true;
+        return result;
+    }
+    // the out-degree of every vertex is the sum of its row, A times a vector of ones
+    const vector<double> degrees = tree.multiply(vector<double>(n, 1.0), threads);
+
+    result.ranks.assign(n, 1.0 / n);
+    vector<double> contributions(n);
+    while (result.iterations < maxIterations && !result.converged) {
+        // every vertex divides its rank over its successors, the rank of vertices without any is spread evenly
+        double dangling = 0;
+        for (unsigned long v = 0; v < n; v++) {
+            if (degrees[v] == 0) {
+                dangling += result.ranks[v];
+                contributions[v] = 0;
+            } else {
+                contributions[v] = result.ranks[v] / degrees[v];
+            }
+        }
+        vector<double> ranks = tree.multiplyTransposed(contributions, threads);
+        const double base = (1 - damping) / n + damping * dangling / n;
+        double change = 0;
+        for (unsigned long v = 0; v < n; v++) {
+            ranks[v] = base + damping * ranks[v];
+            change += fabs(ranks[v] - result.ranks[v]);
+        }
+        result.ranks.swap(ranks);
+        result.iterations++;
+        result.converged = change < tolerance;
+    }
+    return result;
+}
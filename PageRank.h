@@ -0,0 +1,38 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_PAGE_RANK_H
+#define DK2TREE_PAGE_RANK_H
+
+#include <vector>
+#include "DKTree.h"
+
+/**
+ * The result of `pageRank`: the rank of every vertex, which sum to 1, and the
+ * number of iterations that were needed to converge
+ */
+struct PageRankResult {
+    std::vector<double> ranks;
+    unsigned long iterations = 0;
+    bool converged = false;
+};
+
+/**
+ * Computes the PageRank of every vertex directly on the k²-tree, without
+ * decompressing it. Every iteration is one `DKTree::multiplyTransposed`, so
+ * apart from the tree only a few vectors with one value per vertex are used.
+ * The rank of vertices without successors is spread evenly over all vertices.
+ * Deleted vertices below `vertexBound()` are treated as vertices without edges.
+ *
+ * @param tree the graph
+ * @param damping the probability of following an edge instead of jumping to a random vertex
+ * @param tolerance the iterations stop when the ranks change less than this in total (L1 norm)
+ * @param maxIterations the maximum number of iterations
+ * @param threads the maximum number of threads to use, 0 means one per hardware thread
+ * @throws illegal argument exception if damping is not in [0, 1]
+ */
+PageRankResult pageRank(DKTree &tree, double damping = 0.85, double tolerance = 1e-9,
+                        unsigned long maxIterations = 100, unsigned int threads = 0);
+
+#endif // DK2TREE_PAGE_RANK_H
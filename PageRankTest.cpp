@@ -0,0 +1,116 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef PAGE_RANK_TEST
+#define PAGE_RANK_TEST
+
+#include <cmath>
+#include <random>
+#include "GraphGenerator.h"
+#include "PageRank.h"
+#include "gtest/gtest.h"
+
+TEST(PageRankTest, MultiplyMatchesReference) {
+    Arities hybrid;
+    hybrid.top = 8;
+    hybrid.topLevels = 1;
+    hybrid.middle = 4;
+    std::mt19937_64 random(3);
+    // 2001 is not a multiple of the leaf arity, so the last leaf blocks stick out of the vectors
+    for (unsigned long vertices : {2000ul, 2001ul}) {
+        std::vector<double> x(vertices);
+        for (auto &value : x) {
+            value = (double) (random() % 1000) / 7;
+        }
+        for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+            auto edges = generateGraph((GraphKind) kind, vertices, 4, 11);
+            std::vector<double> expected(vertices, 0.0), expectedTransposed(vertices, 0.0);
+            for (auto &edge : edges) {
+                expected[edge.first] += x[edge.second];
+                expectedTransposed[edge.second] += x[edge.first];
+            }
+            for (int mode = 0; mode < 3; mode++) {
+                DKTree *tree = DKTree::fromEdges(vertices, edges, mode == 2, mode == 1 ? hybrid : Arities());
+                for (unsigned int threads : {1u, 3u, 8u}) {
+                    auto y = tree->multiply(x, threads);
+                    auto yTransposed = tree->multiplyTransposed(x, threads);
+                    ASSERT_EQ(vertices, y.size());
+                    for (unsigned long v = 0; v < vertices; v++) {
+                        ASSERT_NEAR(expected[v], y[v], 1e-6) << "vertex " << v << ", " << threads << " threads";
+                        ASSERT_NEAR(expectedTransposed[v], yTransposed[v], 1e-6) << "vertex " << v;
+                    }
+                }
+                delete tree;
+            }
+        }
+    }
+}
+
+TEST(PageRankTest, MultiplyOddVertexCount) {
+    DKTree *tree = DKTree::fromEdges(5, {{4, 0}, {0, 4}});
+    ASSERT_EQ(5, tree->vertexBound());
+    for (unsigned int threads : {1u, 4u}) {
+        std::vector<double> x{1, 2, 3, 4, 5};
+        EXPECT_EQ(std::vector<double>({5, 0, 0, 0, 1}), tree->multiply(x, threads));
+        EXPECT_EQ(std::vector<double>({5, 0, 0, 0, 1}), tree->multiplyTransposed(x, threads));
+    }
+    delete tree;
+}
+
+TEST(PageRankTest, PageRankMatchesReference) {
+    for (unsigned long vertices : {3000ul, 3001ul}) {
+        auto edges = rmatEdges(vertices, 20000, 4);
+        const double damping = 0.85;
+
+        // the textbook power iteration on an edge list
+        std::vector<double> degrees(vertices, 0), expected(vertices, 1.0 / vertices);
+        for (auto &edge : edges) {
+            degrees[edge.first]++;
+        }
+        for (int iteration = 0; iteration < 200; iteration++) {
+            double dangling = 0;
+            std::vector<double> next(vertices, 0);
+            for (unsigned long v = 0; v < vertices; v++) {
+                if (degrees[v] == 0) {
+                    dangling += expected[v];
+                }
+            }
+            for (auto &edge : edges) {
+                next[edge.second] += expected[edge.first] / degrees[edge.first];
+            }
+            for (unsigned long v = 0; v < vertices; v++) {
+                next[v] = (1 - damping) / vertices + damping * (next[v] + dangling / vertices);
+            }
+            expected.swap(next);
+        }
+
+        DKTree *tree = DKTree::fromEdges(vertices, edges);
+        for (unsigned int threads : {1u, 4u}) {
+            auto result = pageRank(*tree, damping, 1e-12, 200, threads);
+            ASSERT_TRUE(result.converged);
+            ASSERT_GT(result.iterations, 1);
+            double sum = 0;
+            for (unsigned long v = 0; v < vertices; v++) {
+                ASSERT_NEAR(expected[v], result.ranks[v], 1e-10) << "vertex " << v << ", " << threads << " threads";
+                sum += result.ranks[v];
+            }
+            ASSERT_NEAR(1.0, sum, 1e-9);
+        }
+
+        auto limited = pageRank(*tree, damping, 0, 3, 2);
+        ASSERT_EQ(3, limited.iterations);
+        ASSERT_FALSE(limited.converged);
+        try {
+            pageRank(*tree, 1.5);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) {}
+        try {
+            tree->multiply(std::vector<double>(vertices - 1, 1.0));
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) {}
+        delete tree;
+    }
+}
+
+#endif // PAGE_RANK_TEST
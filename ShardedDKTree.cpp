@@ -0,0 +1,215 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "ShardedDKTree.h"
+
+using namespace std;
+
+void ShardedDKTree::layOut(unsigned long aSize, unsigned long shardsPerSide) {
+    if (shardsPerSide == 0) {
+        throw invalid_argument("ShardedDKTree: invalid argument, there has to be at least one shard per side\n");
+    }
+    size = aSize;
+    shardWidth = max(1ul, (size + shardsPerSide - 1) / shardsPerSide);
+    bands = (size + shardWidth - 1) / shardWidth;
+}
+
+ShardedDKTree::ShardedDKTree(unsigned long size, unsigned long shardsPerSide, bool vocabulary, Arities shape) {
+    layOut(size, shardsPerSide);
+    for (unsigned long row = 0; row < bands; row++) {
+        for (unsigned long column = 0; column < bands; column++) {
+            shards.emplace_back(new Shard(DKTree::withSize(max(bandSize(row), bandSize(column)), vocabulary,
+                                                           shape)));
+        }
+    }
+}
+
+ShardedDKTree *ShardedDKTree::fromEdges(unsigned long size, const vector<pair<unsigned long, unsigned long>> &edges,
+                                        unsigned long shardsPerSide, unsigned int threads, bool vocabulary,
+                                        Arities shape) {
+    auto *result = new ShardedDKTree();
+    try {
+        result->layOut(size, shardsPerSide);
+        auto shardEdges = result->edgesByShard(edges, "fromEdges");
+        for (unsigned long shard = 0; shard < shardEdges.size(); shard++) {
+            result->shards.emplace_back(new Shard(nullptr));
+        }
+        result->forEachShard(threads, [&](unsigned long shard) {
+            unsigned long width = max(result->bandSize(shard / result->bands),
+                                      result->bandSize(shard % result->bands));
+            result->shards[shard]->tree = DKTree::fromEdges(width, shardEdges[shard], vocabulary, shape);
+            vector<pair<unsigned long, unsigned long>>().swap(shardEdges[shard]);
+        });
+    } catch (...) {
+        delete result;
+        throw;
+    }
+    return result;
+}
+
+void ShardedDKTree::checkVertex(unsigned long vertex, const char *functionName) const {
+    if (vertex >= size) {
+        stringstream error;
+        error << functionName << ": invalid argument " << vertex << ", the tree has " << size << " vertices\n";
+        throw invalid_argument(error.str());
+    }
+}
+
+vector<vector<pair<unsigned long, unsigned long>>>
+ShardedDKTree::edgesByShard(const vector<pair<unsigned long, unsigned long>> &edges, const char *functionName) const {
+    vector<vector<pair<unsigned long, unsigned long>>> result(bands * bands);
+    for (auto &edge : edges) {
+        checkVertex(edge.first, functionName);
+        checkVertex(edge.second, functionName);
+        result[edge.first / shardWidth * bands + edge.second / shardWidth].emplace_back(
+                edge.first % shardWidth, edge.second % shardWidth);
+    }
+    return result;
+}
+
+void ShardedDKTree::forEachShard(unsigned int threads, const function<void(unsigned long)> &task) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = (unsigned int) min((unsigned long) threads, (unsigned long) shards.size());
+    if (threads <= 1) {
+        for (unsigned long shard = 0; shard < shards.size(); shard++) {
+            task(shard);
+        }
+        return;
+    }
+    vector<exception_ptr> errors(threads);
+    vector<thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            try {
+                for (unsigned long shard = t; shard < shards.size(); shard += threads) {
+                    task(shard);
+                }
+            } catch (...) {
+                errors[t] = current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+}
+
+void ShardedDKTree::addEdge(unsigned long row, unsigned long column) {
+    checkVertex(row, "addEdge");
+    checkVertex(column, "addEdge");
+    Shard &shard = shardOf(row, column);
+    lock_guard<mutex> lock(shard.mutex);
+    shard.tree->addEdge(row % shardWidth, column % shardWidth);
+}
+
+void ShardedDKTree::removeEdge(unsigned long row, unsigned long column) {
+    checkVertex(row, "removeEdge");
+    checkVertex(column, "removeEdge");
+    Shard &shard = shardOf(row, column);
+    lock_guard<mutex> lock(shard.mutex);
+    shard.tree->removeEdge(row % shardWidth, column % shardWidth);
+}
+
+void ShardedDKTree::addEdges(const vector<pair<unsigned long, unsigned long>> &edges, unsigned int threads) {
+    auto shardEdges = edgesByShard(edges, "addEdges");
+    forEachShard(threads, [&](unsigned long shard) {
+        if (shardEdges[shard].empty()) {
+            return;
+        }
+        lock_guard<mutex> lock(shards[shard]->mutex);
+        for (auto &edge : shardEdges[shard]) {
+            shards[shard]->tree->addEdge(edge.first, edge.second);
+        }
+    });
+}
+
+bool ShardedDKTree::reportEdge(unsigned long row, unsigned long column) {
+    checkVertex(row, "reportEdge");
+    checkVertex(column, "reportEdge");
+    Shard &shard = shardOf(row, column);
+    lock_guard<mutex> lock(shard.mutex);
+    return shard.tree->reportEdge(row % shardWidth, column % shardWidth);
+}
+
+vector<unsigned long> ShardedDKTree::reportSuccessors(unsigned long a) {
+    checkVertex(a, "reportSuccessors");
+    vector<unsigned long> result;
+    for (unsigned long band = 0; band < bands; band++) {
+        Shard &shard = *shards[a / shardWidth * bands + band];
+        lock_guard<mutex> lock(shard.mutex);
+        for (unsigned long column : shard.tree->reportSuccessors(a % shardWidth)) {
+            result.push_back(band * shardWidth + column);
+        }
+    }
+    return result;
+}
+
+vector<unsigned long> ShardedDKTree::reportPredecessors(unsigned long b) {
+    checkVertex(b, "reportPredecessors");
+    vector<unsigned long> result;
+    for (unsigned long band = 0; band < bands; band++) {
+        Shard &shard = *shards[band * bands + b / shardWidth];
+        lock_guard<mutex> lock(shard.mutex);
+        for (unsigned long row : shard.tree->reportPredecessors(b % shardWidth)) {
+            result.push_back(band * shardWidth + row);
+        }
+    }
+    return result;
+}
+
+vector<pair<unsigned long, unsigned long>>
+ShardedDKTree::reportAllEdges(const vector<unsigned long> &A, const vector<unsigned long> &B) {
+    if (A.empty() || B.empty()) {
+        throw invalid_argument("reportAllEdges: invalid argument, A and B must not be empty\n");
+    }
+    // the local ids of the rows and columns in every band
+    vector<vector<unsigned long>> rows(bands), columns(bands);
+    for (unsigned long a : A) {
+        checkVertex(a, "reportAllEdges");
+        rows[a / shardWidth].push_back(a % shardWidth);
+    }
+    for (unsigned long b : B) {
+        checkVertex(b, "reportAllEdges");
+        columns[b / shardWidth].push_back(b % shardWidth);
+    }
+    vector<pair<unsigned long, unsigned long>> result;
+    for (unsigned long row = 0; row < bands; row++) {
+        if (rows[row].empty()) {
+            continue;
+        }
+        for (unsigned long column = 0; column < bands; column++) {
+            if (columns[column].empty()) {
+                continue;
+            }
+            Shard &shard = *shards[row * bands + column];
+            lock_guard<mutex> lock(shard.mutex);
+            for (auto &edge : shard.tree->reportAllEdges(rows[row], columns[column])) {
+                result.emplace_back(row * shardWidth + edge.first, column * shardWidth + edge.second);
+            }
+        }
+    }
+    return result;
+}
+
+unsigned long ShardedDKTree::memoryUsage() const {
+    unsigned long bytes = sizeof(ShardedDKTree) + shards.capacity() * sizeof(unique_ptr<Shard>);
+    for (auto &shard : shards) {
+        lock_guard<mutex> lock(shard->mutex);
+        bytes += sizeof(Shard) + shard->tree->memoryUsage();
+    }
+    return bytes;
+}
@@ -0,0 +1,167 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_SHARDED_DKTREE_H
+#define DK2TREE_SHARDED_DKTREE_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "DKTree.h"
+
+/**
+ * An adjacency matrix split into a grid of independent DKTrees, so that
+ * changes to different parts of the matrix can be made by different threads
+ * at the same time. The rows and the columns are both cut into bands of
+ * `shardWidth` vertices, and the shard (i, j) holds the edges from the i-th
+ * row band to the j-th column band, with local vertex ids. With a power of k
+ * as the number of shards per side and a size that is a power of k, the shards
+ * are exactly the submatrices of a level of a single k2-tree.
+ *
+ * Every shard is guarded by its own mutex, so any number of threads may call
+ * the methods at the same time, and only calls that touch the same shard wait
+ * for each other. `addEdges` and `fromEdges` spread a batch over several
+ * threads, which take the shards in turn. A query only locks the shards that
+ * its rows and columns fall in: a successor query asks one row of shards, a
+ * predecessor query one column of shards, and `reportAllEdges` the shards that
+ * contain both a row of A and a column of B.
+ *
+ * The set of vertices is fixed when the tree is created.
+ */
+class ShardedDKTree {
+    struct Shard {
+        DKTree *tree;
+        std::mutex mutex;
+
+        explicit Shard(DKTree *tree) : tree(tree) {}
+
+        ~Shard() {
+            delete tree;
+        }
+    };
+
+    unsigned long size = 0; // the vertices are 0 ... size - 1
+    unsigned long shardWidth = 1; // the number of vertices of every band, except maybe the last one
+    unsigned long bands = 0; // the number of row bands, and of column bands
+    std::vector<std::unique_ptr<Shard>> shards; // the shards of the grid, row by row
+
+    ShardedDKTree() = default;
+
+    /// Cuts the vertices into the bands, without creating the shards
+    void layOut(unsigned long aSize, unsigned long shardsPerSide);
+
+    /// @return the number of vertices in the given band
+    unsigned long bandSize(unsigned long band) const {
+        return std::min(shardWidth, size - band * shardWidth);
+    }
+
+    /// @return the shard containing the edge (row, column)
+    Shard &shardOf(unsigned long row, unsigned long column) const {
+        return *shards[row / shardWidth * bands + column / shardWidth];
+    }
+
+    /// @throws illegal argument exception if the vertex is not in the tree
+    void checkVertex(unsigned long vertex, const char *functionName) const;
+
+    /// Sorts the edges into the shards, with local vertex ids, after checking them
+    std::vector<std::vector<std::pair<unsigned long, unsigned long>>>
+    edgesByShard(const std::vector<std::pair<unsigned long, unsigned long>> &edges, const char *functionName) const;
+
+    /**
+     * Runs the task for every shard, on the given number of threads (0 for one per core), which take the
+     * shards in turn. The first exception of a task is thrown after all threads have finished
+     */
+    void forEachShard(unsigned int threads, const std::function<void(unsigned long)> &task);
+
+public:
+    /**
+     * Creates an empty sharded tree
+     * @param size the number of vertices, which get the ids 0 ... size - 1
+     * @param shardsPerSide the number of bands the rows and the columns are cut into, so there are
+     *        shardsPerSide^2 shards, or fewer if there are fewer vertices than bands
+     * @param vocabulary whether the shards use vocabulary mode, see `DKTree::withSize`
+     * @param shape the arities of the levels of the shards
+     * @throws illegal argument exception if shardsPerSide is 0
+     */
+    explicit ShardedDKTree(unsigned long size, unsigned long shardsPerSide = 2, bool vocabulary = false,
+                           Arities shape = Arities());
+
+    ShardedDKTree(const ShardedDKTree &) = delete;
+
+    ShardedDKTree &operator=(const ShardedDKTree &) = delete;
+
+    /**
+     * Builds a sharded tree containing exactly the given edges, bulk-loading the shards with
+     * `DKTree::fromEdges` in parallel
+     * @param threads the number of threads that build the shards, 0 for one per core
+     * @throws illegal argument exception if an edge has an endpoint >= size, or if shardsPerSide is 0
+     */
+    static ShardedDKTree *fromEdges(unsigned long size, const std::vector<std::pair<unsigned long, unsigned long>> &edges,
+                                    unsigned long shardsPerSide = 2, unsigned int threads = 0,
+                                    bool vocabulary = false, Arities shape = Arities());
+
+    /**
+     * Adds the edge (row, column)
+     * @throws illegal argument exception if row or column is not in the tree
+     */
+    void addEdge(unsigned long row, unsigned long column);
+
+    /**
+     * Removes the edge (row, column), if it is in the tree
+     * @throws illegal argument exception if row or column is not in the tree
+     */
+    void removeEdge(unsigned long row, unsigned long column);
+
+    /**
+     * Adds a batch of edges, sorted into the shards first, after which the threads add the edges of one shard
+     * each at a time. Nothing is added if an edge is invalid
+     * @param threads the number of threads that add the edges, 0 for one per core
+     * @throws illegal argument exception if an endpoint of an edge is not in the tree
+     */
+    void addEdges(const std::vector<std::pair<unsigned long, unsigned long>> &edges, unsigned int threads = 0);
+
+    /**
+     * @return whether the edge (row, column) is in the tree
+     * @throws illegal argument exception if row or column is not in the tree
+     */
+    bool reportEdge(unsigned long row, unsigned long column);
+
+    /**
+     * @return the successors of a in increasing order, asking only the shards of the row band of a
+     * @throws illegal argument exception if a is not in the tree
+     */
+    std::vector<unsigned long> reportSuccessors(unsigned long a);
+
+    /**
+     * @return the predecessors of b in increasing order, asking only the shards of the column band of b
+     * @throws illegal argument exception if b is not in the tree
+     */
+    std::vector<unsigned long> reportPredecessors(unsigned long b);
+
+    /**
+     * Reports all edges from an element of A to an element of B, asking only the shards that contain both a
+     * row of A and a column of B
+     * @return the edges, in the order of the shards
+     * @throws illegal argument exception if A or B is empty, or contains a vertex that is not in the tree
+     */
+    std::vector<std::pair<unsigned long, unsigned long>>
+    reportAllEdges(const std::vector<unsigned long> &A, const std::vector<unsigned long> &B);
+
+    /// @return the number of vertices
+    unsigned long vertices() const {
+        return size;
+    }
+
+    /// @return the number of shards
+    unsigned long shardCount() const {
+        return shards.size();
+    }
+
+    /// @return the memory used by the shards and the grid in bytes
+    unsigned long memoryUsage() const;
+};
+
+#endif // DK2TREE_SHARDED_DKTREE_H
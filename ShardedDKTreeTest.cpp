@@ -0,0 +1,124 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef SHARDED_DKTREE_TEST
+#define SHARDED_DKTREE_TEST
+
+#include <random>
+#include <set>
+#include <thread>
+#include "ShardedDKTree.h"
+#include "gtest/gtest.h"
+
+typedef std::vector<std::pair<unsigned long, unsigned long>> ShardedEdges;
+
+// checks every query of the tree against the set of edges it should contain
+static void expectShardedEdges(ShardedDKTree &tree, const std::set<std::pair<unsigned long, unsigned long>> &edges,
+                               std::mt19937_64 &random) {
+    const unsigned long size = tree.vertices();
+    for (unsigned long vertex = 0; vertex < size; vertex++) {
+        std::vector<unsigned long> successors, predecessors;
+        for (unsigned long other = 0; other < size; other++) {
+            if (edges.count({vertex, other}) == 1) {
+                successors.push_back(other);
+            }
+            if (edges.count({other, vertex}) == 1) {
+                predecessors.push_back(other);
+            }
+        }
+        ASSERT_EQ(successors, tree.reportSuccessors(vertex)) << vertex;
+        ASSERT_EQ(predecessors, tree.reportPredecessors(vertex)) << vertex;
+    }
+    for (unsigned long i = 0; i < 2000; i++) {
+        unsigned long row = random() % size, column = random() % size;
+        ASSERT_EQ(edges.count({row, column}) == 1, tree.reportEdge(row, column)) << row << " " << column;
+    }
+    // a few rows and columns, which only touch some of the shards
+    std::vector<unsigned long> rows{0, 5, 77}, columns{size - 1, 6};
+    ShardedEdges expected;
+    for (auto &edge : edges) {
+        if (std::count(rows.begin(), rows.end(), edge.first) == 1 &&
+            std::count(columns.begin(), columns.end(), edge.second) == 1) {
+            expected.push_back(edge);
+        }
+    }
+    auto reported = tree.reportAllEdges(rows, columns);
+    std::sort(reported.begin(), reported.end());
+    ASSERT_EQ(expected, reported);
+}
+
+TEST(ShardedDKTreeTest, QueriesMatchReference) {
+    // 3 bands of 67, 67 and 66 vertices, which are not aligned to the submatrices of the shards
+    const unsigned long size = 200;
+    std::mt19937_64 random(11);
+    ShardedDKTree tree(size, 3);
+    ASSERT_EQ(9, tree.shardCount());
+    std::set<std::pair<unsigned long, unsigned long>> edges;
+    for (unsigned long i = 0; i < 1500; i++) {
+        unsigned long row = random() % size, column = random() % size;
+        tree.addEdge(row, column);
+        edges.emplace(row, column);
+    }
+    ShardedEdges batch;
+    for (unsigned long i = 0; i < 3000; i++) {
+        batch.emplace_back(random() % size, random() % size);
+    }
+    tree.addEdges(batch, 4);
+    edges.insert(batch.begin(), batch.end());
+    for (unsigned long i = 0; i < 1000; i++) {
+        auto edge = batch[random() % batch.size()];
+        tree.removeEdge(edge.first, edge.second);
+        edges.erase(edge);
+    }
+    expectShardedEdges(tree, edges, random);
+
+    ShardedDKTree *loaded = ShardedDKTree::fromEdges(size, ShardedEdges(edges.begin(), edges.end()), 3, 2);
+    expectShardedEdges(*loaded, edges, random);
+    delete loaded;
+
+    try {
+        tree.addEdges({{1, 2}, {size, 3}});
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    // nothing of a batch with an invalid edge is added
+    ASSERT_EQ(edges.count({1, 2}) == 1, tree.reportEdge(1, 2));
+    try {
+        tree.reportSuccessors(size);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        ShardedDKTree none(size, 0);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+TEST(ShardedDKTreeTest, ConcurrentWriters) {
+    const unsigned long size = 256, perThread = 2000;
+    ShardedDKTree tree(size, 4);
+    std::vector<ShardedEdges> added(4);
+    std::vector<std::thread> writers;
+    for (unsigned long t = 0; t < 4; t++) {
+        writers.emplace_back([&, t]() {
+            std::mt19937_64 random(t);
+            for (unsigned long i = 0; i < perThread; i++) {
+                unsigned long row = random() % size, column = random() % size;
+                tree.addEdge(row, column);
+                added[t].emplace_back(row, column);
+                // readers of other shards do not wait for the writers
+                tree.reportEdge(random() % size, random() % size);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    std::set<std::pair<unsigned long, unsigned long>> edges;
+    for (auto &edgesOfThread : added) {
+        edges.insert(edgesOfThread.begin(), edgesOfThread.end());
+    }
+    std::mt19937_64 random(5);
+    expectShardedEdges(tree, edges, random);
+}
+
+#endif // SHARDED_DKTREE_TEST
@@ -2,6 +2,7 @@
 // Created by anneke on 18/12/18.
 //
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include "TTree.h"
@@ -50,7 +51,7 @@ InternalNode::Entry::Entry(TTree *P) :
         P(P) {}
 
 void InternalNode::Entry::remove() {
-    delete P;
+    TTree::release(P);
 }
 
 Record TTree::findChild(unsigned long n) {
@@ -62,6 +63,7 @@ Record TTree::findChild(unsigned long n) {
     for (i = 0; i < node->size; i++) {
         auto &entry = node->entries[i];
         if (bitsBefore + entry.b > n) {
+            HOT_PATH_COUNT(findChildSteps, i + 1);
             return {bitsBefore, onesBefore, i};
         }
         bitsBefore += entry.b;
@@ -70,6 +72,7 @@ Record TTree::findChild(unsigned long n) {
     // If the required bit is one after the last bit in this tree,
     // return the last child anyway
     // This is necessary for appending bits
+    HOT_PATH_COUNT(findChildSteps, i);
     if (i == node->size && bitsBefore == n) {
         auto &entry = node->entries[i - 1];
         return {bitsBefore - entry.b, onesBefore - entry.o, i - 1};
@@ -81,6 +84,7 @@ Record TTree::findChild(unsigned long n) {
 
 InternalNode::Entry TTree::findLeaf(unsigned long n, vector<Nesbo> *path) {
     if (path == nullptr) {
+        HOT_PATH_COUNT(rootDescents, 1);
         auto *current = this;
         unsigned long bitsBefore = 0;
         unsigned long onesBefore = 0;
@@ -102,6 +106,7 @@ InternalNode::Entry TTree::findLeaf2(unsigned long n, vector<Nesbo> &path) {
     if (path.empty()) {
         // If the path is empty, we have to do a regular findLeaf and store the
         // results in the path vector
+        HOT_PATH_COUNT(rootDescents, 1);
         current = this;
         bitsBefore = 0;
         onesBefore = 0;
@@ -117,6 +122,7 @@ InternalNode::Entry TTree::findLeaf2(unsigned long n, vector<Nesbo> &path) {
             // regular search from there
             path.pop_back();
             if (k == 0) {
+                HOT_PATH_COUNT(rootDescents, 1);
                 current = nesbo.node;
                 break;
             }
@@ -127,6 +133,7 @@ InternalNode::Entry TTree::findLeaf2(unsigned long n, vector<Nesbo> &path) {
         // If we didn't exit early, then set the start of the search path to the
         // last entry of path that still exists
         if (current == nullptr) {
+            HOT_PATH_COUNT(pathHits, 1);
             current = nesbo.node->node.internalNode->entries[nesbo.index].P;
             bitsBefore = nesbo.bitsBefore;
             onesBefore = nesbo.onesBefore;
@@ -157,6 +164,18 @@ bool TTree::access(unsigned long n, vector<Nesbo> *path) {
     return entry.P->node.leafNode->bv[n - entry.b];
 }
 
+u64 TTree::accessBits(unsigned long n, unsigned long count, vector<Nesbo> *path) {
+    auto entry = findLeaf(n, path);
+    auto &bv = entry.P->node.leafNode->bv;
+    unsigned long available = bv.size() - (n - entry.b);
+    if (count <= available) {
+        return bv.get(n - entry.b, count);
+    }
+    // the bits continue in the next leaf
+    u64 first = bv.get(n - entry.b, available);
+    return first | accessBits(n + available, count - available, path) << available;
+}
+
 bool TTree::setBit(unsigned long n, bool b, vector<Nesbo> *path) {
     // Find the leaf node that contains this bit
     auto entry = findLeaf(n, path);
@@ -195,8 +214,20 @@ void TTree::updateCounters(long dBits, long dOnes) {
     }
 }
 
+// Repairs the path to a leaf after inserting (dBits > 0) or deleting bits in it, of which the given number
+// of levels were rebalanced, from the leaf up. The subtrees of the other nodes on the path start at the same
+// bit, and only change in size, while the entries of the rebalanced nodes are dropped, so that the next search
+// continues from the lowest node that still has the same children
+static void repairPath(vector<Nesbo> &path, long dBits, unsigned long levels) {
+    unsigned long kept = levels < path.size() ? path.size() - levels : 0;
+    path.erase(path.begin() + kept, path.end());
+    for (auto &nesbo : path) {
+        nesbo.size += dBits;
+    }
+}
+
 TTree *TTree::insertBits(long unsigned index, long unsigned count,
-                         vector<Nesbo> *path) {
+                         vector<Nesbo> *path, NodeCounts *nodes) {
     auto entry = findLeaf(index, path);
     auto leaf = entry.P;
     auto &bv = leaf->node.leafNode->bv;
@@ -204,11 +235,20 @@ TTree *TTree::insertBits(long unsigned index, long unsigned count,
     leaf->updateCounters(count, 0);
 
     // Split this node up into two if it exceeds the size limit
-    return leaf->checkSizeUpper();
+    unsigned long levels = 0;
+    NodeCounts changed;
+    auto newRoot = leaf->checkSizeUpper(levels, changed);
+    if (nodes != nullptr) {
+        *nodes += changed;
+    }
+    if (path != nullptr) {
+        repairPath(*path, count, levels);
+    }
+    return newRoot;
 }
 
 TTree *TTree::deleteBits(long unsigned index, long unsigned count,
-                         vector<Nesbo> *path) {
+                         vector<Nesbo> *path, NodeCounts *nodes) {
     auto entry = findLeaf(index, path);
     auto leaf = entry.P;
     auto &bv = leaf->node.leafNode->bv;
@@ -217,15 +257,24 @@ TTree *TTree::deleteBits(long unsigned index, long unsigned count,
     long unsigned deletedOnes = bv.rangeRank1(start, end);
     bv.erase(start, end);
     leaf->updateCounters(-count, -deletedOnes);
-    return leaf->checkSizeLower();
+    unsigned long levels = 0;
+    NodeCounts changed;
+    auto newRoot = leaf->checkSizeLower(levels, changed);
+    if (nodes != nullptr) {
+        *nodes += changed;
+    }
+    if (path != nullptr) {
+        repairPath(*path, -(long) count, levels);
+    }
+    return newRoot;
 }
 
-TTree *TTree::insertBlock(long unsigned index, vector<Nesbo> *path) {
-    return this->insertBits(index, BLOCK_SIZE, path);
+TTree *TTree::insertBlock(long unsigned index, vector<Nesbo> *path, NodeCounts *nodes) {
+    return this->insertBits(index, BLOCK_SIZE, path, nodes);
 }
 
-TTree *TTree::deleteBlock(long unsigned index, vector<Nesbo> *path) {
-    return this->deleteBits(index, BLOCK_SIZE, path);
+TTree *TTree::deleteBlock(long unsigned index, vector<Nesbo> *path, NodeCounts *nodes) {
+    return this->deleteBits(index, BLOCK_SIZE, path, nodes);
 }
 
 unsigned long TTree::depth() {
@@ -345,30 +394,34 @@ void InternalNode::remove(unsigned long idx) {
     entries[size] = Entry();
 }
 
-TTree *TTree::checkSizeUpper() {
+TTree *TTree::checkSizeUpper(unsigned long &levels, NodeCounts &nodes) {
     if (isLeaf && size() > leafSizeMax) {
+        levels++;
         if (!trySpillLeaf()) {
-            return splitLeaf();
+            return splitLeaf(levels, nodes);
         }
     } else if (!isLeaf && size() > nodeSizeMax) {
+        levels++;
         if (!trySpillInternal()) {
-            return splitInternal();
+            return splitInternal(levels, nodes);
         }
     }
     return nullptr;
 }
 
-TTree *TTree::checkSizeLower() {
+TTree *TTree::checkSizeLower(unsigned long &levels, NodeCounts &nodes) {
     bool isRoot = (parent == nullptr);
     if (isRoot && (size() >= 2 || isLeaf)) {
         return nullptr;
     } else if (isLeaf && size() < leafSizeMin) {
+        levels++;
         if (!tryStealLeaf()) {
-            return mergeLeaf();
+            return mergeLeaf(levels, nodes);
         }
     } else if (!isLeaf && size() < nodeSizeMin) {
+        levels++;
         if (!tryStealInternal()) {
-            return mergeInternal();
+            return mergeInternal(levels, nodes);
         }
     }
     return nullptr;
@@ -383,9 +436,11 @@ bool TTree::trySpillInternal() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() < nodeSizeMax) {
         this->moveLeftInternal();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() < nodeSizeMax) {
         this->moveRightInternal();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else {
         return false;
@@ -401,9 +456,11 @@ bool TTree::tryStealInternal() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() > nodeSizeMin) {
         entries[idx - 1].P->moveRightInternal();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() > nodeSizeMin) {
         entries[idx + 1].P->moveLeftInternal();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else {
         return false;
@@ -419,9 +476,11 @@ bool TTree::trySpillLeaf() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() < leafSizeMax) {
         this->moveLeftLeaf();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() < leafSizeMax) {
         this->moveRightLeaf();
+        HOT_PATH_COUNT(spills, 1);
         return true;
     } else {
         return false;
@@ -437,9 +496,11 @@ bool TTree::tryStealLeaf() {
     auto &entries = parent->node.internalNode->entries;
     if (idx > 0 && entries[idx - 1].P->size() > leafSizeMin) {
         entries[idx - 1].P->moveRightLeaf();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else if (idx + 1 < n && entries[idx + 1].P->size() > leafSizeMin) {
         entries[idx + 1].P->moveLeftLeaf();
+        HOT_PATH_COUNT(steals, 1);
         return true;
     } else {
         return false;
@@ -527,15 +588,17 @@ void TTree::moveRightLeaf() {
     parent->node.internalNode->entries[idx + 1].o += d_o;
 }
 
-TTree *TTree::splitInternal() {
+TTree *TTree::splitInternal(unsigned long &levels, NodeCounts &nodes) {
+    HOT_PATH_COUNT(internalSplits, 1);
     auto &entries = this->node.internalNode->entries;
     unsigned long n = this->size();
     unsigned long mid = n / 2;
     auto newNode = new TTree();
     newNode->parent = parent;
     newNode->isLeaf = false;
-    newNode->node.leafNode = nullptr;
+    delete newNode->node.leafNode;
     newNode->node.internalNode = new InternalNode();
+    nodes.internalNodes++;
     unsigned long d_b = 0, d_o = 0; // Count bits/ones in right half
     for (unsigned long i = mid; i < n; i++) {
         auto entry = entries[i];
@@ -552,17 +615,19 @@ TTree *TTree::splitInternal() {
     node.internalNode->size = mid;
     if (parent == nullptr) {
         auto *newRoot = new TTree(this, newNode);
+        nodes.internalNodes++;
         return newRoot;
     } else {
         parent->node.internalNode->entries[indexInParent].b -= d_b;
         parent->node.internalNode->entries[indexInParent].o -= d_o;
         parent->node.internalNode->insert(indexInParent + 1,
                                           {d_b, d_o, newNode});
-        return parent->checkSizeUpper();
+        return parent->checkSizeUpper(levels, nodes);
     }
 }
 
-TTree *TTree::splitLeaf() {
+TTree *TTree::splitLeaf(unsigned long &levels, NodeCounts &nodes) {
+    HOT_PATH_COUNT(leafSplits, 1);
     unsigned long n = this->node.leafNode->bits();
     unsigned long mid = n / 2;
     mid -= mid % BLOCK_SIZE;
@@ -570,8 +635,10 @@ TTree *TTree::splitLeaf() {
     auto right = BitVector<>(left, mid, n);
     left.erase(mid, n);
     auto *newNode = new TTree(right);
+    nodes.leaves++;
     if (parent == nullptr) {
         auto *newRoot = new TTree(this, newNode);
+        nodes.internalNodes++;
         return newRoot;
     } else {
         unsigned long idx = indexInParent;
@@ -580,11 +647,11 @@ TTree *TTree::splitLeaf() {
         parent->node.internalNode->insert(indexInParent + 1, entry);
         parent->node.internalNode->entries[idx].b -= entry.b;
         parent->node.internalNode->entries[idx].o -= entry.o;
-        return parent->checkSizeUpper();
+        return parent->checkSizeUpper(levels, nodes);
     }
 }
 
-TTree *TTree::mergeInternal() {
+TTree *TTree::mergeInternal(unsigned long &levels, NodeCounts &nodes) {
     // If we are the root and we are too small, then we have only one child
     if (parent == nullptr) {
         // Delete this, our only child should become the root
@@ -592,11 +659,14 @@ TTree *TTree::mergeInternal() {
         // Overwrite the pointer in the entry, so that it is not deleted
         node.internalNode->entries[0].P = nullptr;
         delete this;
+        nodes.internalNodes--;
         child->parent = nullptr;
         child->indexInParent = 0;
         return child;
     }
 
+    HOT_PATH_COUNT(internalMerges, 1);
+    TTree *parent = this->parent; // `this` may be deleted below
     unsigned long idx = indexInParent;
     TTree *left = nullptr, *right = nullptr;
     if (idx > 0) {
@@ -624,13 +694,17 @@ TTree *TTree::mergeInternal() {
     parent->node.internalNode->remove(idx + 1);
     parent->node.internalNode->entries[idx].b += d_b;
     parent->node.internalNode->entries[idx].o += d_o;
-    return parent->checkSizeLower();
+    delete right;
+    nodes.internalNodes--;
+    return parent->checkSizeLower(levels, nodes);
 }
 
-TTree *TTree::mergeLeaf() {
+TTree *TTree::mergeLeaf(unsigned long &levels, NodeCounts &nodes) {
     if (parent == nullptr) {
         return nullptr;
     }
+    HOT_PATH_COUNT(leafMerges, 1);
+    TTree *parent = this->parent; // `this` may be deleted below
     unsigned long idx = indexInParent;
     TTree *left = nullptr, *right = nullptr;
     if (idx > 0) {
@@ -651,7 +725,9 @@ TTree *TTree::mergeLeaf() {
     parent->node.internalNode->entries[idx].b += d_b;
     parent->node.internalNode->entries[idx].o += d_o;
     parent->node.internalNode->remove(idx + 1);
-    return parent->checkSizeLower();
+    delete right;
+    nodes.leaves--;
+    return parent->checkSizeLower(levels, nodes);
 }
 
 unsigned long TTree::memoryUsage() {
@@ -668,4 +744,134 @@ unsigned long TTree::memoryUsage() {
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+TTree *TTree::fromBlocks(const vector<u64> &blocks) {
+    unsigned long n = blocks.size();
+    if (n == 0) {
+        return new TTree();
+    }
+
+    // Distribute the blocks as evenly as possible over the smallest number of
+    // leaves, which guarantees that every leaf has at least leafSizeMin blocks
+    unsigned long leaves = (n + leafSizeMax - 1) / leafSizeMax;
+    vector<TTree *> level;
+    level.reserve(leaves);
+    unsigned long next = 0;
+    for (unsigned long i = 0; i < leaves; i++) {
+        unsigned long count = n / leaves + (i < n % leaves ? 1 : 0);
+        auto *leaf = new TTree(count * BLOCK_SIZE);
+        auto &bv = leaf->node.leafNode->bv;
+        for (unsigned long j = 0; j < count; j++, next++) {
+            u64 block = blocks[next];
+            while (block != 0) {
+                bv.set(j * BLOCK_SIZE + __builtin_ctzll(block), true);
+                block &= block - 1;
+            }
+        }
+        level.push_back(leaf);
+    }
+
+    // Then group the nodes of each level under new parents in the same way,
+    // until only the root is left
+    while (level.size() > 1) {
+        unsigned long children = level.size();
+        unsigned long parents = (children + nodeSizeMax - 1) / nodeSizeMax;
+        vector<TTree *> above;
+        above.reserve(parents);
+        next = 0;
+        for (unsigned long i = 0; i < parents; i++) {
+            unsigned long count = children / parents + (i < children % parents ? 1 : 0);
+            auto *parent = new TTree(level[next], level[next + 1]);
+            for (unsigned long j = 2; j < count; j++) {
+                level[next + j]->parent = parent;
+                parent->node.internalNode->append(InternalNode::Entry(level[next + j]));
+            }
+            next += count;
+            above.push_back(parent);
+        }
+        level.swap(above);
+    }
+    return level[0];
+}
+
+void TTree::release(TTree *node) {
+    if (node != nullptr && node->references.fetch_sub(1) == 1) {
+        delete node;
+    }
+}
+
+TTree *TTree::copy() {
+    if (isLeaf) {
+        auto *result = new TTree(node.leafNode->bv);
+        result->parent = parent;
+        result->indexInParent = indexInParent;
+        return result;
+    }
+    auto *result = new TTree();
+    result->parent = parent;
+    result->indexInParent = indexInParent;
+    result->isLeaf = false;
+    delete result->node.leafNode;
+    result->node.internalNode = new InternalNode();
+    result->node.internalNode->size = node.internalNode->size;
+    for (unsigned long i = 0; i < node.internalNode->size; i++) {
+        auto &entry = node.internalNode->entries[i];
+        entry.P->references++;
+        result->node.internalNode->entries[i] = entry;
+    }
+    return result;
+}
+
+bool TTree::unshareChild(unsigned long i) {
+    auto &entry = node.internalNode->entries[i];
+    TTree *child = entry.P;
+    bool shared = child->references > 1;
+    if (shared) {
+        entry.P = child->copy();
+        // the old child stays alive for the snapshots that refer to it
+        release(child);
+    }
+    entry.P->parent = this;
+    entry.P->indexInParent = i;
+    return shared;
+}
+
+TTree *TTree::unsharePath(TTree *root, unsigned long n, vector<Nesbo> *path) {
+    bool copied = false;
+    if (root->references > 1) {
+        TTree *old = root;
+        root = old->copy();
+        release(old);
+        copied = true;
+    }
+    root->parent = nullptr;
+    TTree *current = root;
+    unsigned long bitsBefore = 0;
+    while (!current->isLeaf) {
+        Record record = current->findChild(n - bitsBefore);
+        bitsBefore += record.b;
+        unsigned long first = record.i > 0 ? record.i - 1 : 0;
+        unsigned long last = std::min(record.i + 1, current->node.internalNode->size - 1);
+        for (unsigned long i = first; i <= last; i++) {
+            copied |= current->unshareChild(i);
+        }
+        current = current->node.internalNode->entries[record.i].P;
+    }
+    if (copied && path != nullptr) {
+        path->clear();
+    }
+    return root;
+}
+
+void TTree::restoreParents(TTree *root) {
+    if (root->isLeaf) {
+        return;
+    }
+    for (unsigned long i = 0; i < root->node.internalNode->size; i++) {
+        TTree *child = root->node.internalNode->entries[i].P;
+        child->parent = root;
+        child->indexInParent = i;
+        restoreParents(child);
+    }
+}
@@ -0,0 +1,111 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <random>
+#include "TTree.h"
+#include "BenchCommon.h"
+
+/**
+ * Builds a TTree of the given number of blocks in which about half of the bits are set
+ */
+static TTree *randomTTree(unsigned long numBlocks, unsigned long seed) {
+    std::mt19937_64 generator(seed);
+    vector<u64> blocks(numBlocks);
+    for (auto &block : blocks) {
+        block = generator() & ((BLOCK_SIZE == 64 ? 0 : 1ull << BLOCK_SIZE) - 1);
+    }
+    return TTree::fromBlocks(blocks);
+}
+
+// All TTree benchmarks take the number of blocks in the tree and the access
+// pattern as arguments, and use a path like DKTree does
+static void BM_TTreeAccess(benchmark::State &state) {
+    auto numBlocks = (unsigned long) state.range(0);
+    auto pattern = (AccessPattern) state.range(1);
+    auto tree = randomTTree(numBlocks, 1);
+    auto positions = accessPositions(pattern, BATCH, tree->bits());
+    vector<Nesbo> path;
+    unsigned long i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree->access(positions[i++ % BATCH], &path));
+    }
+    setThroughput(state, 1);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+    delete tree;
+}
+
+static void BM_TTreeRank1(benchmark::State &state) {
+    auto numBlocks = (unsigned long) state.range(0);
+    auto pattern = (AccessPattern) state.range(1);
+    auto tree = randomTTree(numBlocks, 1);
+    auto positions = accessPositions(pattern, BATCH, tree->bits());
+    vector<Nesbo> path;
+    unsigned long i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree->rank1(positions[i++ % BATCH], &path));
+    }
+    setThroughput(state, 1);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+    delete tree;
+}
+
+// Inserts a batch of blocks, and deletes them again in reverse order outside
+// of the timed region, so that every batch starts from the same tree
+static void BM_TTreeInsertBlock(benchmark::State &state) {
+    auto numBlocks = (unsigned long) state.range(0);
+    auto pattern = (AccessPattern) state.range(1);
+    auto tree = randomTTree(numBlocks, 1);
+    auto positions = accessPositions(pattern, BATCH, tree->bits() + 1, 2, BLOCK_SIZE);
+    vector<Nesbo> path;
+    for (auto _ : state) {
+        for (auto position : positions) {
+            TTree *newRoot = tree->insertBlock(position, &path);
+            tree = newRoot == nullptr ? tree : newRoot;
+            path.clear();
+        }
+        state.PauseTiming();
+        for (unsigned long i = BATCH; i > 0; i--) {
+            TTree *newRoot = tree->deleteBlock(positions[i - 1], &path);
+            tree = newRoot == nullptr ? tree : newRoot;
+            path.clear();
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, BATCH);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+    delete tree;
+}
+
+// Deletes a batch of blocks, and inserts empty blocks in their place again
+// outside of the timed region
+static void BM_TTreeDeleteBlock(benchmark::State &state) {
+    auto numBlocks = (unsigned long) state.range(0);
+    auto pattern = (AccessPattern) state.range(1);
+    auto tree = randomTTree(numBlocks + BATCH, 1);
+    auto positions = accessPositions(pattern, BATCH, numBlocks * BLOCK_SIZE, 2, BLOCK_SIZE);
+    vector<Nesbo> path;
+    for (auto _ : state) {
+        for (auto position : positions) {
+            TTree *newRoot = tree->deleteBlock(position, &path);
+            tree = newRoot == nullptr ? tree : newRoot;
+            path.clear();
+        }
+        state.PauseTiming();
+        for (unsigned long i = BATCH; i > 0; i--) {
+            TTree *newRoot = tree->insertBlock(positions[i - 1], &path);
+            tree = newRoot == nullptr ? tree : newRoot;
+            path.clear();
+        }
+        state.ResumeTiming();
+    }
+    setThroughput(state, BATCH);
+    state.SetLabel(ACCESS_PATTERN_NAMES[pattern]);
+    delete tree;
+}
+
+BENCHMARK(BM_TTreeAccess)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {RANDOM, CLUSTERED, SEQUENTIAL}});
+BENCHMARK(BM_TTreeRank1)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {RANDOM, CLUSTERED, SEQUENTIAL}});
+BENCHMARK(BM_TTreeInsertBlock)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {RANDOM, CLUSTERED, SEQUENTIAL}});
+BENCHMARK(BM_TTreeDeleteBlock)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {RANDOM, CLUSTERED, SEQUENTIAL}});
+
@@ -6,6 +6,7 @@
 #define TTREE_TEST
 
 #include "TTree.h"
+#include "LTree.h"
 #include <cstdio>
 #include <iostream>
 #include "gtest/gtest.h"
@@ -439,4 +440,168 @@ TEST(TTreeTest, BPlusTest3) {
     }
 }
 
-#endif // TTREE_TEST
\ No newline at end of file
+TEST(TTreeTest, FromBlocks) {
+    // Build trees of many sizes bottom-up, and check that they are valid B+
+    // trees that still support inserting and deleting blocks
+    for (unsigned long numBlocks : {0u, 1u, leafSizeMax, leafSizeMax + 1, 3 * leafSizeMax + 5, 1000u}) {
+        vector<u64> blocks(numBlocks);
+        vector<bool> ref(numBlocks * BLOCK_SIZE, false);
+        for (unsigned long i = 0; i < numBlocks; i++) {
+            blocks[i] = (i * 2654435761ul) & ((1ul << BLOCK_SIZE) - 1);
+            for (unsigned long j = 0; j < BLOCK_SIZE; j++) {
+                ref[i * BLOCK_SIZE + j] = ((blocks[i] >> j) & 1) != 0;
+            }
+        }
+        auto root = TTree::fromBlocks(blocks);
+        ASSERT_TRUE(validate(root));
+        ASSERT_TRUE(validateSize(root));
+        ASSERT_TRUE(treeEqualsVec(root, ref));
+
+        insertBlock(&root, 0);
+        ref.insert(ref.begin(), BLOCK_SIZE, false);
+        ASSERT_TRUE(validate(root));
+        ASSERT_TRUE(validateSize(root));
+        ASSERT_TRUE(treeEqualsVec(root, ref));
+
+        deleteBlock(&root, (ref.size() / BLOCK_SIZE / 2) * BLOCK_SIZE);
+        ref.erase(ref.begin() + (ref.size() / BLOCK_SIZE / 2) * BLOCK_SIZE,
+                  ref.begin() + (ref.size() / BLOCK_SIZE / 2 + 1) * BLOCK_SIZE);
+        ASSERT_TRUE(validate(root));
+        ASSERT_TRUE(validateSize(root));
+        ASSERT_TRUE(treeEqualsVec(root, ref));
+        delete root;
+    }
+}
+
+/**
+ * Checks that every entry of a cached path still describes the tree: its node is the root or the child of the
+ * entry above it, and its size and bits and ones before are those a new search would find
+ */
+bool pathIsValid(TTree *root, const vector<Nesbo> &path) {
+    TTree *node = root;
+    unsigned long bitsBefore = 0, onesBefore = 0;
+    for (auto &nesbo : path) {
+        if (nesbo.node != node || node->isLeaf || nesbo.index >= node->size()) {
+            return false;
+        }
+        auto &entries = node->node.internalNode->entries;
+        for (unsigned long i = 0; i < nesbo.index; i++) {
+            bitsBefore += entries[i].b;
+            onesBefore += entries[i].o;
+        }
+        if (nesbo.size != entries[nesbo.index].b || nesbo.bitsBefore != bitsBefore
+            || nesbo.onesBefore != onesBefore) {
+            return false;
+        }
+        node = entries[nesbo.index].P;
+    }
+    return true;
+}
+
+TEST(TTreeTest, CachedPathSurvivesInsertDelete) {
+    // blocks are inserted and deleted around a position that moves slowly, as in DKTree::addEdge, and the
+    // path is only cut back to the nodes above the ones that were rebalanced
+    srand(5);
+    auto *root = new TTree();
+    vector<bool> ref;
+    vector<Nesbo> path;
+    unsigned long cursor = 0, kept = 0, changes = 0;
+    for (unsigned long i = 0; i < 20000; i++) {
+        unsigned long blocks = ref.size() / BLOCK_SIZE;
+        // the cursor moves by at most two blocks
+        unsigned long step = rand() % 5;
+        cursor = std::min(blocks, cursor + step >= 2 ? cursor + step - 2 : 0);
+        unsigned long position = cursor * BLOCK_SIZE;
+        int operation = rand() % 10;
+        if (operation < 5 || blocks < 2) {
+            auto result = root->insertBlock(position, &path);
+            if (result != nullptr) {
+                root = result;
+                path.clear();
+            }
+            ref.insert(ref.begin() + position, BLOCK_SIZE, false);
+            changes++;
+            kept += path.empty() ? 0 : 1;
+        } else if (operation < 7) {
+            position = std::min(position, ref.size() - BLOCK_SIZE);
+            auto result = root->deleteBlock(position, &path);
+            if (result != nullptr) {
+                root = result;
+                path.clear();
+            }
+            ref.erase(ref.begin() + position, ref.begin() + position + BLOCK_SIZE);
+            changes++;
+            kept += path.empty() ? 0 : 1;
+        } else if (operation < 9) {
+            position = std::min(position + rand() % BLOCK_SIZE, ref.size() - 1);
+            bool value = rand() % 2 == 0;
+            root->setBit(position, value, &path);
+            ref[position] = value;
+        } else {
+            position = std::min(position, ref.size() - 1);
+            ASSERT_EQ(root->rank1(position), root->rank1(position, &path));
+        }
+        ASSERT_TRUE(pathIsValid(root, path)) << "after operation " << i;
+        if (i % 1000 == 0) {
+            ASSERT_TRUE(validate(root));
+            ASSERT_TRUE(validateSize(root));
+            ASSERT_TRUE(treeEqualsVec(root, ref));
+        }
+    }
+    ASSERT_TRUE(validate(root));
+    ASSERT_TRUE(treeEqualsVec(root, ref));
+    // almost all changes leave the nodes above the leaf in place
+    ASSERT_LT(changes * 9 / 10, kept);
+    delete root;
+}
+
+// counts the nodes of a TTree or LTree by walking it
+template<typename Tree>
+NodeCounts walkNodes(Tree *tree) {
+    NodeCounts counts;
+    if (tree->isLeaf) {
+        counts.leaves++;
+        return counts;
+    }
+    counts.internalNodes++;
+    for (unsigned long i = 0; i < tree->node.internalNode->size; i++) {
+        counts += walkNodes(tree->node.internalNode->entries[i].P);
+    }
+    return counts;
+}
+
+// inserts and deletes blocks at random, and checks the nodes that insertBlock and deleteBlock report
+template<typename Tree>
+void expectReportedNodes() {
+    srand(7);
+    auto *root = new Tree();
+    NodeCounts nodes = walkNodes(root);
+    unsigned long blocks = 0;
+    for (unsigned long i = 0; i < 30000; i++) {
+        // grow to a few thousand blocks first, so that the height changes both ways
+        bool insert = blocks == 0 || (i < 15000 ? rand() % 10 < 7 : rand() % 10 < 3);
+        unsigned long position = (rand() % (blocks + (insert ? 1 : 0))) * BLOCK_SIZE;
+        auto result = insert ? root->insertBlock(position, nullptr, &nodes)
+                             : root->deleteBlock(position, nullptr, &nodes);
+        if (result != nullptr) {
+            root = result;
+        }
+        blocks += insert ? 1 : -1;
+        if (result != nullptr || i % 1000 == 0) {
+            NodeCounts walked = walkNodes(root);
+            ASSERT_EQ(walked.leaves, nodes.leaves) << "after operation " << i;
+            ASSERT_EQ(walked.internalNodes, nodes.internalNodes) << "after operation " << i;
+        }
+    }
+    NodeCounts walked = walkNodes(root);
+    ASSERT_EQ(walked.leaves, nodes.leaves);
+    ASSERT_EQ(walked.internalNodes, nodes.internalNodes);
+    delete root;
+}
+
+TEST(TTreeTest, InsertDeleteReportNodes) {
+    expectReportedNodes<TTree>();
+    expectReportedNodes<LTree>();
+}
+
+#endif // TTREE_TEST
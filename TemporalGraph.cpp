@@ -0,0 +1,188 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <sstream>
+#include <stdexcept>
+
+#include "TemporalGraph.h"
+
+using namespace std;
+
+// the union of a tree with itself is a copy, built bottom-up with the blocks of the tree
+static DKTree *copyOf(const DKTree &tree) {
+    return tree.unite(tree);
+}
+
+TemporalGraph::TemporalGraph(unsigned long size, unsigned long checkpointInterval)
+        : size(size), checkpointInterval(checkpointInterval) {
+    if (checkpointInterval == 0) {
+        throw invalid_argument("TemporalGraph: invalid argument, the checkpoint interval must be positive\n");
+    }
+    current = DKTree::withSize(size);
+}
+
+TemporalGraph::~TemporalGraph() {
+    delete current;
+    for (Slice &slice : slices) {
+        delete slice.added;
+        delete slice.removed;
+    }
+    for (DKTree *checkpoint : checkpoints) {
+        delete checkpoint;
+    }
+}
+
+void TemporalGraph::addEdge(unsigned long row, unsigned long column) {
+    bool existed = current->reportEdge(row, column);
+    if (!existed) {
+        // the first change of an edge in this slice records whether it existed before
+        changed.emplace(make_pair(row, column), false);
+        current->addEdge(row, column);
+    }
+}
+
+void TemporalGraph::removeEdge(unsigned long row, unsigned long column) {
+    bool existed = current->reportEdge(row, column);
+    if (existed) {
+        changed.emplace(make_pair(row, column), true);
+        current->removeEdge(row, column);
+    }
+}
+
+unsigned long TemporalGraph::advance() {
+    // only the edges whose state differs from the start of the slice are stored
+    vector<pair<unsigned long, unsigned long>> added, removed;
+    for (auto &change : changed) {
+        bool exists = current->reportEdge(change.first.first, change.first.second);
+        if (exists && !change.second) {
+            added.push_back(change.first);
+        } else if (!exists && change.second) {
+            removed.push_back(change.first);
+        }
+    }
+    changed.clear();
+    Slice slice;
+    if (!added.empty()) {
+        slice.added = DKTree::fromEdges(size, added);
+    }
+    if (!removed.empty()) {
+        slice.removed = DKTree::fromEdges(size, removed);
+    }
+    if (now() % checkpointInterval == 0) {
+        checkpoints.push_back(copyOf(*current));
+    }
+    slices.push_back(slice);
+    return now();
+}
+
+void TemporalGraph::checkTime(unsigned long time, const char *functionName) const {
+    if (time > now()) {
+        stringstream error;
+        error << functionName << ": invalid argument " << time << ", the current time is " << now() << "\n";
+        throw invalid_argument(error.str());
+    }
+}
+
+bool TemporalGraph::reportEdge(unsigned long row, unsigned long column, unsigned long time) {
+    checkTime(time, "reportEdge");
+    if (time == now()) {
+        return current->reportEdge(row, column);
+    }
+    // the latest slice since the last checkpoint that changed the edge decides whether it exists
+    unsigned long checkpoint = time / checkpointInterval;
+    for (unsigned long slice = time; slice > checkpoint * checkpointInterval; slice--) {
+        if (slices[slice].added != nullptr && slices[slice].added->reportEdge(row, column)) {
+            return true;
+        }
+        if (slices[slice].removed != nullptr && slices[slice].removed->reportEdge(row, column)) {
+            return false;
+        }
+    }
+    return checkpoints[checkpoint]->reportEdge(row, column);
+}
+
+bool TemporalGraph::reportEdgeDuring(unsigned long row, unsigned long column, unsigned long from,
+                                     unsigned long to) {
+    checkTime(to, "reportEdgeDuring");
+    if (from > to) {
+        throw invalid_argument("reportEdgeDuring: invalid argument, the interval is empty\n");
+    }
+    if (reportEdge(row, column, from)) {
+        return true;
+    }
+    // otherwise the edge has to be added by one of the later slices
+    for (unsigned long slice = from + 1; slice <= to && slice < now(); slice++) {
+        if (slices[slice].added != nullptr && slices[slice].added->reportEdge(row, column)) {
+            return true;
+        }
+    }
+    return to == now() && from < now() && current->reportEdge(row, column);
+}
+
+DKTree *TemporalGraph::stateAt(unsigned long time) const {
+    if (time == now()) {
+        return copyOf(*current);
+    }
+    unsigned long checkpoint = time / checkpointInterval;
+    DKTree *state = copyOf(*checkpoints[checkpoint]);
+    for (unsigned long slice = checkpoint * checkpointInterval + 1; slice <= time; slice++) {
+        for (DKTree *change : {slices[slice].added, slices[slice].removed}) {
+            if (change == nullptr) {
+                continue;
+            }
+            DKTree *next = change == slices[slice].added ? state->unite(*change) : state->subtract(*change);
+            delete state;
+            state = next;
+        }
+    }
+    return state;
+}
+
+DKTree *TemporalGraph::snapshot(unsigned long time) const {
+    checkTime(time, "snapshot");
+    return stateAt(time);
+}
+
+DKTree *TemporalGraph::activeDuring(unsigned long from, unsigned long to) const {
+    checkTime(to, "activeDuring");
+    if (from > to) {
+        throw invalid_argument("activeDuring: invalid argument, the interval is empty\n");
+    }
+    DKTree *result = stateAt(from);
+    for (unsigned long slice = from + 1; slice <= to && slice < now(); slice++) {
+        if (slices[slice].added != nullptr) {
+            DKTree *next = result->unite(*slices[slice].added);
+            delete result;
+            result = next;
+        }
+    }
+    if (to == now() && from < now()) {
+        // the edges added in the current slice, which has no tree of its own yet
+        vector<pair<unsigned long, unsigned long>> added;
+        for (auto &change : changed) {
+            if (!change.second && current->reportEdge(change.first.first, change.first.second)) {
+                added.push_back(change.first);
+            }
+        }
+        DKTree *addedTree = DKTree::fromEdges(size, added);
+        DKTree *next = result->unite(*addedTree);
+        delete addedTree;
+        delete result;
+        result = next;
+    }
+    return result;
+}
+
+unsigned long TemporalGraph::memoryUsage() const {
+    unsigned long bytes = current->memoryUsage();
+    for (const Slice &slice : slices) {
+        bytes += sizeof(Slice);
+        bytes += slice.added == nullptr ? 0 : slice.added->memoryUsage();
+        bytes += slice.removed == nullptr ? 0 : slice.removed->memoryUsage();
+    }
+    for (DKTree *checkpoint : checkpoints) {
+        bytes += checkpoint->memoryUsage();
+    }
+    return bytes;
+}
@@ -0,0 +1,116 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_TEMPORAL_GRAPH_H
+#define DK2TREE_TEMPORAL_GRAPH_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "DKTree.h"
+
+/**
+ * A graph whose edges change over time, in discrete time slices 0, 1, 2, ...
+ * Every closed slice stores the edges it added and the edges it removed as two
+ * k2-trees (nothing at all for a slice without changes), and every
+ * `checkpointInterval` slices the complete graph is stored as a checkpoint.
+ *
+ * Whether an edge exists at time t is decided by the latest slice between the
+ * last checkpoint before t and t that changed the edge, so a point query is at
+ * most `checkpointInterval` calls of `DKTree::reportEdge`, most of them on
+ * small trees, and it stops at the first slice that changed the edge.
+ * Complete snapshots are built from a checkpoint and the slices after it with
+ * `DKTree::unite` and `DKTree::subtract`.
+ *
+ * Changes are made to the current, open, slice. Only the net change of a slice
+ * is kept, so an edge that is added and removed again within one slice never
+ * existed.
+ */
+class TemporalGraph {
+    // the changes of a closed time slice, nullptr if the slice did not add or remove any edge
+    struct Slice {
+        DKTree *added = nullptr;
+        DKTree *removed = nullptr;
+    };
+
+    unsigned long size;
+    unsigned long checkpointInterval;
+    DKTree *current; // the graph at the current time
+    std::vector<Slice> slices; // the changes of every closed slice
+    std::vector<DKTree *> checkpoints; // checkpoints[c] is the graph at time c * checkpointInterval
+    // the edges changed in the current slice, and whether they existed at the start of it
+    std::map<std::pair<unsigned long, unsigned long>, bool> changed;
+
+    /// @throws illegal argument exception if time is after the current time
+    void checkTime(unsigned long time, const char *functionName) const;
+
+    /// @return the graph at the start of the slice after `time`, as a new tree
+    DKTree *stateAt(unsigned long time) const;
+
+public:
+    /**
+     * Creates a temporal graph without edges, at time 0
+     * @param size the number of vertices, which get the ids 0 ... size - 1
+     * @param checkpointInterval the number of slices between two checkpoints, larger values use less
+     *        memory but make queries slower
+     * @throws illegal argument exception if checkpointInterval is 0
+     */
+    explicit TemporalGraph(unsigned long size, unsigned long checkpointInterval = 16);
+
+    ~TemporalGraph();
+
+    TemporalGraph(const TemporalGraph &) = delete;
+
+    TemporalGraph &operator=(const TemporalGraph &) = delete;
+
+    /// Adds the edge (row, column) at the current time
+    void addEdge(unsigned long row, unsigned long column);
+
+    /// Removes the edge (row, column) at the current time
+    void removeEdge(unsigned long row, unsigned long column);
+
+    /**
+     * Closes the current slice, and starts the next one with the same edges
+     * @return the new current time
+     */
+    unsigned long advance();
+
+    /// @return the current time, the slice to which changes are made
+    unsigned long now() const {
+        return slices.size();
+    }
+
+    /**
+     * Reports whether the edge (row, column) exists at the given time
+     * @throws illegal argument exception if time is after the current time, or if row or column is not a vertex
+     */
+    bool reportEdge(unsigned long row, unsigned long column, unsigned long time);
+
+    /**
+     * Reports whether the edge (row, column) exists at any time in [from, to]
+     * @throws illegal argument exception if from > to, if to is after the current time, or if row or column is
+     *         not a vertex
+     */
+    bool reportEdgeDuring(unsigned long row, unsigned long column, unsigned long from, unsigned long to);
+
+    /**
+     * Builds the graph at the given time
+     * @return a new tree with the edges at that time, to be deleted by the caller
+     * @throws illegal argument exception if time is after the current time
+     */
+    DKTree *snapshot(unsigned long time) const;
+
+    /**
+     * Builds the graph of all edges that exist at some time in [from, to], the graph at time from together
+     * with the edges added after it
+     * @return a new tree with these edges, to be deleted by the caller
+     * @throws illegal argument exception if from > to, or if to is after the current time
+     */
+    DKTree *activeDuring(unsigned long from, unsigned long to) const;
+
+    /// @return the number of bytes used by the checkpoints, the slices and the current graph
+    unsigned long memoryUsage() const;
+};
+
+#endif // DK2TREE_TEMPORAL_GRAPH_H
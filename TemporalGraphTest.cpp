@@ -0,0 +1,94 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef TEMPORAL_GRAPH_TEST
+#define TEMPORAL_GRAPH_TEST
+
+#include <random>
+#include <set>
+#include "TemporalGraph.h"
+#include "gtest/gtest.h"
+
+typedef std::vector<std::pair<unsigned long, unsigned long>> EdgeVector;
+
+// all edges of a tree with the given number of vertices, in sorted order
+static EdgeVector allEdgesOf(DKTree &tree, unsigned long vertices) {
+    std::vector<unsigned long> all;
+    for (unsigned long vertex = 0; vertex < vertices; vertex++) {
+        all.push_back(vertex);
+    }
+    auto edges = tree.reportAllEdges(all, all);
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+TEST(TemporalGraphTest, QueriesMatchReference) {
+    const unsigned long vertices = 200, times = 40;
+    std::mt19937_64 random(3);
+    TemporalGraph graph(vertices, 8);
+    // the edges at every time, by replaying the same changes on a set
+    std::vector<std::set<std::pair<unsigned long, unsigned long>>> states(1);
+    std::vector<std::pair<unsigned long, unsigned long>> pool;
+    for (unsigned long i = 0; i < 600; i++) {
+        pool.emplace_back(random() % vertices, random() % vertices);
+    }
+    for (unsigned long time = 0; time < times; time++) {
+        ASSERT_EQ(time, graph.now());
+        // some slices do not change anything, and some edges change twice within a slice
+        unsigned long changes = time % 5 == 3 ? 0 : random() % 80;
+        for (unsigned long i = 0; i < changes; i++) {
+            auto edge = pool[random() % pool.size()];
+            if (random() % 3 == 0) {
+                graph.removeEdge(edge.first, edge.second);
+                states.back().erase(edge);
+            } else {
+                graph.addEdge(edge.first, edge.second);
+                states.back().insert(edge);
+            }
+        }
+        if (time + 1 < times) {
+            graph.advance();
+            states.push_back(states.back());
+        }
+    }
+
+    for (unsigned long time = 0; time < times; time++) {
+        for (unsigned long i = 0; i < 50; i++) {
+            auto edge = pool[random() % pool.size()];
+            ASSERT_EQ(states[time].count(edge) == 1, graph.reportEdge(edge.first, edge.second, time))
+                                        << "time " << time;
+        }
+        DKTree *snapshot = graph.snapshot(time);
+        ASSERT_EQ(EdgeVector(states[time].begin(), states[time].end()), allEdgesOf(*snapshot, vertices))
+                                    << "time " << time;
+        delete snapshot;
+    }
+
+    for (unsigned long from : {0ul, 5ul, 16ul, 30ul}) {
+        for (unsigned long to : {from, from + 3, times - 1}) {
+            std::set<std::pair<unsigned long, unsigned long>> active;
+            for (unsigned long time = from; time <= to; time++) {
+                active.insert(states[time].begin(), states[time].end());
+            }
+            DKTree *during = graph.activeDuring(from, to);
+            ASSERT_EQ(EdgeVector(active.begin(), active.end()), allEdgesOf(*during, vertices)) << from << " " << to;
+            delete during;
+            for (unsigned long i = 0; i < 50; i++) {
+                auto edge = pool[random() % pool.size()];
+                ASSERT_EQ(active.count(edge) == 1, graph.reportEdgeDuring(edge.first, edge.second, from, to));
+            }
+        }
+    }
+
+    try {
+        graph.reportEdge(0, 0, times);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+    try {
+        graph.activeDuring(5, 4);
+        ASSERT_FALSE(true); // should not be reached
+    } catch (const std::invalid_argument &e) {}
+}
+
+#endif // TEMPORAL_GRAPH_TEST
@@ -0,0 +1,46 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#include <algorithm>
+
+#include "Triangles.h"
+
+using namespace std;
+
+vector<unsigned long> triangleCounts(DKTree &tree) {
+    const unsigned long n = tree.vertexBound();
+    vector<unsigned long> counts(n, 0);
+    for (unsigned long v = 0; v < n; v++) {
+        // the successors of v are only listed to enumerate the edges, not to intersect them
+        vector<unsigned long> neighbours;
+        tree.expandFrontier({v}, neighbours);
+        bool selfLoop = binary_search(neighbours.begin(), neighbours.end(), v);
+        unsigned long pairs = 0;
+        for (unsigned long u : neighbours) {
+            if (u == v) {
+                continue;
+            }
+            // every common neighbour w of v and u other than v and u closes a triangle v, u, w
+            unsigned long common = tree.countCommonSuccessors(v, u);
+            if (selfLoop) {
+                common--; // v itself, which is a neighbour of u since the matrix is symmetric
+            }
+            if (tree.reportEdge(u, u)) {
+                common--; // u itself, which is a neighbour of v
+            }
+            pairs += common;
+        }
+        // every triangle through v is found once from each of its two other vertices
+        counts[v] = pairs / 2;
+    }
+    return counts;
+}
+
+unsigned long countTriangles(DKTree &tree) {
+    unsigned long total = 0;
+    for (unsigned long count : triangleCounts(tree)) {
+        total += count;
+    }
+    return total / 3;
+}
@@ -0,0 +1,29 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_TRIANGLES_H
+#define DK2TREE_TRIANGLES_H
+
+#include <vector>
+#include "DKTree.h"
+
+/**
+ * Counts the triangles through every vertex of an undirected graph, which is
+ * stored with both directions of every edge, so the matrix must be symmetric.
+ * For every edge (v, u), the common neighbours of v and u are counted with
+ * `DKTree::countCommonSuccessors`, which descends both rows in lockstep and
+ * never lists the neighbours of either. Self-loops are ignored.
+ *
+ * @param tree the graph, with a symmetric matrix
+ * @return for every vertex below tree.vertexBound(), the number of triangles it is part of
+ */
+std::vector<unsigned long> triangleCounts(DKTree &tree);
+
+/**
+ * Counts the triangles of an undirected graph, stored with both directions of every edge
+ * @return the number of triangles, a third of the sum of `triangleCounts`
+ */
+unsigned long countTriangles(DKTree &tree);
+
+#endif // DK2TREE_TRIANGLES_H
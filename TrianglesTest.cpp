@@ -0,0 +1,93 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef TRIANGLES_TEST
+#define TRIANGLES_TEST
+
+#include <algorithm>
+#include <set>
+#include "GraphGenerator.h"
+#include "Triangles.h"
+#include "gtest/gtest.h"
+
+// adds the reverse of every edge, so that the matrix is symmetric
+static std::vector<Edge> symmetric(const std::vector<Edge> &edges) {
+    std::set<Edge> both(edges.begin(), edges.end());
+    for (auto &edge : edges) {
+        both.insert(Edge(edge.second, edge.first));
+    }
+    return std::vector<Edge>(both.begin(), both.end());
+}
+
+TEST(TrianglesTest, IntersectSuccessors) {
+    const unsigned long vertices = 1500;
+    Arities hybrid;
+    hybrid.top = 4;
+    hybrid.topLevels = 2;
+    hybrid.leaf = 4;
+    auto edges = communityEdges(vertices, 12000, 10, 2);
+    std::vector<std::vector<unsigned long>> successors(vertices);
+    for (auto &edge : edges) {
+        successors[edge.first].push_back(edge.second);
+    }
+    for (int mode = 0; mode < 3; mode++) {
+        DKTree *tree = DKTree::fromEdges(vertices, edges, mode == 2, mode == 1 ? hybrid : Arities());
+        for (unsigned long a = 0; a < vertices; a += 13) {
+            for (unsigned long b : {a, (a * 7 + 3) % vertices, (a + 1) % vertices}) {
+                std::vector<unsigned long> expected;
+                std::set_intersection(successors[a].begin(), successors[a].end(), successors[b].begin(),
+                                      successors[b].end(), std::back_inserter(expected));
+                ASSERT_EQ(expected, tree->intersectSuccessors(a, b)) << a << " and " << b;
+                ASSERT_EQ(expected.size(), tree->countCommonSuccessors(a, b));
+            }
+        }
+        try {
+            tree->intersectSuccessors(0, vertices);
+            ASSERT_FALSE(true); // should not be reached
+        } catch (const std::invalid_argument &e) {}
+        delete tree;
+    }
+}
+
+TEST(TrianglesTest, TriangleCountsMatchBruteForce) {
+    const unsigned long vertices = 400;
+    for (int kind = UNIFORM; kind <= COMMUNITY; kind++) {
+        auto edges = symmetric(generateGraph((GraphKind) kind, vertices, 4, 8));
+        // a few self-loops, which are not part of any triangle
+        edges.emplace_back(5, 5);
+        edges.emplace_back(17, 17);
+        std::vector<std::vector<bool>> adjacent(vertices, std::vector<bool>(vertices, false));
+        for (auto &edge : edges) {
+            adjacent[edge.first][edge.second] = true;
+        }
+        std::vector<unsigned long> expected(vertices, 0);
+        unsigned long total = 0;
+        for (unsigned long a = 0; a < vertices; a++) {
+            for (unsigned long b = a + 1; b < vertices; b++) {
+                if (!adjacent[a][b]) {
+                    continue;
+                }
+                for (unsigned long c = b + 1; c < vertices; c++) {
+                    if (adjacent[a][c] && adjacent[b][c]) {
+                        expected[a]++;
+                        expected[b]++;
+                        expected[c]++;
+                        total++;
+                    }
+                }
+            }
+        }
+        for (bool vocabulary : {false, true}) {
+            DKTree *tree = DKTree::fromEdges(vertices, edges, vocabulary);
+            ASSERT_EQ(expected, triangleCounts(*tree)) << GRAPH_KIND_NAMES[kind];
+            ASSERT_EQ(total, countTriangles(*tree));
+            // a deleted vertex is part of no triangles, and is skipped without an error
+            tree->deleteEntry(20);
+            ASSERT_EQ(0, triangleCounts(*tree)[20]);
+            delete tree;
+        }
+    }
+}
+
+#endif // TRIANGLES_TEST
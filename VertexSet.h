@@ -0,0 +1,73 @@
+//
+// Created by agent on 19-10-26.
+//
+
+#ifndef DK2TREE_VERTEX_SET_H
+#define DK2TREE_VERTEX_SET_H
+
+#include <algorithm>
+#include <vector>
+#include "BitVector.h"
+
+/**
+ * A set of vertex ids below a fixed bound, stored as one bit per vertex. This
+ * is the visited bitmap of the traversals: testing and adding a vertex are a
+ * shift and a mask, and the memory used is the bound divided by 8 bytes
+ */
+class VertexSet {
+    std::vector<u64> words;
+    unsigned long bound;
+    unsigned long elements = 0;
+
+public:
+    /// Creates an empty set that can contain the vertices 0 ... bound - 1
+    explicit VertexSet(unsigned long bound) : words((bound + 63) / 64, 0), bound(bound) {}
+
+    /// @return whether the vertex is in the set
+    bool contains(unsigned long vertex) const {
+        return (words[vertex / 64] >> (vertex % 64)) & 1;
+    }
+
+    /**
+     * Adds the vertex to the set
+     * @return true if the vertex was not in the set yet, false otherwise
+     */
+    bool insert(unsigned long vertex) {
+        u64 mask = 1ul << (vertex % 64);
+        u64 &word = words[vertex / 64];
+        if (word & mask) {
+            return false;
+        }
+        word |= mask;
+        elements++;
+        return true;
+    }
+
+    /// Removes the vertex from the set, if it is in it
+    void erase(unsigned long vertex) {
+        u64 mask = 1ul << (vertex % 64);
+        u64 &word = words[vertex / 64];
+        if (word & mask) {
+            word &= ~mask;
+            elements--;
+        }
+    }
+
+    /// @return the number of vertices in the set
+    unsigned long size() const {
+        return elements;
+    }
+
+    /// @return the number of vertices that fit in the set, all vertices are below this number
+    unsigned long capacity() const {
+        return bound;
+    }
+
+    /// Removes all vertices from the set
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+        elements = 0;
+    }
+};
+
+#endif // DK2TREE_VERTEX_SET_H
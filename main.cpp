@@ -1,17 +1,97 @@
 #include <iostream>
 #include <fstream>
+#include <functional>
 using namespace std;
 
-#include "DKTree.cpp"
-#include "MakeGraphFromFile.cpp"
-#include "parameters.cpp"
+#include "DKTree.h"
+#include "GraphLoader.h"
+#include "parameters.h"
 #include "LargeGraphTest.cpp"
+#include "LatencyHistogram.h"
+#include "GraphGenerator.h"
+
+/**
+ * Converts a text edge-list to a binary edge-list, the encoding is one of
+ * "32", "64" or "varint"
+ */
+int convert(const string &input, const string &output, const string &encoding) {
+    EdgeEncoding format;
+    if (encoding == "32") {
+        format = FIXED_32;
+    } else if (encoding == "64") {
+        format = FIXED_64;
+    } else if (encoding == "varint") {
+        format = DELTA_VARINT;
+    } else {
+        std::cout << "error: unknown encoding " << encoding << ", expected 32, 64 or varint" << std::endl;
+        return 1;
+    }
+    unsigned long edges = convertEdgeList(input, output, format);
+    std::cout << "wrote " << edges << " edges to " << output << std::endl;
+    return 0;
+}
+
+/**
+ * Writes a synthetic graph of the given kind to a binary edge-list
+ */
+int generate(const string &kind, const string &vertices, const string &density,
+             const string &output, const string &seed) {
+    auto edges = generateGraph(graphKindFromName(kind), strtoul(vertices.c_str(), nullptr, 10),
+                               strtoul(density.c_str(), nullptr, 10), strtoul(seed.c_str(), nullptr, 10));
+    writeBinaryEdgeList(output, edges, DELTA_VARINT);
+    std::cout << "wrote " << edges.size() << " edges to " << output << std::endl;
+    return 0;
+}
+
+/**
+ * Reads an edge-list in either the text or the binary format
+ */
+vector<Edge> loadEdges(const string &name) {
+    return isBinaryEdgeList(name) ? readBinaryEdgeList(name) : readEdgeList(name);
+}
+
+/**
+ * Writes the latency histograms of all operations to the given file, as a JSON
+ * array if the name ends in ".json" and as CSV otherwise. CSV lines are appended,
+ * so that the results of several graphs or versions can be collected in one file
+ */
+void writeResults(const string &name, const string &graph,
+                  const vector<std::pair<string, LatencyHistogram>> &results) {
+    bool json = name.size() >= 5 && name.compare(name.size() - 5, 5, ".json") == 0;
+    bool exists = ifstream(name).good();
+    ofstream file(name, json ? ios::trunc : ios::app);
+    if (json) {
+        file << "{\"graph\": \"" << graph << "\", \"unit\": \"ns\", \"operations\": [";
+        for (unsigned long i = 0; i < results.size(); i++) {
+            file << (i == 0 ? "\n  " : ",\n  ");
+            results[i].second.writeJson(file, results[i].first);
+        }
+        file << "\n]}" << std::endl;
+    } else {
+        if (!exists) {
+            file << "graph,";
+            LatencyHistogram::writeCsvHeader(file);
+        }
+        for (auto &result : results) {
+            file << graph << ",";
+            result.second.writeCsv(file, result.first);
+        }
+    }
+}
 
 int main(int argc, char **argv) {
 
-    if (argc != 6) {
+    if (argc >= 4 && string(argv[1]) == "convert") {
+        return convert(argv[2], argv[3], argc >= 5 ? argv[4] : "varint");
+    }
+    if (argc >= 6 && string(argv[1]) == "generate") {
+        return generate(argv[2], argv[3], argv[4], argv[5], argc >= 7 ? argv[6] : "1");
+    }
+    if (argc != 6 && argc != 7) {
         std::cout << "error: invalid number of arguments" << std::endl;
-        std::cout << "expected: dk2tree inputfilename outputfilename posEdges negEdges numberOfNodes" << std::endl;
+        std::cout << "expected: dk2tree inputfilename outputfilename posEdges negEdges numberOfNodes [results.json|results.csv]" << std::endl;
+        std::cout << "      or: dk2tree convert textfilename binaryfilename [32|64|varint]" << std::endl;
+        std::cout << "      or: dk2tree generate uniform|rmat|ba|grid|community numberOfNodes edgesPerNode binaryfilename [seed]" << std::endl;
         return 1;
     }
     ofstream myFile;
@@ -20,83 +100,60 @@ int main(int argc, char **argv) {
     myFile << "number of nodes = " << atoi(argv[5]) << std::endl;
     myFile << "processing " << argv[1] << std::endl;
 
-    auto tree = makeGraphFromFile(argv[1]);
+    unsigned long nrOfNodes = strtol(argv[5], nullptr, 10);
+    auto tree = isBinaryEdgeList(argv[1]) ? makeGraphFromBinaryFile(argv[1], nrOfNodes)
+                                          : makeGraphFromFile(argv[1], false, nrOfNodes);
 
     myFile << argv[1] << " has size: " << tree->memoryUsage() << std::endl;
+    myFile << argv[1] << " memory: " << tree->memoryStats() << std::endl;
 
-    Timer timer;
-    double average = 0;
-    unsigned long counter = 0;
-
-    ifstream negEdgesFile(argv[4]);
-    unsigned long from, to;
-    while (negEdgesFile >> from >> to) {
-        timer.start();
-        tree->addEdge(from, to);
-        timer.stop();
-        counter++;
-        average += timer.read();
-    }
-    myFile << argv[1] << " average time to add an edge: " << average/counter << std::endl;
-
-    average = 0;
-    counter = 0;
-    negEdgesFile.clear();
-    negEdgesFile.seekg(0, ios::beg);
-    while (negEdgesFile >> from >> to) {
-        timer.start();
-        tree->removeEdge(from, to);
-        timer.stop();
-        counter++;
-        average += timer.read();
-    }
-    myFile << argv[1] << " average time to delete an edge: " << average/counter << std::endl;
-
-
-    average = 0;
-    counter = 0;
-    negEdgesFile.clear();
-    negEdgesFile.seekg(0, ios::beg);
-    while (negEdgesFile >> from >> to) {
-        timer.start();
-        tree->reportEdge(from, to);
-        timer.stop();
-        counter++;
-        average += timer.read();
-    }
-    myFile << argv[1] << " average time to report 1 negative edge: " << average/counter << std::endl;
-    negEdgesFile.close();
-
-    average = 0;
-    counter = 0;
-    ifstream posEdgesFile(argv[3]);
-    while (posEdgesFile >> from >> to) {
-        timer.start();
-        tree->reportEdge(from, to);
-        timer.stop();
-        counter++;
-        average += timer.read();
-    }
-    myFile << argv[1] <<"average time to report 1 positive edge: " <<  average/counter << std::endl;
-
-    posEdgesFile.close();
+    // Parse the query files up front, so that only the operations are timed
+    auto negEdges = loadEdges(argv[4]);
+    auto posEdges = loadEdges(argv[3]);
 
-
-    unsigned long nrOfNodes = strtol(argv[5], nullptr, 10);
     vector<unsigned long> allNodes(nrOfNodes);
     for(unsigned long i = 0; i < nrOfNodes; i++){
         allNodes[i] = i;
     }
-    average = 0;
-    counter = 0;
-    for(unsigned long i = 0; i < 10; i++){
-        timer.start();
-        tree->reportAllEdges(allNodes, allNodes);
-        timer.stop();
-        counter++;
-        average += timer.read();
+
+    Timer timer;
+    vector<std::pair<string, LatencyHistogram>> results;
+    vector<HotPathCounters> counters;
+
+    // Times `operation` once for every edge, and records the latencies under the given name
+    auto measure = [&](const string &name, const vector<Edge> &edges, const std::function<void(const Edge &)> &operation) {
+        LatencyHistogram histogram;
+        resetHotPathCounters();
+        for (auto &edge : edges) {
+            timer.start();
+            operation(edge);
+            timer.stop();
+            histogram.record(timer.nanoseconds());
+        }
+        results.emplace_back(name, histogram);
+        counters.push_back(hotPathSnapshot());
+    };
+
+    measure("addEdge", negEdges, [&](const Edge &edge) { tree->addEdge(edge.first, edge.second); });
+    measure("removeEdge", negEdges, [&](const Edge &edge) { tree->removeEdge(edge.first, edge.second); });
+    measure("reportNegativeEdge", negEdges, [&](const Edge &edge) { tree->reportEdge(edge.first, edge.second); });
+    measure("reportPositiveEdge", posEdges, [&](const Edge &edge) { tree->reportEdge(edge.first, edge.second); });
+    measure("reportAllEdges", vector<Edge>(10), [&](const Edge &) { tree->reportAllEdges(allNodes, allNodes); });
+
+    for (unsigned long i = 0; i < results.size(); i++) {
+        auto &histogram = results[i].second;
+        myFile << argv[1] << " " << results[i].first << " (ns): mean " << histogram.mean()
+               << ", p50 " << histogram.percentile(50) << ", p90 " << histogram.percentile(90)
+               << ", p99 " << histogram.percentile(99) << ", p99.9 " << histogram.percentile(99.9)
+               << ", max " << histogram.max() << std::endl;
+        if (HOT_PATH_COUNTERS_ENABLED) {
+            myFile << argv[1] << " " << results[i].first << " counters: " << counters[i] << std::endl;
+        }
+    }
+
+    if (argc == 7) {
+        writeResults(argv[6], argv[1], results);
     }
-    myFile << argv[1] <<" average time to report all edges: " <<  average/counter << std::endl;
 
     myFile.close();
     delete tree;
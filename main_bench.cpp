@@ -0,0 +1,4 @@
+#include "benchmark/benchmark.h"
+
+// the benchmarks register themselves from BitVectorBench.cpp, DKTreeBench.cpp and TTreeBench.cpp
+BENCHMARK_MAIN();
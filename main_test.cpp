@@ -1,13 +1,25 @@
 #include "gtest/gtest.h"
 
 #include "LargeGraphTest.cpp"
-#include "MakeGraphFromFile.cpp"
+#include "GraphLoader.h"
 
-#include "DKTree.cpp"
+#include "DKTree.h"
 
 #include "BitVectorTest.cpp"
+#include "CodeSequenceTest.cpp"
 #include "DKTreeTest.cpp"
+#include "DurableDKTreeTest.cpp"
+#include "EdgeListTest.cpp"
+#include "EpochDKTreeTest.cpp"
+#include "GraphGeneratorTest.cpp"
+#include "GraphTraversalTest.cpp"
+#include "K2TripleStoreTest.cpp"
+#include "LatencyHistogramTest.cpp"
+#include "PageRankTest.cpp"
+#include "ShardedDKTreeTest.cpp"
 #include "TTreeTest.cpp"
+#include "TemporalGraphTest.cpp"
+#include "TrianglesTest.cpp"
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,28 @@
+//
+// Created by hugo on 19-2-19.
+//
+
+#ifndef DKTREE_PARAMETERS
+#define DKTREE_PARAMETERS
+
+/// The three main parameters for the TTree and LTree representation
+constexpr unsigned int k = 2; // The `k` in the k2-tree
+constexpr unsigned int BLOCK_SIZE =  k * k; // The number of bits in one block of the bit vector
+constexpr unsigned int B = 256 - BLOCK_SIZE; // The maximum size (in bits) of a leaf bitvector
+
+/// The maximum/minimum number of children/blocks an internal node/leaf node
+/// is allowed to have, as per the rules of the B+tree
+constexpr unsigned int nodeSizeMax = 3;
+constexpr unsigned int nodeSizeMin = (nodeSizeMax + 1) / 2;
+constexpr unsigned int leafSizeMax = B / BLOCK_SIZE;
+constexpr unsigned int leafSizeMin = (leafSizeMax + 1) / 2;
+
+/// The largest k of a single level when the levels of a DKTree have different
+/// arities, so that one block of any level fits in 64 bits
+constexpr unsigned int MAX_LEVEL_K = 8;
+
+/// The size of the leaf submatrices that are stored as codes into a vocabulary
+/// in vocabulary mode, a power of `k` such that one submatrix fits in 64 bits
+constexpr unsigned int VOCABULARY_K = 8;
+
+#endif // DKTREE_PARAMETERS
\ No newline at end of file